@@ -0,0 +1,107 @@
+// Offline batch renderer: warps an image sequence for every warp in a settings file and writes one output
+// sequence per warp, without a GPU. Use it to pre-render content for playback hardware that can not warp in
+// real time.
+//
+// usage: example-batch <settings.xml> <input folder> <output folder> [width height] [frames in flight]
+//
+// The output size defaults to the size of the first input image. Every warp gets its own sub folder in the
+// output folder (0, 1, ...), in the order of the settings file. Frames are processed by a WarpPipeline per warp,
+// all warps run at the same time, so memory is bounded by the number of frames in flight.
+
+#include "ofMain.h"
+#include "Warp.h"
+#include "WarpPipeline.h"
+
+int main( int argc, char *argv[] )
+{
+	if( argc < 4 ) {
+		cout << "usage: " << argv[0] << " <settings.xml> <input folder> <output folder> [width height] [frames in flight]" << endl;
+		return 1;
+	}
+
+	ofInit();
+
+	// paths on the command line are relative to the working directory, not to bin/data
+	ofSetDataPathRoot( ofFilePath::getCurrentWorkingDirectory() );
+
+	WarpList warps = Warp::readSettings( argv[1] );
+	if( warps.empty() ) {
+		cout << "no warps found in " << argv[1] << endl;
+		return 1;
+	}
+
+	// the input sequence, in file name order
+	ofDirectory input( argv[2] );
+	input.allowExt( "png" );
+	input.allowExt( "jpg" );
+	input.allowExt( "tif" );
+	input.listDir();
+	input.sort();
+
+	if( input.size() == 0 ) {
+		cout << "no images found in " << argv[2] << endl;
+		return 1;
+	}
+
+	// the output size defaults to the size of the content
+	int width = 0;
+	int height = 0;
+	if( argc >= 6 ) {
+		width = ofToInt( argv[4] );
+		height = ofToInt( argv[5] );
+	}
+	else {
+		ofPixels first;
+		if( !ofLoadImage( first, input.getPath( 0 ) ) ) {
+			cout << "could not load " << input.getPath( 0 ) << endl;
+			return 1;
+		}
+		width = (int)first.getWidth();
+		height = (int)first.getHeight();
+	}
+
+	WarpPipeline::Settings settings;
+	settings.numFrames = ( argc >= 7 ) ? std::max( 2, ofToInt( argv[6] ) ) : 4;
+	settings.numRemapThreads = std::max( 1u, std::thread::hardware_concurrency() / unsigned( warps.size() ) );
+
+	// run a pipeline for every warp at the same time
+	std::vector<std::unique_ptr<WarpPipeline>> pipelines;
+	for( size_t i = 0; i < warps.size(); ++i ) {
+		WarpRef warp = warps[i];
+		warp->setSize( width, height );
+
+		string folder = ofFilePath::join( argv[3], ofToString( i ) );
+		ofDirectory::createDirectory( folder, false, true );
+
+		WarpPipeline::Source source = [&input]( ofPixels &content, uint64_t index ) {
+			if( index >= input.size() ) return false;
+
+			if( !ofLoadImage( content, input.getPath( (size_t)index ) ) ) {
+				cout << "could not load " << input.getPath( (size_t)index ) << endl;
+				return false;
+			}
+
+			content.setImageType( OF_IMAGE_COLOR_ALPHA );
+			return true;
+		};
+
+		WarpPipeline::Sink sink = [&input, folder]( const ofPixels &output, uint64_t index ) {
+			string name = ofFilePath::removeExt( input.getName( (size_t)index ) ) + ".png";
+			ofSaveImage( output, ofFilePath::join( folder, name ) );
+		};
+
+		pipelines.push_back( std::unique_ptr<WarpPipeline>( new WarpPipeline() ) );
+		pipelines.back()->start( *warp, source, sink, settings );
+	}
+
+	for( size_t i = 0; i < pipelines.size(); ++i ) {
+		pipelines[i]->wait();
+
+		WarpPipeline::Stats stats = pipelines[i]->getStats();
+		cout << "warp " << i << ": " << stats.numFrames << " frames, " << stats.framesPerSecond << " fps"
+			<< " (decode " << stats.busyTime[WarpPipeline::DECODE] << "s, remap " << stats.busyTime[WarpPipeline::REMAP]
+			<< "s, blend " << stats.busyTime[WarpPipeline::BLEND] << "s, output " << stats.busyTime[WarpPipeline::OUTPUT] << "s)" << endl;
+	}
+
+	return 0;
+}
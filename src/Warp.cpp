@@ -21,6 +21,8 @@
  */
 
 #include "Warp.h"
+#include "WarpProfiles.h"
+#include "WarpSettings.h"
 
 Warp::Warp(WarpType type)
 	: mType(type)
@@ -30,7 +32,12 @@ Warp::Warp(WarpType type)
 	, mSaturation(1)
 	, mContrast(1)
 	, mBrightness(1)
+	, mColorMatrix(1.0f)
 	, mSelected(-1) // since this is an unsigned int, actual value will be 'MAX_INTEGER'
+	, mContentVersion(0)
+	, mRenderedVersion(0)
+	, mIsContentDirty(true)
+	, mIsUniformsDirty(true)
 	, mControlsX(2)
 	, mControlsY(2)
 	, mLuminance(0.5f)
@@ -51,9 +58,28 @@ void Warp::draws()
     draw(true);
 }
 
+bool Warp::drawContent(const std::function<void()> &content)
+{
+	if (!isContentDirty()) {
+		// reuse the last rendered content
+		redraw();
+		return false;
+	}
+
+	begin();
+	content();
+	end();
+
+	return true;
+}
+
 void Warp::draw(const ofTexture &texture)
 {
-	draw(texture, ofRectangle(0,0,texture.getWidth(), texture.getHeight()), ofRectangle(getBounds()));
+	// the texture holds all content, only draw our area of it
+	ofRectangle area = getContentArea();
+	float sx = texture.getWidth() / float(mWidth);
+	float sy = texture.getHeight() / float(mHeight);
+	draw(texture, ofRectangle(area.x * sx, area.y * sy, area.width * sx, area.height * sy), ofRectangle(getBounds()));
 }
 
 void Warp::draw(const ofTexture &texture, const ofRectangle &srcArea)
@@ -61,6 +87,17 @@ void Warp::draw(const ofTexture &texture, const ofRectangle &srcArea)
 	draw(texture, srcArea, ofRectangle(getBounds()));
 }
 
+void Warp::draw(const WarpYuv::Textures &frame)
+{
+	if (!frame.isAllocated()) return;
+
+	// like a texture, the frame holds all content
+	ofRectangle area = getContentArea();
+	float sx = frame.y->getWidth() / float(mWidth);
+	float sy = frame.y->getHeight() / float(mHeight);
+	draw(frame, ofRectangle(area.x * sx, area.y * sy, area.width * sx, area.height * sy), ofRectangle(getBounds()));
+}
+
 bool Warp::clip(ofRectangle &srcArea, ofRectangle &destRect) const
 {
 	bool clipped = false;
@@ -118,6 +155,13 @@ bool Warp::clip(ofRectangle &srcArea, ofRectangle &destRect) const
 	return clipped;
 }
 
+std::string Warp::toString(float value)
+{
+	// the shortest representation that reads back as the same float
+	char buffer[32];
+	return std::string(buffer, WarpXmlWriter::format(value, buffer, sizeof(buffer)));
+}
+
 ofXml Warp::toXml() const
 {
 	ofXml xml;
@@ -133,9 +177,9 @@ ofXml Warp::toXml() const
     
 	xml.setAttribute("width", ofToString(mControlsX) );
 	xml.setAttribute("height", ofToString(mControlsY) );
-	xml.setAttribute("brightness", ofToString(mBrightness) );
-    xml.setAttribute("contrast", ofToString(mContrast) );
-    xml.setAttribute("saturation", ofToString(mSaturation) );
+	xml.setAttribute("brightness", toString(mBrightness) );
+    xml.setAttribute("contrast", toString(mContrast) );
+    xml.setAttribute("saturation", toString(mSaturation) );
 
     int index = 0;
 	// add <controlpoint> tags (column-major)
@@ -144,8 +188,8 @@ ofXml Warp::toXml() const
         string s = ofToString(index);
         xml.addChild("controlpoint");
 		xml.setTo("controlpoint["+s+"]");
-		xml.setAttribute("x", ofToString( (*itr).x) );
-		xml.setAttribute("y", ofToString( (*itr).y) );
+		xml.setAttribute("x", toString((*itr).x) );
+		xml.setAttribute("y", toString((*itr).y) );
         xml.setToParent();
         index++;
 	}
@@ -153,7 +197,7 @@ ofXml Warp::toXml() const
 	// add <blend> parameters
     xml.addChild("blend");
 	xml.setTo("blend");
-	xml.setAttribute("exponent", ofToString(mExponent) );
+	xml.setAttribute("exponent", toString(mExponent) );
     if (this->getType() == BILINEAR){
         WarpBilinear* b =  (WarpBilinear*)this;
         xml.setAttribute("resolution", ofToString(b->mResolution));
@@ -163,26 +207,53 @@ ofXml Warp::toXml() const
     
     xml.addChild("edges");
 		xml.setTo("edges");
-		xml.setAttribute("left", ofToString(mEdges.x) );
-		xml.setAttribute("top", ofToString(mEdges.y) );
-		xml.setAttribute("right", ofToString(mEdges.z) );
-		xml.setAttribute("bottom", ofToString(mEdges.w) );
+		xml.setAttribute("left", toString(mEdges.x) );
+		xml.setAttribute("top", toString(mEdges.y) );
+		xml.setAttribute("right", toString(mEdges.z) );
+		xml.setAttribute("bottom", toString(mEdges.w) );
         
     xml.setToParent();
     xml.addChild("gamma");
 		xml.setTo("gamma");
-		xml.setAttribute("red", ofToString(mGamma.x) );
-		xml.setAttribute("green", ofToString(mGamma.y) );
-		xml.setAttribute("blue", ofToString(mGamma.z) );
+		xml.setAttribute("red", toString(mGamma.x) );
+		xml.setAttribute("green", toString(mGamma.y) );
+		xml.setAttribute("blue", toString(mGamma.z) );
 
     xml.setToParent();
     xml.addChild("luminance");
 		xml.setTo("luminance");
-		xml.setAttribute("red", ofToString(mLuminance.x) );
-		xml.setAttribute("green", ofToString(mLuminance.y) );
-		xml.setAttribute("blue", ofToString(mLuminance.z) );
+		xml.setAttribute("red", toString(mLuminance.x) );
+		xml.setAttribute("green", toString(mLuminance.y) );
+		xml.setAttribute("blue", toString(mLuminance.z) );
       
-	xml.setToParent();
+	// back to <warp>, so subclasses add their children next to <blend>
+	xml.setToParent( 2 );
+
+	// add <colormatrix>, a row per output channel
+	if (mColorMatrix != glm::mat3(1.0f)) {
+		xml.addChild("colormatrix");
+		xml.setTo("colormatrix");
+		for (int i = 0; i < 3; ++i) {
+			xml.addChild("row");
+			xml.setTo("row[" + ofToString(i) + "]");
+			xml.setAttribute("red", toString(mColorMatrix[0][i]) );
+			xml.setAttribute("green", toString(mColorMatrix[1][i]) );
+			xml.setAttribute("blue", toString(mColorMatrix[2][i]) );
+			xml.setToParent();
+		}
+		xml.setToParent();
+	}
+
+	// add <content>, the area of the content this warp displays
+	if (!mContentArea.isEmpty()) {
+		xml.addChild("content");
+		xml.setTo("content");
+		xml.setAttribute("x", toString(mContentArea.x) );
+		xml.setAttribute("y", toString(mContentArea.y) );
+		xml.setAttribute("width", toString(mContentArea.width) );
+		xml.setAttribute("height", toString(mContentArea.height) );
+		xml.setToParent();
+	}
 	return xml;
 }
 
@@ -194,6 +265,8 @@ void Warp::fromXml(ofXml &xml)
 	mBrightness = ofToFloat(xml.getAttribute("brightness"));
 	mContrast = ofToFloat(xml.getAttribute("contrast"));
 	mSaturation = ofToFloat(xml.getAttribute("saturation"));
+	mColorMatrix = glm::mat3(1.0f);
+	mContentArea = ofRectangle();
 	
 	// load control points
 	mPoints.clear();
@@ -245,12 +318,96 @@ void Warp::fromXml(ofXml &xml)
 				xml.setToParent();
 			}
         }
+
+		if (xml.getName() == "colormatrix") {
+			int rows = xml.getNumChildren();
+			for (int j = 0; j < rows && j < 3; j++) {
+				xml.setToChild(j);
+				mColorMatrix[0][j] = ofToFloat(xml.getAttribute("red"));
+				mColorMatrix[1][j] = ofToFloat(xml.getAttribute("green"));
+				mColorMatrix[2][j] = ofToFloat(xml.getAttribute("blue"));
+				xml.setToParent();
+			}
+		}
+
+		// the warp may not have its size yet, setSize() fits the area to the content
+		if (xml.getName() == "content") {
+			mContentArea.set( ofToFloat(xml.getAttribute("x")), ofToFloat(xml.getAttribute("y")),
+				ofToFloat(xml.getAttribute("width")), ofToFloat(xml.getAttribute("height")) );
+		}
        
         xml.setToParent();
     }
     
 	// reconstruct warp
 	mIsDirty = true;
+	mIsUniformsDirty = true;
+}
+
+void Warp::writeXml(WarpXmlWriter &writer) const
+{
+	// the same layout as the binary settings and settings snapshots
+	WarpSettings::Block block;
+	WarpSettings::toBlock(*this, block);
+	WarpSettings::writeXml(block, mPoints.data(), writer);
+}
+
+void Warp::readXml(std::string_view name, unsigned index, const WarpXmlReader::Attributes &attributes)
+{
+	if (name == "warp") {
+		mControlsX = attributes.getInt("width");
+		mControlsY = attributes.getInt("height");
+
+		mBrightness = attributes.getFloat("brightness");
+		mContrast = attributes.getFloat("contrast");
+		mSaturation = attributes.getFloat("saturation");
+		mColorMatrix = glm::mat3(1.0f);
+		mContentArea = ofRectangle();
+
+		mPoints.clear();
+
+		// reconstruct warp
+		mIsDirty = true;
+		mIsUniformsDirty = true;
+	}
+	else if (name == "controlpoint") {
+		mPoints.push_back(glm::vec2(attributes.getFloat("x"), attributes.getFloat("y")));
+	}
+	else if (name == "blend") {
+		mExponent = attributes.getFloat("exponent");
+
+		if (mType == BILINEAR) {
+			WarpBilinear* b = (WarpBilinear*)this;
+			b->mResolution = attributes.getInt("resolution");
+			b->mIsLinear = attributes.getBool("linear");
+			b->mIsAdaptive = attributes.getBool("adaptive");
+		}
+	}
+	else if (name == "edges") {
+		mEdges.x = attributes.getFloat("left");
+		mEdges.y = attributes.getFloat("top");
+		mEdges.z = attributes.getFloat("right");
+		mEdges.w = attributes.getFloat("bottom");
+	}
+	else if (name == "gamma") {
+		mGamma.x = attributes.getFloat("red");
+		mGamma.y = attributes.getFloat("green");
+		mGamma.z = attributes.getFloat("blue");
+	}
+	else if (name == "luminance") {
+		mLuminance.x = attributes.getFloat("red");
+		mLuminance.y = attributes.getFloat("green");
+		mLuminance.z = attributes.getFloat("blue");
+	}
+	else if (name == "content") {
+		// the warp may not have its size yet, setSize() fits the area to the content
+		mContentArea.set(attributes.getFloat("x"), attributes.getFloat("y"), attributes.getFloat("width"), attributes.getFloat("height"));
+	}
+	else if (name == "row" && index < 3) {
+		mColorMatrix[0][index] = attributes.getFloat("red");
+		mColorMatrix[1][index] = attributes.getFloat("green");
+		mColorMatrix[2][index] = attributes.getFloat("blue");
+	}
 }
 
 void Warp::setSize(int w, int h)
@@ -259,6 +416,44 @@ void Warp::setSize(int w, int h)
 	mHeight = h;
     mWindowSize = ofVec2f(float(w), float(h));
 	mIsDirty = true;
+	mIsContentDirty = true;
+	mIsUniformsDirty = true;
+
+	// keep the content area within the content
+	if( !mContentArea.isEmpty() )
+		setContentArea( mContentArea );
+}
+
+void Warp::setContentArea(const ofRectangle &area)
+{
+	// snap to whole pixels within the content
+	ofRectangle bounds = area.getIntersection( getBounds() );
+	float left = std::floor( bounds.getLeft() );
+	float top = std::floor( bounds.getTop() );
+	ofRectangle snapped( left, top, std::ceil( bounds.getRight() ) - left, std::ceil( bounds.getBottom() ) - top );
+
+	// an area covering all content is the same as no area
+	if( snapped.width <= 0 || snapped.height <= 0 || snapped == getBounds() )
+		snapped = ofRectangle();
+
+	if( snapped == mContentArea ) return;
+
+	mContentArea = snapped;
+	mIsContentDirty = true;
+	mIsUniformsDirty = true;
+}
+
+WarpBlendMask::Settings Warp::getBlendSettings() const
+{
+	WarpBlendMask::Settings blend;
+	blend.width = mWidth;
+	blend.height = mHeight;
+	blend.edges = mEdges;
+	blend.exponent = mExponent;
+	blend.luminance = mLuminance;
+	blend.gamma = mGamma;
+
+	return blend;
 }
 
 glm::vec2 Warp::getControlPoint(unsigned index) const
@@ -361,86 +556,26 @@ void Warp::setSize(const WarpList &warps, int w, int h)
 
 WarpList Warp::readSettings(const string source) // FIX Datasource Ref
 {
-	ofXml		doc;
-	WarpList	warps;
-
-	// try to load the specified xml file
-    try { doc.load(source); }
-	catch (...) { return warps; }
-
-	// check if this is a valid file
-	//bool isWarp = doc.exists("warpconfig");
-    
-    
-	//if (!isWarp)
-    //    return warps;
+	// read the active profile, or the first one if the file does not name it
+	std::vector<WarpProfiles::Profile> profiles;
+	std::string active;
+	if (!WarpProfiles::read(source, profiles, active, true))
+		return WarpList();
 
-	//
-	//if (isWarp) {
-		// get first profile
- 
-    
-    doc.setToChild(0);
-    int mapChilden = doc.getNumChildren();
-    
-    for(int i=0; i<mapChilden; i++){
-        doc.setToChild(i); //map
-        doc.setToChild(0); //warp
+	for (auto &profile : profiles) {
+		if (profile.name == active) return profile.warps;
+	}
 
-        string method = doc.getAttribute("method");
-        
-        if (method == "bilinear") {
-            WarpBilinearRef warp(new WarpBilinear());
-            warp->fromXml(doc);
-            warps.push_back(warp);
-        }
-        else if (method == "perspective") {
-            WarpPerspectiveRef warp(new WarpPerspective());
-            warp->fromXml(doc);
-            warps.push_back(warp);
-        }
-        else if (method == "perspectivebilinear") {
-            WarpPerspectiveBilinearRef warp(new WarpPerspectiveBilinear());
-            warp->fromXml(doc);
-            warps.push_back(warp);
-        }
-        
-        doc.setToParent(2);
-    }
-    
-	return warps;
+	return profiles.empty() ? WarpList() : profiles[0].warps;
 }
 
 void Warp::writeSettings(const WarpList &warps, string &target)
 {
-    // create config document and root <warpconfig>
-    ofXml doc;
-    doc.addChild("warpconfig");
-    doc.setTo("warpconfig");
-    doc.setAttribute("version", "1.0");
-    doc.setAttribute("profile", "default");
-    
-	// create default <profile> (profiles are not yet supported)
-    doc.addChild("profile");
-	doc.setTo("profile");
-	doc.setAttribute("name", "default");
-
-	// 
-	for (unsigned i = 0; i < warps.size(); i++) {
-		// create <map>
-        doc.addChild("map");
-        doc.setToChild(i);
-		doc.setAttribute("id", ofToString(i + 1) );
-		doc.setAttribute("display", ofToString(1) );	// not supported yet
-
-		// create <warp>
-        ofXml xml = warps[i]->toXml();
-        doc.addXml(xml, true);
-        doc.setToParent();
-	}
-    
-	// write file
-	doc.save(target);
+	WarpSettings::Snapshot snapshot;
+	WarpSettings::takeSnapshot(warps, snapshot);
+
+	// replace the profile readSettings reads, the other profiles in the file are kept
+	WarpProfiles::write(target, "", snapshot);
 }
 
 bool Warp::handleMouseMove(WarpList &warps, ofMouseEventArgs &event)
@@ -602,10 +737,12 @@ void Warp::keyDown(ofKeyEventArgs &event)
 	case 45: //-
 		if (mSelected >= mPoints.size()) return;
 		mBrightness = std::max(0.0f, mBrightness - 0.01f);
+		mIsUniformsDirty = true;
 		break;
 	case 43: //+
 		if (mSelected >= mPoints.size()) return;
 		mBrightness = std::min(1.0f, mBrightness + 0.01f);
+		mIsUniformsDirty = true;
 		break;
 	case 114: //r
 		if (mSelected >= mPoints.size()) return;
@@ -666,3 +803,30 @@ void Warp::drawControlPoints()
     }
 	ofSetColor(255);
 }
+
+void Warp::beginContentRegion()
+{
+	// content is drawn in its own coordinate space
+	ofPushView();
+	ofViewport( mContentRegion, false );
+	ofSetupScreenOrtho( mContentRegion.getWidth(), mContentRegion.getHeight() );
+
+	// only clear our own region, other warps share the frame buffer
+	glEnable( GL_SCISSOR_TEST );
+	glScissor( (GLint)mContentRegion.x, (GLint)mContentRegion.y, (GLsizei)mContentRegion.width, (GLsizei)mContentRegion.height );
+	ofClear( 255 );
+	glDisable( GL_SCISSOR_TEST );
+
+	beginContentArea();
+}
+
+void Warp::beginContentArea()
+{
+	if( !mContentArea.isEmpty() )
+		ofTranslate( -mContentArea.x, -mContentArea.y );
+}
+
+void Warp::endContentRegion()
+{
+	ofPopView();
+}
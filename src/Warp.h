@@ -25,6 +25,12 @@ along with ofxWarping.  If not, see <http://www.gnu.org/licenses/>.
 #include <atomic>
 #include <vector>
 #include "glm/glm.hpp"
+#include "WarpBlendMask.h"
+#include "WarpColorLut.h"
+#include "WarpShaderCache.h"
+#include "WarpUniformBlock.h"
+#include "WarpXml.h"
+#include "WarpYuv.h"
 
 typedef std::shared_ptr<class Warp>			WarpRef;
 typedef std::vector<WarpRef>				WarpList;
@@ -41,7 +47,7 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		virtual ~Warp(void);
     
 		//!
-		bool				isEditModeEnabled() { return (bool)sIsEditMode; };
+		bool				isEditModeEnabled() const { return (bool)sIsEditMode; };
 		void				enableEditMode(bool enabled = true) { sIsEditMode = enabled; };
 		void				disableEditMode() { sIsEditMode = false; };
 		void				toggleEditMode() { sIsEditMode = !sIsEditMode; };
@@ -56,6 +62,10 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		virtual ofXml		toXml() const;
 		//!
 		virtual void		fromXml(ofXml &xml);
+		//! writes the attributes and children of the <warp> element to a streaming writer
+		virtual void		writeXml(WarpXmlWriter &writer) const;
+		//! reads the <warp> element or one of its descendants from a streaming reader, index counts the preceding elements with the same name
+		virtual void		readXml(std::string_view name, unsigned index, const WarpXmlReader::Attributes &attributes);
 
 		//! get the width of the content in pixels
 		int					getWidth() const { return mWidth; };
@@ -65,6 +75,8 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		glm::vec2				getSize() const { return glm::vec2(mWidth, mHeight); };
 		//! get the width and height of the content in pixels
 		ofRectangle			getBounds() const { return ofRectangle(0, 0, mWidth, mHeight); };
+		//! get the width and height of the output in pixels, the space the control points are scaled to and getMesh() returns
+		glm::vec2				getWindowSize() const { return mWindowSize; };
 
 		//! set the width of the content in pixels
 		virtual void		setWidth(int w) { setSize(w, mHeight); }
@@ -75,24 +87,30 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		//! set the width and height of the content in pixels
 		virtual void		setSize(int w, int h);
 
+		//! set the area of the content this warp displays, in content pixels. Only this area is allocated and rendered,
+		//! so a warp showing part of a large canvas doesn't pay for the rest of it. An empty area displays all content (default).
+		virtual void		setContentArea(const ofRectangle &area);
+		//! returns the area of the content this warp displays, in content pixels
+		ofRectangle			getContentArea() const { return mContentArea.isEmpty() ? getBounds() : mContentArea; }
+
 		//! returns the luminance value for the red, green and blue channels, used for edge blending (0.5 = linear)
 		virtual const ofVec3f& getLuminance() const { return mLuminance; }
 		//! set the luminance value for all color channels, used for edge blending (0.5 = linear)
-		virtual void		setLuminance(float gamma) { mLuminance = ofVec3f(gamma); }
+		virtual void		setLuminance(float gamma) { mLuminance = ofVec3f(gamma); markUniformsDirty(); }
 		//! set the luminance value for the red, green and blue channels, used for edge blending (0.5 = linear)
-		virtual void		setLuminance(float red, float green, float blue) { mLuminance.x = red; mLuminance.y = green; mLuminance.z = blue; }
+		virtual void		setLuminance(float red, float green, float blue) { mLuminance.x = red; mLuminance.y = green; mLuminance.z = blue; markUniformsDirty(); }
 
 		//! returns the gamma curve value for the red, green and blue channels
 		virtual const ofVec3f& getGamma() const { return mGamma; }
 		//! set the gamma curve value for all color channels
-		virtual void		setGamma(float gamma) { mGamma = ofVec3f(gamma); }
+		virtual void		setGamma(float gamma) { mGamma = ofVec3f(gamma); markUniformsDirty(); }
 		//! set the gamma curve value for the red, green and blue channels
-		virtual void		setGamma(float red, float green, float blue) { mGamma.x = red; mGamma.y = green; mGamma.z = blue; }
+		virtual void		setGamma(float red, float green, float blue) { mGamma.x = red; mGamma.y = green; mGamma.z = blue; markUniformsDirty(); }
 
 		//! returns the edge blending curve exponent (1.0 = linear, 2.0 = quadratic)
 		virtual float		getExponent() const { return mExponent; }
 		//! set the edge blending curve exponent  (1.0 = linear, 2.0 = quadratic)
-		virtual void		setExponent(float e) { mExponent = ofClamp(e, 1.0f, 100.0f); }
+		virtual void		setExponent(float e) { mExponent = ofClamp(e, 1.0f, 100.0f); markUniformsDirty(); }
 
 		//! returns the edge blending area for the left, top, right and bottom edges (values between 0 and 1)
 		virtual ofVec3f	getEdges() const { return 2.0f * mEdges; }
@@ -103,6 +121,7 @@ class Warp : public std::enable_shared_from_this <Warp> {
 			mEdges.y = ofClamp(top * 0.5f, 0.0f, 1.0f);
 			mEdges.z = ofClamp(right * 0.5f, 0.0f, 1.0f);
 			mEdges.w = ofClamp(bottom * 0.5f, 0.0f, 1.0f);
+			markUniformsDirty();
 		}
 		//! set the edge blending area for the left, top, right and bottom edges (values between 0 and 1)
 		virtual void		setEdges(const ofVec4f &edges)
@@ -111,17 +130,30 @@ class Warp : public std::enable_shared_from_this <Warp> {
 			mEdges.y = ofClamp(edges.y * 0.5f, 0.0f, 1.0f);
 			mEdges.z = ofClamp(edges.z * 0.5f, 0.0f, 1.0f);
 			mEdges.w = ofClamp(edges.w * 0.5f, 0.0f, 1.0f);
+			markUniformsDirty();
 		}
+        //! returns the brightness (values between 0 and 1)
+        virtual float       getBrightness() const { return mBrightness; }
         //! set the brighntess (values between 0 and 1)
-        virtual void        setBrightness(float b){ mBrightness = b; }
+        virtual void        setBrightness(float b){ mBrightness = b; markUniformsDirty(); }
+        //! returns the contrast (values between 0 and 1)
+        virtual float       getContrast() const { return mContrast; }
         //! set the contrast (values between 0 and 1)
-        virtual void        setContrast(float b){ mContrast = b; }
+        virtual void        setContrast(float b){ mContrast = b; markUniformsDirty(); }
+        //! returns the saturation (values between 0 and 1)
+        virtual float       getSaturation() const { return mSaturation; }
         //! set the saturation (values between 0 and 1)
-        virtual void        setSaturation(float b){ mSaturation = b; }
-        //! set the color lut texture reference
-        virtual void        setLutTexture(ofTexture& b){ lutTexture = b; sUseColorLut = true; }
-		//! set the blend lut texture reference
-		virtual void        setBlendTexture(ofTexture& b) { blendTexture = b; }
+        virtual void        setSaturation(float b){ mSaturation = b; markUniformsDirty(); }
+        //! returns the color matrix used for projector matching
+        const glm::mat3&    getColorMatrix() const { return mColorMatrix; }
+        //! set the color matrix used for projector matching, applied after brightness, contrast and saturation
+        virtual void        setColorMatrix(const glm::mat3 &m){ mColorMatrix = m; markUniformsDirty(); }
+        //! returns whether a color lut texture has been assigned
+        bool                isColorLutEnabled() const { return sUseColorLut; }
+        //! set the color lut texture reference, call again when its contents have changed
+        virtual void        setLutTexture(ofTexture& b){ lutTexture = b; sUseColorLut = true; markLutDirty(); }
+		//! set the blend lut texture reference, call again when its contents have changed
+		virtual void        setBlendTexture(ofTexture& b) { blendTexture = b; markBlendDirty(); }
 		//! toggle mapping linear or curve (default)
 		virtual void				toggleMappingMode() { }
 
@@ -132,6 +164,21 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		virtual void		begin() = 0;
 		//! restore the warp after drawing
 		virtual void		end() = 0;
+		//! draws the warp with the content that was last rendered between begin() and end()
+		virtual void		redraw() = 0;
+
+		//! returns the version of the content
+		uint64_t			getContentVersion() const { return mContentVersion; }
+		//! set the version of the content, it is only rendered again if the version differs from the last rendered one
+		void				setContentVersion(uint64_t version) { mContentVersion = version; }
+		//! increments the version of the content
+		void				bumpContentVersion() { mContentVersion++; }
+		//! forces the content to be rendered again
+		void				markContentDirty() { mIsContentDirty = true; }
+		//! returns whether the content has to be rendered, false if the last rendered content can be reused
+		bool				isContentDirty() const { return mIsContentDirty || mContentVersion != mRenderedVersion; }
+		//! renders the content between begin() and end() if it has changed, otherwise redraws the last rendered content. Returns true if the content was rendered.
+		bool				drawContent(const std::function<void()> &content);
     
     
         virtual void		bind() = 0;
@@ -148,10 +195,33 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		void				draw(const ofTexture &texture, const ofRectangle &srcArea);
 		//! draws a specific area of a warped texture to a specific region
 		virtual void		draw(const ofTexture &texture, const ofRectangle &srcArea, const ofRectangle &destRect) = 0;
+		//! draws a warped YUV video frame, which is converted to RGB by the warp shader
+		void				draw(const WarpYuv::Textures &frame);
+		//! draws a specific area of a warped YUV video frame to a specific region, the area is specified in luma pixels
+		virtual void		draw(const WarpYuv::Textures &frame, const ofRectangle &srcArea, const ofRectangle &destRect) = 0;
 
 		//! adjusts both the source area and destination rectangle so that they are clipped against the warp's content
 		bool				clip(ofRectangle &srcArea, ofRectangle &destRect) const;
 
+		//! render the content into a region of a shared frame buffer instead of a frame buffer of its own, used by WarpAtlas
+		virtual void		setContentFbo(const shared_ptr<ofFbo> &fbo, const ofRectangle &region) = 0;
+
+		//! returns the warp as an indexed triangle mesh in output pixels, generated on the CPU. The z coordinate of each vertex
+		//! holds its projective q coordinate for perspective correct interpolation, texture coordinates are normalized to the content area.
+		virtual void		getMesh(ofMesh &mesh) = 0;
+		//! does the CPU work of the next draw ahead of time, like tessellating the mesh and baking the blend mask.
+		//! Does not use GL, so it can be called from another thread as long as the warp is not drawn at the same time.
+		virtual void		prepare() {}
+		//! returns the region of the shared frame buffer the content is rendered into, empty if the warp has its own frame buffer
+		const ofRectangle&	getContentRegion() const { return mContentRegion; }
+
+		//! returns the uniform block holding the shader parameters of this warp
+		const WarpUniformBlock&	getUniforms() const { return mUniforms; }
+		//! resets the uniform upload counter, e.g. at the start of every frame
+		void				resetNumUniformUploads() { mUniforms.resetNumUploads(); }
+		//! returns the number of uniform uploads since the last reset
+		int					getNumUniformUploads() const { return mUniforms.getNumUploads(); }
+
 		//! returns the coordinates of the specified control point
 		virtual glm::vec2		getControlPoint(unsigned index) const;
 		//! sets the coordinates of the specified control point
@@ -180,8 +250,10 @@ class Warp : public std::enable_shared_from_this <Warp> {
 
 		//! read a settings xml file and pass back a vector of Warps
 		static WarpList		readSettings(const string source);
-		//! write a settings xml file
+		//! write a settings xml file, replacing the profile readSettings reads and keeping the others
 		static void			writeSettings(const WarpList &warps, string &target);
+		//! formats a float for the settings xml, without losing precision
+		static std::string	toString(float value);
 
 		//! handles mouseMove events for multiple warps
 		static bool			handleMouseMove(WarpList &warps, ofMouseEventArgs &event);
@@ -214,12 +286,35 @@ class Warp : public std::enable_shared_from_this <Warp> {
         inline ofMatrix4x4 toOf(const glm::mat4 &_m) {
             return ofMatrix4x4(&_m[0][0]);
         }
+
+		//! allow WarpRenderer to access the mesh and blend parameters
+		friend class WarpRenderer;
+		//! allow WarpRemap to access the blend parameters
+		friend class WarpRemap;
+		//! allow WarpSettings to read and write all settings
+		friend class WarpSettings;
     
 	protected:
 		//! draw the warp and its editing interface
 		virtual void		draw(bool controls = true) = 0;
 		//! draw the control points
 		void				drawControlPoints();
+		//! restricts drawing and clearing to the content region of a shared frame buffer
+		void				beginContentRegion();
+		//! offsets drawing so the content area lands at the origin of the frame buffer
+		void				beginContentArea();
+		//! restores the view after drawing into the content region
+		void				endContentRegion();
+		//! marks the content of the current version as rendered
+		void				setContentRendered() { mRenderedVersion = mContentVersion; mIsContentDirty = false; }
+		//! marks the shader parameters as changed, so they are written to the uniform block on the next draw
+		void				markUniformsDirty() { mIsUniformsDirty = true; }
+		//! marks the blend mask as changed, so it is baked again on the next draw
+		void				markBlendDirty() { mBlendMask.markDirty(); }
+		//! marks the color lut as changed, so it is built again on the next draw
+		virtual void		markLutDirty() {}
+		//! returns the parameters of the blend mask
+		WarpBlendMask::Settings	getBlendSettings() const;
 
 	protected:
 		WarpType		mType;
@@ -233,11 +328,29 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		float			mBrightness;
         float           mContrast;
         float           mSaturation;
+        glm::mat3       mColorMatrix;
         ofTexture&      lutTexture = (*new ofTexture());
 		ofTexture&      blendTexture = (*new ofTexture());
 
 		unsigned		mSelected;
 
+		//! area of the content displayed by this warp, empty if all content is displayed
+		ofRectangle		mContentArea;
+		//! region of a shared frame buffer the content is rendered into
+		ofRectangle		mContentRegion;
+
+		//! version of the content, as set by the user
+		uint64_t		mContentVersion;
+		//! version of the content that was last rendered
+		uint64_t		mRenderedVersion;
+		//! set if the frame buffer has changed or the content was explicitly marked dirty
+		bool			mIsContentDirty;
+
+		//! shader parameters, uploaded only when they have changed
+		WarpUniformBlock	mUniforms;
+		//! set by the setters if a shader parameter has changed
+		bool			mIsUniformsDirty;
+
 		//! Determines the number of horizontal and vertical control points
 		int				mControlsX;
 		int				mControlsY;
@@ -249,6 +362,8 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		ofVec3f			mGamma;
 		ofVec4f			mEdges;
 		float			mExponent;
+		//! edge blending curve or user-supplied blend texture, baked into a texture
+		WarpBlendMask	mBlendMask;
 
 		//! time of last control point selection
 		double				mSelectedTime;
@@ -304,9 +419,17 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		virtual void		fromXml(ofXml &xml) override;
 
 		//! set the width and height of the content in pixels
-		void				setSize(int w, int h) override { Warp::setSize(w, h); if (mFbo) mFbo->clear(); }
+		void				setSize(int w, int h) override { Warp::setSize(w, h); releaseFbo(); }
 		//! set the frame buffer format, so you have control over its quality settings
-		void				setFormat(const ofFbo::Settings &format) { mFboFormat = format; mFbo->clear();  }
+		void				setFormat(const ofFbo::Settings &format) { mFboFormat = format; releaseFbo(); mIsContentDirty = true; }
+		//! render the content into a region of a shared frame buffer
+		void				setContentFbo(const shared_ptr<ofFbo> &fbo, const ofRectangle &region) override;
+		//! set the area of the content this warp displays, reallocates the frame buffer if its size changes
+		void				setContentArea(const ofRectangle &area) override;
+		//! returns the warp mesh in output pixels
+		void				getMesh(ofMesh &mesh) override;
+		//! tessellates the mesh and bakes the blend mask
+		void				prepare() override;
 		//!
 		void				setLinear(bool enabled = true) { mIsLinear = enabled; mIsDirty = true; };
 		void				setCurved(bool enabled = true) { mIsLinear = !enabled; mIsDirty = true; };
@@ -318,12 +441,16 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		virtual void		begin() override;
 		//! restore the warp after drawing
 		virtual void		end() override;
+		//! draws the warp with the content that was last rendered
+		virtual void		redraw() override;
             
             virtual void bind() override;
             virtual void unbind() override;
 
-		//! draws a warped texture
+		//! draws a warped texture. The texture is sampled directly through the warp mesh, without copying it into the frame buffer.
 		virtual void		draw(const ofTexture &texture, const ofRectangle &srcArea, const ofRectangle &destRect) override;
+		//! draws a warped YUV video frame, the planes are sampled directly through the warp mesh
+		virtual void		draw(const WarpYuv::Textures &frame, const ofRectangle &srcArea, const ofRectangle &destRect) override;
 
 		//! set the number of horizontal control points for this warp 
 		void				setNumControlX(int n);
@@ -333,23 +460,41 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		void				setTexCoords(float x1, float y1, float x2, float y2);
 
 		virtual void		keyDown(ofKeyEventArgs &event) override;
+
+		//! returns the shader variants compiled for this warp
+		const WarpShaderCache&	getShaderCache() const { return mShaders; }
+
+		//! allow WarpRenderer to access the mesh
+		friend class WarpRenderer;
 	protected:
 		//! draws the warp as a mesh, allowing you to use your own texture instead of the FBO
 		virtual void		draw(bool controls = true) override;
-		//! Creates the shader that renders the content with a wireframe overlay
+		//! Sets the source of the shader that renders the content with a wireframe overlay
 		void				createShader();
+		//! Returns the shader features needed to draw a texture of the specified target, see WarpShaderCache::Feature
+		unsigned			getShaderFeatures(GLenum textureTarget) const;
+		//! Returns the parameters of the color lut
+		WarpColorLut::Settings	getColorSettings() const;
+		//! marks the color lut as changed, so it is built again on the next draw
+		void				markLutDirty() override { mColorLut.markDirty(); }
 		//! Creates the frame buffer object and updates the vertex buffer object if necessary
 		void				createBuffers();
 		//! Creates the vertex buffer object
 		void				createMesh(int resolutionX = 36, int resolutionY = 36);
 		//! Updates the vertex buffer object based on the control points
 		void				updateMesh();
+		//! Creates and updates the mesh if necessary, returns true if the mesh has changed
+		virtual bool		updateBuffers();
+		//! Returns the mesh vertex for a point in warped space. The z coordinate holds the projective q coordinate.
+		virtual glm::vec3	projectVertex(const glm::vec2 &p) const { return glm::vec3(p.x, p.y, 1.0f); }
 		//!	Returns the specified control point. Values for col and row are clamped to prevent errors.
 		glm::vec2				getPoint(int col, int row) const;
 		//! Performs fast Catmull-Rom interpolation, returns the interpolated value at t
 		glm::vec2				cubicInterpolate(const std::vector<glm::vec2> &knots, float t) const;
 		//!
 		ofRectangle			getMeshBounds() const;
+		//! clears the frame buffer, or detaches from the shared frame buffer so a new one will be created
+		void				releaseFbo();
 	private:
 		//! Greatest common divisor using Euclidian algorithm (from: http://en.wikipedia.org/wiki/Greatest_common_divisor)
 		inline int			gcd(int a, int b) const { if (b == 0) return a; else return gcd(b, a%b); };
@@ -360,6 +505,14 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		ofFbo::Settings						mFboFormat;
 		shared_ptr<ofVboMesh>				mVboMesh;
 		shared_ptr<ofShader>				mShader;
+		//! shader variants, compiled on demand
+		WarpShaderCache						mShaders;
+		//! texture drawn instead of the frame buffer, only set while drawing a texture
+		const ofTexture*					mSource;
+		//! region of the texture that is drawn, in pixels
+		ofRectangle							mSourceRegion;
+		//! planes of the video frame drawn instead of the frame buffer, mSource is its luma plane
+		const WarpYuv::Textures*			mSourceYuv;
 
 		//! linear or curved interpolation
 		bool					mIsLinear;
@@ -375,6 +528,12 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		//! Determines the number of horizontal and vertical quads 
 		int						mResolutionX;
 		int						mResolutionY;
+
+		//! Incremented every time the mesh is updated
+		unsigned				mMeshRevision;
+
+		//! color pipeline, compiled into a 3D lut
+		WarpColorLut			mColorLut;
 	};
 
 	// ----------------------------------------------------------------------------------------------------------------
@@ -405,6 +564,8 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		void			begin() override;
 		//! restore the warp after drawing
 		void			end() override;
+		//! draws the warp with the content that was last rendered
+		void			redraw() override;
             
             void			bind() override;
             void			unbind() override;
@@ -412,12 +573,30 @@ class Warp : public std::enable_shared_from_this <Warp> {
 
 		//! draws a warped texture
 		void			draw(const ofTexture &texture, const ofRectangle &srcArea, const ofRectangle &destRect) override;
+		//! draws a warped YUV video frame
+		void			draw(const WarpYuv::Textures &frame, const ofRectangle &srcArea, const ofRectangle &destRect) override;
+
+		//! set the width and height of the content in pixels
+		void			setSize(int w, int h) override;
+		//! render the content into a region of a shared frame buffer
+		void			setContentFbo(const shared_ptr<ofFbo> &fbo, const ofRectangle &region) override;
+		//! set the area of the content this warp displays, releases a shared frame buffer region that no longer fits
+		void			setContentArea(const ofRectangle &area) override;
+		//! returns the transformed quad in output pixels
+		void			getMesh(ofMesh &mesh) override;
+		//! bakes the blend mask
+		void			prepare() override;
 
 		//! override keyDown method to add additional key handling
 		void			keyDown(ofKeyEventArgs &event) override;
 
+		//! returns the shader variants compiled for this warp
+		const WarpShaderCache&	getShaderCache() const { return mShaders; }
+
 		//! allow WarpPerspectiveBilinear to access the protected class members
 		friend class WarpPerspectiveBilinear;
+		//! allow WarpRenderer to access the transform
+		friend class WarpRenderer;
 	protected:
 		//!
 		void	draw(bool controls = true) override;
@@ -427,8 +606,10 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		//! helper function
 		void gaussianElimination(float * input, int n) const;
 
-		//!
+		//! Sets the source of the shader that applies the transform and edge blending
 		void createShader();
+		//! Returns the shader features needed to draw a texture of the specified target, see WarpShaderCache::Feature
+		unsigned getShaderFeatures(GLenum textureTarget) const;
 
 	protected:
 		glm::vec2		mSource[4];
@@ -438,6 +619,15 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		glm::mat4x4	mInverted;
 
 		shared_ptr<ofShader>	mShader;
+		//! shader variants, compiled on demand
+		WarpShaderCache			mShaders;
+
+		//! content rendered between begin() and end()
+		shared_ptr<ofFbo>		mFbo;
+		//! textured quad, transformed by the shader
+		ofMesh					mMesh;
+		//! planes of the video frame being drawn, if any
+		const WarpYuv::Textures	*mSourceYuv;
 	};
 
 	// ----------------------------------------------------------------------------------------------------------------
@@ -461,6 +651,8 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		ofXml	toXml() const override;
 		//!
 		void		fromXml(ofXml &xml) override;
+		//! reads the settings and the <corner> elements
+		void		readXml(std::string_view name, unsigned index, const WarpXmlReader::Attributes &attributes) override;
 
 		void		mouseMove(ofMouseEventArgs &event) override;
 		void		mouseDown(ofMouseEventArgs &event) override;
@@ -470,6 +662,9 @@ class Warp : public std::enable_shared_from_this <Warp> {
 
 		void		resize() override;
 
+		//! reset control points to undistorted image
+		void		reset() override;
+
 		//! set the width and height of the content in pixels
 		void		setSize(int w, int h) override;
 
@@ -483,15 +678,47 @@ class Warp : public std::enable_shared_from_this <Warp> {
 		void		selectControlPoint(unsigned index) override;
 		//! deselect the selected control point
 		void		deselectControlPoint() override;
+
+		//! returns whether the perspective transform is baked into the mesh vertices instead of using the matrix stack
+		bool		isTransformBaked() const { return mIsTransformBaked; }
+		//! bake the perspective transform into the mesh vertices, so the warp renders without fixed-function matrix state
+		void		setTransformBaked(bool enabled = true) { mIsTransformBaked = enabled; mIsDirty = true; }
+
+		//! returns the warp mesh in output pixels, with the perspective transform applied
+		void		getMesh(ofMesh &mesh) override;
+
+		//! allow WarpRenderer to access the transform
+		friend class WarpRenderer;
+		//! allow WarpSettings to read and write the corners
+		friend class WarpSettings;
 	protected:
 		//! 
 		void		draw(bool controls = true) override;
+		//! also regenerates the mesh if the corners have moved and the transform is baked into the mesh
+		bool		updateBuffers() override;
+		//! applies the perspective transform to the mesh vertex when it is baked into the mesh
+		glm::vec3	projectVertex(const glm::vec2 &p) const override;
 
 		//! returns whether or not the control point is one of the 4 corners and should be treated as a perspective control point
 		bool		isCorner(unsigned index) const;
 		//! converts the control point index to the appropriate perspective warp index
 		unsigned	convertIndex(unsigned index) const;
 
+		//! returns the perspective transform, invalidating the screen space control points if the corners have moved
+		glm::mat4x4	getTransform() const;
+		//! re-projects the control points to normalized screen space if the corners or the bilinear points have changed
+		void		updateScreenPoints() const;
+
 	protected:
 		WarpPerspectiveRef	mWarp;
+
+		//! cached control points in normalized screen space
+		mutable std::vector<glm::vec2>	mScreenPoints;
+		//! set when the bilinear control points have changed since the cache was built
+		mutable bool					mIsScreenDirty;
+
+		//! apply the perspective transform during vertex generation
+		bool							mIsTransformBaked;
+		//! the perspective transform that has been applied to the mesh
+		glm::mat4x4						mBakedTransform;
 	};
\ No newline at end of file
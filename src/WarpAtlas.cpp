@@ -0,0 +1,226 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarpAtlas.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+	//! a horizontal segment of the skyline of a page
+	typedef struct Segment {
+		int x, y, width;
+	} Segment;
+
+	//! finds the lowest position for a rectangle on the skyline, returns false if it does not fit
+	bool findPosition( const std::vector<Segment> &skyline, int width, int height, int pageWidth, int pageHeight, int &bestX, int &bestY, size_t &bestIndex )
+	{
+		bool found = false;
+
+		for( size_t i = 0; i < skyline.size(); ++i ) {
+			int x = skyline[i].x;
+			if( x + width > pageWidth ) break;
+
+			// the rectangle rests on the highest segment it covers
+			int y = 0;
+			int remaining = width;
+			for( size_t j = i; j < skyline.size() && remaining > 0; ++j ) {
+				y = std::max( y, skyline[j].y );
+				remaining -= skyline[j].width;
+			}
+
+			if( y + height > pageHeight ) continue;
+
+			if( !found || y < bestY || ( y == bestY && x < bestX ) ) {
+				found = true;
+				bestX = x;
+				bestY = y;
+				bestIndex = i;
+			}
+		}
+
+		return found;
+	}
+
+	//! raises the skyline where the rectangle has been placed
+	void addToSkyline( std::vector<Segment> &skyline, size_t index, int width, int height, int y )
+	{
+		Segment segment = { skyline[index].x, y + height, width };
+		skyline.insert( skyline.begin() + index, segment );
+
+		// shrink or remove the segments covered by the new one
+		int right = segment.x + segment.width;
+		for( size_t i = index + 1; i < skyline.size(); ) {
+			if( skyline[i].x >= right ) break;
+
+			int shrink = right - skyline[i].x;
+			if( shrink >= skyline[i].width ) {
+				skyline.erase( skyline.begin() + i );
+			}
+			else {
+				skyline[i].x += shrink;
+				skyline[i].width -= shrink;
+				break;
+			}
+		}
+
+		// merge neighbours of equal height
+		for( size_t i = 0; i + 1 < skyline.size(); ) {
+			if( skyline[i].y == skyline[i + 1].y ) {
+				skyline[i].width += skyline[i + 1].width;
+				skyline.erase( skyline.begin() + i + 1 );
+			}
+			else ++i;
+		}
+	}
+}
+
+WarpAtlas::WarpAtlas( int pageWidth, int pageHeight, int padding )
+	: mPageWidth( pageWidth )
+	, mPageHeight( pageHeight )
+	, mPadding( padding )
+{
+	// same format as the frame buffer of WarpBilinear
+	mFormat.internalformat = GL_RGB;
+}
+
+WarpAtlas::~WarpAtlas()
+{
+	clear();
+}
+
+void WarpAtlas::allocate( const WarpList &warps )
+{
+	clear();
+
+	// warps only need room for the area of the content they display
+	std::vector<ofRectangle> sizes;
+	for( WarpConstIter itr = warps.begin(); itr != warps.end(); ++itr ) {
+		ofRectangle area = (*itr)->getContentArea();
+		sizes.push_back( ofRectangle( 0, 0, area.width, area.height ) );
+	}
+
+	mWarps = warps;
+	mRegions = pack( sizes, mPageWidth, mPageHeight, mPadding );
+
+	// only allocate the part of each page that is in use
+	std::vector<ofRectangle> bounds;
+	for( size_t i = 0; i < mRegions.size(); ++i ) {
+		int page = mRegions[i].page;
+		if( page < 0 ) continue;
+
+		if( page >= (int)bounds.size() )
+			bounds.resize( page + 1 );
+		bounds[page].width = std::max( bounds[page].width, mRegions[i].rect.getRight() );
+		bounds[page].height = std::max( bounds[page].height, mRegions[i].rect.getBottom() );
+	}
+
+	for( size_t i = 0; i < bounds.size(); ++i ) {
+		ofFbo::Settings settings = mFormat;
+		settings.width = (int)bounds[i].width;
+		settings.height = (int)bounds[i].height;
+
+		shared_ptr<ofFbo> fbo = make_shared<ofFbo>();
+		fbo->allocate( settings );
+		mPages.push_back( fbo );
+	}
+
+	// warps that do not fit on a page keep their own frame buffer
+	for( size_t i = 0; i < mWarps.size(); ++i ) {
+		if( mRegions[i].page >= 0 )
+			mWarps[i]->setContentFbo( mPages[mRegions[i].page], mRegions[i].rect );
+	}
+}
+
+void WarpAtlas::clear()
+{
+	for( size_t i = 0; i < mWarps.size(); ++i ) {
+		if( mRegions[i].page >= 0 )
+			mWarps[i]->setContentFbo( nullptr, ofRectangle() );
+	}
+
+	mWarps.clear();
+	mRegions.clear();
+	mPages.clear();
+}
+
+WarpAtlas::Region WarpAtlas::getRegion( const WarpRef &warp ) const
+{
+	for( size_t i = 0; i < mWarps.size(); ++i ) {
+		if( mWarps[i] == warp )
+			return mRegions[i];
+	}
+
+	return Region();
+}
+
+size_t WarpAtlas::getNumPixels() const
+{
+	size_t total = 0;
+	for( size_t i = 0; i < mPages.size(); ++i )
+		total += size_t( mPages[i]->getWidth() ) * size_t( mPages[i]->getHeight() );
+
+	return total;
+}
+
+std::vector<WarpAtlas::Region> WarpAtlas::pack( const std::vector<ofRectangle> &sizes, int pageWidth, int pageHeight, int padding )
+{
+	std::vector<Region> regions( sizes.size() );
+
+	// place the tallest rectangles first
+	std::vector<size_t> order( sizes.size() );
+	std::iota( order.begin(), order.end(), 0 );
+	std::stable_sort( order.begin(), order.end(), [&]( size_t a, size_t b ) {
+		if( sizes[a].height != sizes[b].height ) return sizes[a].height > sizes[b].height;
+		return sizes[a].width > sizes[b].width;
+	} );
+
+	std::vector<std::vector<Segment>> pages;
+
+	for( size_t n = 0; n < order.size(); ++n ) {
+		size_t i = order[n];
+
+		// padding keeps linear filtering from bleeding into neighbouring regions
+		int width = (int)std::ceil( sizes[i].width ) + 2 * padding;
+		int height = (int)std::ceil( sizes[i].height ) + 2 * padding;
+		if( width > pageWidth || height > pageHeight ) continue;
+
+		// try the existing pages first, then start a new one
+		bool placed = false;
+		for( size_t page = 0; page <= pages.size() && !placed; ++page ) {
+			if( page == pages.size() ) {
+				Segment segment = { 0, 0, pageWidth };
+				pages.push_back( std::vector<Segment>( 1, segment ) );
+			}
+
+			int x = 0, y = 0;
+			size_t index = 0;
+			if( findPosition( pages[page], width, height, pageWidth, pageHeight, x, y, index ) ) {
+				addToSkyline( pages[page], index, width, height, y );
+				regions[i] = Region( (int)page, ofRectangle( float( x + padding ), float( y + padding ), sizes[i].width, sizes[i].height ) );
+				placed = true;
+			}
+		}
+	}
+
+	return regions;
+}
@@ -0,0 +1,73 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "Warp.h"
+
+//! Packs the content of multiple warps into one or a few shared frame buffers. Every warp renders into,
+//! and samples from, its own region of a shared frame buffer instead of allocating a frame buffer of its own.
+class WarpAtlas {
+	public:
+		//! position of a packed rectangle, page is -1 if the rectangle does not fit on a page
+		typedef struct Region {
+			int			page;
+			ofRectangle	rect;
+
+			Region() : page(-1) {}
+			Region(int page, const ofRectangle &rect) : page(page), rect(rect) {}
+		} Region;
+
+	public:
+		WarpAtlas(int pageWidth = 4096, int pageHeight = 4096, int padding = 2);
+		virtual ~WarpAtlas(void);
+
+		//! set the frame buffer format of the pages, width and height are ignored
+		void				setFormat(const ofFbo::Settings &format) { mFormat = format; }
+
+		//! packs the content of all warps into shared frame buffers and assigns each warp its region
+		void				allocate(const WarpList &warps);
+		//! detaches all warps from the shared frame buffers and releases them
+		void				clear();
+
+		//! returns the number of shared frame buffers
+		size_t				getNumPages() const { return mPages.size(); }
+		//! returns one of the shared frame buffers
+		shared_ptr<ofFbo>	getPage(size_t index) const { return mPages[index]; }
+		//! returns the region of the warp, page is -1 if the warp is not part of the atlas
+		Region				getRegion(const WarpRef &warp) const;
+		//! returns the total number of pixels of all shared frame buffers
+		size_t				getNumPixels() const;
+
+		//! packs rectangles of the specified sizes into as few pages as possible, using a skyline bottom-left heuristic
+		static std::vector<Region>	pack(const std::vector<ofRectangle> &sizes, int pageWidth, int pageHeight, int padding = 0);
+
+	protected:
+		int							mPageWidth;
+		int							mPageHeight;
+		int							mPadding;
+
+		ofFbo::Settings				mFormat;
+
+		std::vector<shared_ptr<ofFbo>>	mPages;
+		std::vector<WarpRef>			mWarps;
+		std::vector<Region>				mRegions;
+};
@@ -31,6 +31,8 @@ glm::vec2 p2;
 
 WarpBilinear::WarpBilinear()
 	: Warp( BILINEAR )
+	, mSource( nullptr )
+	, mSourceYuv( nullptr )
 	, mIsLinear( false )
 	, mIsAdaptive( false )
 	, mX1( 0.0f )
@@ -40,7 +42,14 @@ WarpBilinear::WarpBilinear()
 	, mResolutionX( 0 )
 	, mResolutionY( 0 )
 	, mResolution( 16 ) // higher value is coarser mesh
+	, mMeshRevision( 0 )
 {
+	mUniforms.setSampler( "tex0", 0 );
+	mUniforms.setSampler( "uColorLut", 1 );
+	mUniforms.setSampler( "uBlendMask", 2 );
+	mUniforms.setSampler( "uTexU", WarpYuv::UNIT_U );
+	mUniforms.setSampler( "uTexV", WarpYuv::UNIT_V );
+
     reset();
     
     
@@ -81,28 +90,30 @@ void WarpBilinear::reset()
 }
 
 void WarpBilinear::draw( const ofTexture &texture, const ofRectangle &srcArea, const ofRectangle &destRect )
-{    
-	//texture.bind();
-
-        //FIX
-        // clip against bounds
-        //ofRectangle	area = srcArea;
-        //ofRectangle	rect = destRect;
-        //clip( area, rect );
-
-        // set texture coordinates
-        //float w = static_cast<float>( texture.getWidth() );
-        //float h = static_cast<float>( texture.getHeight() );
-
-        //if( texture.texData.textureTarget == GL_TEXTURE_RECTANGLE_ARB )
-        //    setTexCoords( (float)area.x, (float)area.y, (float)area.width + (float)area.x, (float)area.height + (float)area.y);
-        //else
-        //    setTexCoords( area.x / w, area.y / h, (float)area.width + (float)area.x / w, (float)area.height + (float)area.y / h );
-
-        // draw
-        draw();
-    
-	//texture.unbind();
+{
+	if( !texture.isAllocated() || destRect.width == 0.0f || destRect.height == 0.0f ) return;
+
+	// the mesh spans the bounds of the warp, map the destination rectangle onto the source area
+	float sx = srcArea.width / destRect.width;
+	float sy = srcArea.height / destRect.height;
+
+	// sample the texture directly through the warp mesh, without copying it into our frame buffer
+	mSource = &texture;
+	mSourceRegion = ofRectangle( srcArea.x - destRect.x * sx, srcArea.y - destRect.y * sy, mWidth * sx, mHeight * sy );
+
+	draw();
+
+	mSource = nullptr;
+}
+
+void WarpBilinear::draw( const WarpYuv::Textures &frame, const ofRectangle &srcArea, const ofRectangle &destRect )
+{
+	if( !frame.isAllocated() ) return;
+
+	// the luma plane is sampled like any texture, the shader fetches the chroma planes at the same coordinates
+	mSourceYuv = &frame;
+	draw( *frame.y, srcArea, destRect );
+	mSourceYuv = nullptr;
 }
 
 void WarpBilinear::begin()
@@ -121,14 +132,24 @@ void WarpBilinear::begin()
     ofSetColor(255);
     
     
+    // render into our region of a shared frame buffer
+    if (!mContentRegion.isEmpty()) {
+        if (!mFbo || !mFbo->isAllocated()) return;
+        mFbo->begin();
+        beginContentRegion();
+        return;
+    }
+
     if (!mFbo){
         mFbo = make_shared<ofFbo>();
     }
 	if( !mFbo->isAllocated() ) {
 		try {
+			// only allocate the area of the content we display
+			ofRectangle area = getContentArea();
 			ofFbo::Settings settings;
-			settings.width = mWidth;
-			settings.height = mHeight;
+			settings.width = (int)area.width;
+			settings.height = (int)area.height;
             
             settings.internalformat = GL_RGB;
 			mFbo->allocate(settings);
@@ -136,7 +157,7 @@ void WarpBilinear::begin()
 		catch( ... ) {
 			// try creating Fbo with default format settings
 			try {
-				mFbo->allocate( mWidth, mHeight );
+				mFbo->allocate( (int)getContentArea().width, (int)getContentArea().height );
 			}
 			catch( ... ) {
 				return;
@@ -146,19 +167,67 @@ void WarpBilinear::begin()
 
 	mFbo->begin();
     ofClear(255);
+    beginContentArea();
 }
 
 void WarpBilinear::end()
 {
+    if (!mFbo || !mFbo->isAllocated()) return;
+
+    if (!mContentRegion.isEmpty())
+        endContentRegion();
     mFbo->end();
-    
+    setContentRendered();
+
+    redraw();
+}
+
+void WarpBilinear::redraw()
+{
+    draw();
+}
+
+void WarpBilinear::setContentFbo( const shared_ptr<ofFbo> &fbo, const ofRectangle &region )
+{
+	mFbo = fbo;
+	mContentRegion = fbo ? region : ofRectangle();
+	mIsContentDirty = true;
+	mIsUniformsDirty = true;
+}
 
-    // draw flipped
-    ofRectangle srcArea = ofRectangle(0, 0, mFbo->getWidth(), mFbo->getHeight());
-   int32_t t = srcArea.y; srcArea.y = srcArea.height + srcArea.y; srcArea.height = t;
-   draw( mFbo->getTexture(), srcArea, ofRectangle( getBounds() ) );
+void WarpBilinear::setContentArea( const ofRectangle &area )
+{
+	ofRectangle previous = getContentArea();
+	Warp::setContentArea( area );
 
-	//draw();
+	// the frame buffer only holds the content area
+	if( getContentArea() != previous )
+		releaseFbo();
+}
+
+void WarpBilinear::getMesh( ofMesh &mesh )
+{
+	mesh.clear();
+
+	updateBuffers();
+	if( !mVboMesh ) return;
+
+	mesh.addVertices( mVboMesh->getVertices() );
+	mesh.addTexCoords( mVboMesh->getTexCoords() );
+	mesh.addIndices( mVboMesh->getIndices() );
+}
+
+void WarpBilinear::releaseFbo()
+{
+	// never clear a shared frame buffer, just stop using it
+	if( !mContentRegion.isEmpty() ) {
+		mFbo.reset();
+		mContentRegion = ofRectangle();
+		mIsUniformsDirty = true;
+	}
+	else if( mFbo ) {
+		mFbo->clear();
+	}
 }
 
 void WarpBilinear::bind(){
@@ -175,35 +244,79 @@ void WarpBilinear::draw( bool controls )
     createBuffers();
 
 	if( !mVboMesh ) return;
+
+	// sample the supplied texture, or the content rendered into our frame buffer
+	const ofTexture *texture = mSource;
+	ofRectangle region = mSourceRegion;
+	if( !texture ) {
+		if( !mFbo || !mFbo->isAllocated() ) return;
+
+		texture = &mFbo->getTexture();
+		region = mContentRegion.isEmpty() ? ofRectangle( 0, 0, getContentArea().width, getContentArea().height ) : mContentRegion;
+	}
     
 	glDisable(GL_DEPTH_TEST);
 	glDisable(GL_DEPTH_WRITEMASK);
 	glHint( GL_LINE_SMOOTH_HINT, GL_NICEST );
 
+	// select the shader variant with only the features this warp uses
+	unsigned features = getShaderFeatures( texture->getTextureData().textureTarget );
+	if( mSourceYuv && mSource )
+		features |= ( mSourceYuv->format == WarpYuv::I420 ) ? WarpShaderCache::YUV_I420 : WarpShaderCache::YUV_NV12;
+	mShader = mShaders.get( features );
+
+	// bake the blend mask, only if any of its parameters have changed
+	if( features & WarpShaderCache::BLEND_MASK ) {
+		mBlendMask.setSource( blendTexture );
+		mBlendMask.update( getBlendSettings() );
+	}
+
+	// compile the color pipeline into a 3D lut, only if any of its parameters have changed
+	if( features & WarpShaderCache::COLOR_LUT ) {
+		if( sUseColorLut )
+			mColorLut.setSource( lutTexture );
+		mColorLut.update( getColorSettings() );
+	}
+
+	// write the parameters to the uniform block, only if any of them have changed
+	if( mIsUniformsDirty ) {
+		mUniforms.set( 0, glm::vec4( float(mWidth), float(mHeight), mWidth / float( mControlsX - 1 ), mHeight / float( mControlsY - 1 ) ) );
+		mUniforms.set( 2, glm::vec4( float(mWidth), float(mHeight), float( mColorLut.getSize() ), 0.0f ) );
+		mIsUniformsDirty = false;
+	}
+
+	// the region of the texture that is sampled, only uploaded if it has changed
+	mUniforms.set( 1, glm::vec4( region.x, region.y, region.width, region.height ) );
+
 	// draw warp mesh
 	ofSetColor(255);
-	mFbo->getTexture().bind();
+	texture->bind( 0 );
+	if( features & WarpShaderCache::COLOR_LUT ) {
+		glActiveTexture( GL_TEXTURE1 );
+		glBindTexture( GL_TEXTURE_3D, mColorLut.getTextureId() );
+		glActiveTexture( GL_TEXTURE0 );
+	}
+	if( features & WarpShaderCache::BLEND_MASK )
+		mBlendMask.getTexture().bind( 2 );
+	if( features & ( WarpShaderCache::YUV_NV12 | WarpShaderCache::YUV_I420 ) )
+		WarpYuv::bind( *mSourceYuv );
+
        mShader->begin();
-        mShader->setUniformTexture( "uTex0", mFbo->getTexture(), 0 );
-        mShader->setUniform4f( "uExtends", ofVec4f( float(mWidth), float(mHeight), mWidth / float( mControlsX - 1 ), mHeight / float( mControlsY - 1 ) ) );
-        mShader->setUniform3f( "uLuminance", mLuminance );
-        mShader->setUniform3f( "uGamma", mGamma );
-        mShader->setUniform4f( "uEdges", mEdges );
-        mShader->setUniform1f( "uExponent", mExponent );
-        mShader->setUniform1i( "uEditMode", (bool)isEditModeEnabled() );
-        mShader->setUniform2f( "uResolution", ofVec2f( float(mWidth), float(mHeight) ));
-        mShader->setUniform1f( "uBrightness", mBrightness );
-        mShader->setUniform1f( "uContrast", mContrast );
-        mShader->setUniform1f( "uSaturation", mSaturation );
-		mShader->setUniform1i( "uUseColorLut", sUseColorLut );
-		if (sUseColorLut) {
-			mShader->setUniformTexture( "uColorLut", lutTexture, 1 );
-			mShader->setUniform1f( "uMapdim", 256.0);
-		}
-		//mShader->setUniformTexture( "uBlendTexture", blendTexture, 2 );
+        mUniforms.bind( *mShader );
 		mVboMesh->draw();
+        mUniforms.unbind();
 	   mShader->end();
-	mFbo->getTexture().unbind();
+
+	if( features & ( WarpShaderCache::YUV_NV12 | WarpShaderCache::YUV_I420 ) )
+		WarpYuv::unbind( *mSourceYuv );
+	if( features & WarpShaderCache::BLEND_MASK )
+		mBlendMask.getTexture().unbind( 2 );
+	if( features & WarpShaderCache::COLOR_LUT ) {
+		glActiveTexture( GL_TEXTURE1 );
+		glBindTexture( GL_TEXTURE_3D, 0 );
+		glActiveTexture( GL_TEXTURE0 );
+	}
+	texture->unbind( 0 );
     
 	// draw edit interface
 	if (isEditModeEnabled() && controls && mSelected < mPoints.size()) {
@@ -359,6 +472,14 @@ void WarpBilinear::createBuffers()
 	}
 }
 
+bool WarpBilinear::updateBuffers()
+{
+	bool changed = mIsDirty;
+	createBuffers();
+
+	return changed;
+}
+
 void WarpBilinear::createMesh( int resolutionX, int resolutionY )
 {
 	// convert from number of quads to number of vertices
@@ -384,6 +505,13 @@ void WarpBilinear::createMesh( int resolutionX, int resolutionY )
 		resolutionY = mControlsY;
 	}
 
+	// the indices only depend on the resolution, so keep them if it has not changed.
+	// updateMesh replaces the vertices and texture coordinates.
+	if( mVboMesh && mVboMesh->getNumIndices() > 0 && resolutionX == mResolutionX && resolutionY == mResolutionY ) {
+		mIsDirty = true;
+		return;
+	}
+
 	//
 	mResolutionX = resolutionX;
 	mResolutionY = resolutionY;
@@ -408,7 +536,7 @@ void WarpBilinear::createMesh( int resolutionX, int resolutionY )
 	int rows = resolutionX;
 	int columns = resolutionY;
 
-	ofVec3f vert;
+	ofVec3f vert(0, 0, 1); // z holds the projective q coordinate //
 	ofVec3f normal(0, 0, 1); // always facing forward //
 	ofVec2f texcoord;
 
@@ -541,7 +669,7 @@ void WarpBilinear::updateMesh()
 
             
             texc[index] = ofVec2f(uu,vv);
-            positions[index++] = ofVec3f(p.x, p.y, 0);
+            positions[index++] = projectVertex(p);
 		}
 	}
 
@@ -551,7 +679,7 @@ void WarpBilinear::updateMesh()
 	mVboMesh->addVertices(positions);
 	mVboMesh->addTexCoords(texc);
 
-    
+	mMeshRevision++;
 	mIsDirty = false;
 }
 
@@ -645,6 +773,7 @@ void WarpBilinear::setNumControlX( int n )
 	// copy new control points 
 	mPoints = temp;
 	mControlsX = n;
+	mIsUniformsDirty = true;
 
     mControlPoints.clear();
 
@@ -720,6 +849,7 @@ void WarpBilinear::setNumControlY( int n )
 	// copy new control points 
 	mPoints = temp;
 	mControlsY = n;
+	mIsUniformsDirty = true;
 
     mControlPoints.clear();
     
@@ -730,20 +860,61 @@ void WarpBilinear::setNumControlY( int n )
 	mIsDirty = true;
 }
 
+void WarpBilinear::prepare()
+{
+	updateBuffers();
+
+	// the same condition as the BLEND_MASK shader feature, a user-supplied mask is only known when drawing
+	if( mEdges != ofVec4f( 0.0f ) )
+		mBlendMask.prepare( getBlendSettings() );
+}
+
+WarpColorLut::Settings WarpBilinear::getColorSettings() const
+{
+	WarpColorLut::Settings color;
+	color.brightness = mBrightness;
+	color.contrast = mContrast;
+	color.saturation = mSaturation;
+	color.matrix = mColorMatrix;
+
+	return color;
+}
+
+unsigned WarpBilinear::getShaderFeatures( GLenum textureTarget ) const
+{
+	unsigned features = 0;
+
+	if( sUseColorLut || mBrightness != 1.0f || mContrast != 1.0f || mSaturation != 1.0f || mColorMatrix != glm::mat3( 1.0f ) )
+		features |= WarpShaderCache::COLOR_LUT;
+	if( mEdges != ofVec4f( 0.0f ) || blendTexture.isAllocated() )
+		features |= WarpShaderCache::BLEND_MASK;
+	if( isEditModeEnabled() )
+		features |= WarpShaderCache::EDIT_GRID;
+	if( textureTarget != GL_TEXTURE_RECTANGLE_ARB )
+		features |= WarpShaderCache::TEXTURE_2D;
+
+	return features;
+}
+
 void WarpBilinear::createShader()
 {
-	if( mShader )
+	if( mShaders.hasSource() )
 		return;
 
-    mShader = make_shared<ofShader>();
+	// parameters shared by the vertex and fragment shader, see WarpBilinear::draw()
+	static string UniformBlock = R"END(
+        layout(std140) uniform WarpUniforms {
+            vec4 uExtends;
+            vec4 uRegion;
+            vec4 uSize;
+        };
+    )END";
 
 	static string VertShader = R"END(
-		#version 150
         uniform mat4 modelViewMatrix;
         uniform mat4 projectionMatrix;
         uniform mat4 textureMatrix;
         uniform mat4 modelViewProjectionMatrix;
-        uniform vec2 uResolution;
   
         in vec4 position;
         in vec4 color;
@@ -754,59 +925,27 @@ void WarpBilinear::createShader()
         out vec4 texColor;
     
 		void main(void) {
-            varyingtexcoord = vec2(texcoord.x*uResolution.x, texcoord.y*uResolution.y);
+            varyingtexcoord = texcoord * uSize.xy;
             texColor = color;
-            gl_Position = modelViewProjectionMatrix * position;
+            // position.z holds the projective q coordinate, which makes the interpolation perspective correct
+            gl_Position = modelViewProjectionMatrix * vec4(position.xy * position.z, 0.0, position.z);
 		}
     )END";
 
 	static string FragShader = R"END(
-		#version 150
-        uniform sampler2DRect tex0;
-        uniform vec4		uExtends;
-        uniform vec3		uLuminance;
-        uniform vec3		uGamma;
-        uniform vec4		uEdges;
-        uniform float		uExponent;
-        uniform bool		uEditMode;
-        uniform vec2		uResolution;       
-		uniform float		uBrightness;
-		uniform float		uContrast;
-		uniform float		uSaturation;
-
-		uniform sampler2DRect	uColorLut;
-		uniform float			uMapdim = 256.0;
-		uniform bool			uUseColorLut = false;
-		const int				interp = 1;
-		const float				amt = 1.0;
-
-		//uniform sampler2DRect	uBlendTexture;
+        uniform SAMPLER		tex0;
+#ifdef USE_BLEND_MASK
+        uniform sampler2D	uBlendMask;
+#endif
+#ifdef USE_COLOR_LUT
+		uniform sampler3D	uColorLut;
+#endif
 
 		in vec2 varyingtexcoord;
     	in vec4 vertColor;
         out vec4 outputColor;
-
-		const float AvgLumR = 0.5;
-		const float AvgLumG = 0.5;
-		const float AvgLumB = 0.5;
-		const vec3 LumCoeff = vec3 (0.2125, 0.7154, 0.0721);
-
-		vec4 set;
-		float rout;
-		float gout;	
-		float bout;
-		vec4 mapped;
-		vec4 t2;
-
-		vec3 ContrastSaturationBrightness(vec3 color, float brt, float sat, float con) {
-			vec3 AvgLumin = vec3(AvgLumR, AvgLumG, AvgLumB);
-			vec3 brtColor = color * brt;
-			vec3 intensity = vec3(dot(brtColor, LumCoeff));
-			vec3 satColor = mix(intensity, brtColor, sat);
-			vec3 conColor = mix(AvgLumin, satColor, con);
-			return conColor;
-		}
        
+#ifdef USE_EDIT_GRID
         float grid( in vec2 uv, in vec2 size )
         {
             vec2 coord = uv / size;
@@ -814,66 +953,45 @@ void WarpBilinear::createShader()
             float line = min( grid.x, grid.y );
             return 1.0 - min( line, 1.0 );
         }
+#endif
         
         void main()
         {
-            vec4 texColor = texture( tex0, varyingtexcoord );
-            vec3 cCSB = ContrastSaturationBrightness(texColor.rgb, uBrightness, uSaturation, uContrast);
-            
-            texColor = vec4(cCSB.rgb, texColor.a);
-            t2 = texColor;
-            
-			if (uUseColorLut){
-				set = mix(floor(t2*uMapdim),t2*uMapdim,float(interp));
-				rout = float (texture(uColorLut, vec2(set.r,0.)).r);
-				gout = float (texture(uColorLut, vec2(set.g,0.)).g);
-				bout = float (texture(uColorLut, vec2(set.b,0.)).b);
-				mapped = vec4 (rout, gout, bout,t2.a);
-				t2 = mix(t2, mapped, amt);
-        
-				set = mix(floor(t2*uMapdim),t2*uMapdim,float(interp));
-				rout = float (texture(uColorLut, vec2(set.r,0.)).a);
-				gout = float (texture(uColorLut, vec2(set.g,0.)).a);
-				bout = float (texture(uColorLut, vec2(set.b,0.)).a);
-				mapped = vec4 (rout, gout, bout,t2.a);
-				texColor = mix(t2, mapped, amt);
-			}
-
-            float a = 1.0;
-            if( uEdges.x > 0.0 ) a *= clamp( varyingtexcoord.x/uResolution.x / uEdges.x, 0.0, 1.0 );
-            if( uEdges.y > 0.0 ) a *= clamp( varyingtexcoord.y/uResolution.y / uEdges.y, 0.0, 1.0 );
-            if( uEdges.z > 0.0 ) a *= clamp( ( 1.0 - varyingtexcoord.x/uResolution.x ) / uEdges.z, 0.0, 1.0 );
-            if( uEdges.w > 0.0 ) a *= clamp( ( 1.0 - varyingtexcoord.y/uResolution.y ) / uEdges.w, 0.0, 1.0 );
-            
-            const vec3 one = vec3( 1.0 );
-            vec3 blend = ( a < 0.5 ) ? ( uLuminance * pow( 2.0 * a, uExponent ) )
-            : one - ( one - uLuminance ) * pow( 2.0 * ( 1.0 - a ), uExponent );
-   			
-			//blend = texture(uBlendTexture, varyingtexcoord).rgb;
-			texColor.rgb *= pow( blend, one / uGamma );
+            // sample the region of the frame buffer that holds our content
+            vec2 coord = uRegion.xy + varyingtexcoord / uSize.xy * uRegion.zw;
+#ifdef TEXTURE_2D
+            coord /= vec2( textureSize( tex0, 0 ) );
+#endif
+#ifdef USE_YUV
+            vec4 texColor = sampleYuv( tex0, coord );
+#else
+            vec4 texColor = texture( tex0, coord );
+#endif
+
+#ifdef USE_COLOR_LUT
+            // brightness, contrast, saturation, color matrix and color lut are compiled into a single 3D lut
+            vec3 lutCoord = clamp( texColor.rgb, 0.0, 1.0 ) * ( ( uSize.z - 1.0 ) / uSize.z ) + 0.5 / uSize.z;
+            texColor.rgb = texture( uColorLut, lutCoord ).rgb;
+#endif
+
+#ifdef USE_BLEND_MASK
+            // edge blending and gamma are baked into the blend mask
+            texColor.rgb *= texture( uBlendMask, varyingtexcoord / uSize.xy ).rgb;
+#endif
           
-            if( uEditMode ) {
-                vec2 v = vec2(varyingtexcoord.x/uResolution.x, varyingtexcoord.y/uResolution.y);
-                float f = grid(v.xy * uExtends.xy, uExtends.zw );
-                vec4 gridColor = vec4( 1 );
-                outputColor = mix( texColor, gridColor, f );
-            }
-            else {
-                outputColor = texColor;
-            }
+#ifdef USE_EDIT_GRID
+            vec2 v = varyingtexcoord / uSize.xy;
+            float f = grid(v.xy * uExtends.xy, uExtends.zw );
+            vec4 gridColor = vec4( 1 );
+            outputColor = mix( texColor, gridColor, f );
+#else
+            outputColor = texColor;
+#endif
         }
     
 	)END";
-	try {
-        mShader->setupShaderFromSource(GL_VERTEX_SHADER, VertShader);
-        mShader->setupShaderFromSource(GL_FRAGMENT_SHADER, FragShader);
-        mShader->bindDefaults();
-        mShader->linkProgram();
 
-	}
-	catch( const std::exception &e ) {
-		cout << e.what() << std::endl;
-	}
+	mShaders.setSource( UniformBlock + VertShader, UniformBlock + WarpYuv::getShaderSource() + FragShader );
 }
 
 ofRectangle WarpBilinear::getMeshBounds() const
@@ -0,0 +1,232 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarpBlendMask.h"
+
+#include <thread>
+
+WarpBlendMask::WarpBlendMask()
+	: mIsDirty( true )
+	, mSourceId( 0 )
+	, mIsUploadPending( false )
+	, mNumBakes( 0 )
+{
+}
+
+WarpBlendMask::~WarpBlendMask()
+{
+}
+
+void WarpBlendMask::setSource( const ofTexture &texture )
+{
+	if( !texture.isAllocated() ) {
+		if( mSource.isAllocated() ) {
+			mSource.clear();
+			mSourceId = 0;
+			mIsDirty = true;
+		}
+		return;
+	}
+
+	// only read back the texture if it is a different one
+	if( texture.getTextureData().textureID == mSourceId ) return;
+
+	ofFloatPixels pixels;
+	texture.readToPixels( pixels );
+	setSource( pixels );
+
+	mSourceId = texture.getTextureData().textureID;
+}
+
+void WarpBlendMask::setSource( const ofFloatPixels &pixels )
+{
+	// the mask is baked from RGB values
+	mSource.allocate( pixels.getWidth(), pixels.getHeight(), 3 );
+
+	const float *src = pixels.getData();
+	float *dst = mSource.getData();
+	size_t channels = pixels.getNumChannels();
+
+	for( size_t i = 0; i < pixels.getWidth() * pixels.getHeight(); ++i ) {
+		for( size_t c = 0; c < 3; ++c )
+			dst[i * 3 + c] = src[i * channels + std::min( c, channels - 1 )];
+	}
+
+	mSourceId = 0;
+	mIsDirty = true;
+}
+
+bool WarpBlendMask::prepare( const Settings &settings )
+{
+	Settings s = settings;
+
+	// a user-supplied mask determines the resolution
+	if( mSource.isAllocated() ) {
+		s.width = (int)mSource.getWidth();
+		s.height = (int)mSource.getHeight();
+	}
+	else {
+		s.width = std::max( 2, std::min( s.width, (int)MAX_RESOLUTION ) );
+		s.height = std::max( 2, std::min( s.height, (int)MAX_RESOLUTION ) );
+	}
+
+	if( !mIsDirty && s == mSettings ) return false;
+
+	mSettings = s;
+	mIsDirty = false;
+
+	mPixels.allocate( s.width, s.height, 3 );
+	bake( mPixels.getData(), s, mSource.isAllocated() ? mSource.getData() : nullptr );
+
+	mIsUploadPending = true;
+	mNumBakes++;
+
+	return true;
+}
+
+bool WarpBlendMask::update( const Settings &settings )
+{
+	bool baked = prepare( settings );
+	if( !mIsUploadPending ) return baked;
+
+	// upload as a normalized texture, so it can be sampled at any resolution
+	if( !mTexture.isAllocated() || mTexture.getWidth() != mSettings.width || mTexture.getHeight() != mSettings.height ) {
+		mTexture.allocate( mSettings.width, mSettings.height, GL_RGB32F, false );
+		mTexture.setTextureMinMagFilter( GL_LINEAR, GL_LINEAR );
+		mTexture.setTextureWrap( GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE );
+	}
+	mTexture.loadData( mPixels );
+	mIsUploadPending = false;
+
+	return baked;
+}
+
+void WarpBlendMask::bake( float *dst, const Settings &settings, const float *source, unsigned numThreads )
+{
+	if( numThreads == 0 )
+		numThreads = std::max( 1u, std::thread::hardware_concurrency() );
+	numThreads = std::min( numThreads, (unsigned)std::max( settings.height, 1 ) );
+
+	if( numThreads <= 1 ) {
+		bakeRows( dst, settings, source, 0, settings.height );
+		return;
+	}
+
+	// rows are independent, split them into equal bands
+	std::vector<std::thread> threads;
+	int rows = ( settings.height + numThreads - 1 ) / numThreads;
+
+	for( unsigned i = 0; i < numThreads; ++i ) {
+		int begin = i * rows;
+		int end = std::min( settings.height, begin + rows );
+		if( begin >= end ) break;
+
+		threads.push_back( std::thread( &WarpBlendMask::bakeRows, dst, std::cref( settings ), source, begin, end ) );
+	}
+
+	for( size_t i = 0; i < threads.size(); ++i )
+		threads[i].join();
+}
+
+//! the blending curve of the shader for a single channel: ramp a, luminance at the center of the ramp, exponent and 1 / gamma
+static inline float blendCurve( float a, float luminance, float exponent, float invGamma )
+{
+	float blend = ( a < 0.5f )
+		? luminance * std::pow( 2.0f * a, exponent )
+		: 1.0f - ( 1.0f - luminance ) * std::pow( 2.0f * ( 1.0f - a ), exponent );
+
+	return std::pow( std::max( blend, 0.0f ), invGamma );
+}
+
+//! the edge ramp along one axis, at normalized position t with the edge widths at the start and the end of the axis
+static inline float edgeRamp( float t, float start, float end )
+{
+	float a = 1.0f;
+	if( start > 0.0f ) a *= ofClamp( t / start, 0.0f, 1.0f );
+	if( end > 0.0f ) a *= ofClamp( ( 1.0f - t ) / end, 0.0f, 1.0f );
+
+	return a;
+}
+
+glm::vec3 WarpBlendMask::evaluate( const Settings &settings, float u, float v )
+{
+	// same curve as bakeRows(), for a single position
+	float a = edgeRamp( u, settings.edges.x, settings.edges.z ) * edgeRamp( v, settings.edges.y, settings.edges.w );
+
+	return glm::vec3( blendCurve( a, settings.luminance.x, settings.exponent, 1.0f / settings.gamma.x ),
+		blendCurve( a, settings.luminance.y, settings.exponent, 1.0f / settings.gamma.y ),
+		blendCurve( a, settings.luminance.z, settings.exponent, 1.0f / settings.gamma.z ) );
+}
+
+void WarpBlendMask::bakeRows( float *dst, const Settings &settings, const float *source, int begin, int end )
+{
+	const int width = settings.width;
+	const int height = settings.height;
+	const size_t stride = size_t( width ) * 3;
+
+	const float invGamma[3] = { 1.0f / settings.gamma.x, 1.0f / settings.gamma.y, 1.0f / settings.gamma.z };
+	const float luminance[3] = { settings.luminance.x, settings.luminance.y, settings.luminance.z };
+	const float exponent = settings.exponent;
+
+	// user-supplied mask replaces the edge blending curve, only gamma is applied
+	if( source ) {
+		for( int y = begin; y < end; ++y ) {
+			float *row = dst + size_t( y ) * stride;
+			const float *src = source + size_t( y ) * stride;
+
+			for( int x = 0; x < width; ++x ) {
+				row[x * 3 + 0] = std::pow( std::max( src[x * 3 + 0], 0.0f ), invGamma[0] );
+				row[x * 3 + 1] = std::pow( std::max( src[x * 3 + 1], 0.0f ), invGamma[1] );
+				row[x * 3 + 2] = std::pow( std::max( src[x * 3 + 2], 0.0f ), invGamma[2] );
+			}
+		}
+		return;
+	}
+
+	// the edge ramp is separable, calculate the horizontal part once
+	std::vector<float> ramp( width );
+	for( int x = 0; x < width; ++x )
+		ramp[x] = edgeRamp( ( x + 0.5f ) / width, settings.edges.x, settings.edges.z );
+
+	// rows outside the top and bottom edges are all the same, so the curve is only evaluated once for them
+	std::vector<float> interior( stride );
+	for( int x = 0; x < width; ++x ) {
+		for( int c = 0; c < 3; ++c )
+			interior[x * 3 + c] = blendCurve( ramp[x], luminance[c], exponent, invGamma[c] );
+	}
+
+	for( int y = begin; y < end; ++y ) {
+		float *row = dst + size_t( y ) * stride;
+
+		float b = edgeRamp( ( y + 0.5f ) / height, settings.edges.y, settings.edges.w );
+		if( b == 1.0f ) {
+			std::copy( interior.begin(), interior.end(), row );
+			continue;
+		}
+
+		for( int x = 0; x < width; ++x ) {
+			float a = ramp[x] * b;
+			for( int c = 0; c < 3; ++c )
+				row[x * 3 + c] = blendCurve( a, luminance[c], exponent, invGamma[c] );
+		}
+	}
+}
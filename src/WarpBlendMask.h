@@ -0,0 +1,98 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "ofMain.h"
+
+//! Bakes the edge blending curve of a warp into a texture. The mask is only recalculated when the blend
+//! parameters change, so the shader only has to do a single fetch and multiply per pixel.
+class WarpBlendMask {
+	public:
+		//! blend parameters the mask is baked from
+		typedef struct Settings {
+			int			width;
+			int			height;
+			ofVec4f		edges;
+			float		exponent;
+			ofVec3f		luminance;
+			ofVec3f		gamma;
+
+			Settings() : width(0), height(0), edges(0.0f), exponent(2.0f), luminance(0.5f), gamma(1.0f) {}
+
+			bool operator==(const Settings &rhs) const {
+				return width == rhs.width && height == rhs.height && edges == rhs.edges && exponent == rhs.exponent
+					&& luminance == rhs.luminance && gamma == rhs.gamma;
+			}
+			bool operator!=(const Settings &rhs) const { return !(*this == rhs); }
+		} Settings;
+
+	public:
+		WarpBlendMask();
+		virtual ~WarpBlendMask(void);
+
+		//! use a user-supplied blend mask instead of the edge blending curve, gamma is still applied. Pass an empty texture to remove it.
+		void				setSource(const ofTexture &texture);
+		//! use user-supplied blend mask pixels instead of the edge blending curve, gamma is still applied
+		void				setSource(const ofFloatPixels &pixels);
+
+		//! bakes the mask if the settings have changed, without uploading it. Does not use GL, so it can be called from any thread.
+		bool				prepare(const Settings &settings);
+		//! bakes and uploads the mask if the settings have changed, returns true if it was baked
+		bool				update(const Settings &settings);
+		//! bakes the mask on the next prepare() or update(), and reads back the source texture again even if it is the same one
+		void				markDirty() { mSourceId = 0; mIsDirty = true; }
+
+		//! returns the baked mask texture
+		const ofTexture&	getTexture() const { return mTexture; }
+		//! returns the baked mask pixels
+		const ofFloatPixels& getPixels() const { return mPixels; }
+		//! returns the number of times the mask has been baked
+		int					getNumBakes() const { return mNumBakes; }
+
+		//! bakes the mask into an RGB float buffer of width x height pixels. If source is not null, it holds an RGB mask of the same size
+		//! that replaces the edge blending curve. Rows are spread over the specified number of threads (0 = hardware concurrency).
+		static void			bake(float *dst, const Settings &settings, const float *source = nullptr, unsigned numThreads = 0);
+
+		//! evaluates the edge blending curve at normalized content coordinates, returns the RGB blend factors
+		static glm::vec3	evaluate(const Settings &settings, float u, float v);
+
+		//! maximum width and height of the mask, the blend curve is smooth enough to be sampled with linear filtering
+		static const int	MAX_RESOLUTION = 1024;
+
+	protected:
+		//! bakes the rows [begin, end) of the mask
+		static void			bakeRows(float *dst, const Settings &settings, const float *source, int begin, int end);
+
+	protected:
+		Settings			mSettings;
+		bool				mIsDirty;
+
+		ofFloatPixels		mSource;
+		GLuint				mSourceId;
+
+		ofFloatPixels		mPixels;
+		ofTexture			mTexture;
+		//! set if the pixels were baked but not uploaded yet
+		bool				mIsUploadPending;
+
+		int					mNumBakes;
+};
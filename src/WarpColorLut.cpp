@@ -0,0 +1,309 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarpColorLut.h"
+
+#include <thread>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+WarpColorLut::WarpColorLut()
+	: mIsDirty( true )
+	, mSourceId( 0 )
+	, mTextureId( 0 )
+	, mIsUploadPending( false )
+	, mNumBuilds( 0 )
+{
+}
+
+WarpColorLut::~WarpColorLut()
+{
+	if( mTextureId )
+		glDeleteTextures( 1, &mTextureId );
+}
+
+void WarpColorLut::setSource( const ofTexture &texture )
+{
+	if( !texture.isAllocated() ) {
+		if( mSource.isAllocated() ) {
+			mSource.clear();
+			mSourceId = 0;
+			mIsDirty = true;
+		}
+		return;
+	}
+
+	// only read back the texture if it is a different one
+	if( texture.getTextureData().textureID == mSourceId ) return;
+
+	ofFloatPixels pixels;
+	texture.readToPixels( pixels );
+	setSource( pixels );
+
+	mSourceId = texture.getTextureData().textureID;
+}
+
+void WarpColorLut::setSource( const ofFloatPixels &pixels )
+{
+	// only the first row is used, stored as RGBA
+	size_t width = pixels.getWidth();
+	size_t channels = pixels.getNumChannels();
+	mSource.allocate( width, 1, 4 );
+
+	const float *src = pixels.getData();
+	float *dst = mSource.getData();
+	for( size_t i = 0; i < width; ++i ) {
+		for( size_t c = 0; c < 4; ++c )
+			dst[i * 4 + c] = ( c < channels ) ? src[i * channels + c] : 1.0f;
+	}
+
+	mSourceId = 0;
+	mIsDirty = true;
+}
+
+bool WarpColorLut::prepare( const Settings &settings )
+{
+	Settings s = settings;
+	s.size = std::max( 2, settings.size );
+
+	if( !mIsDirty && s == mSettings && !mData.empty() ) return false;
+
+	mSettings = s;
+	mIsDirty = false;
+
+	int size = mSettings.size;
+	mData.resize( size_t( size ) * size * size * 4 );
+
+	if( mSource.isAllocated() )
+		build( &mData[0], mSettings, mSource.getData(), (int)mSource.getWidth() );
+	else
+		build( &mData[0], mSettings );
+
+	mIsUploadPending = true;
+	mNumBuilds++;
+
+	return true;
+}
+
+bool WarpColorLut::update( const Settings &settings )
+{
+	bool built = prepare( settings );
+	if( !mIsUploadPending ) return built;
+
+	// upload as a linearly filtered 3D texture
+	int size = mSettings.size;
+	if( !mTextureId )
+		glGenTextures( 1, &mTextureId );
+
+	glBindTexture( GL_TEXTURE_3D, mTextureId );
+	glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE );
+	glTexImage3D( GL_TEXTURE_3D, 0, GL_RGBA32F, size, size, size, 0, GL_RGBA, GL_FLOAT, &mData[0] );
+	glBindTexture( GL_TEXTURE_3D, 0 );
+	mIsUploadPending = false;
+
+	return built;
+}
+
+void WarpColorLut::apply( const ofPixels &src, ofPixels &dst ) const
+{
+	// the lut maps RGB, gray and gray-alpha pixels are not supported
+	if( mData.empty() || src.getNumChannels() < 3 ) return;
+
+	int channels = (int)src.getNumChannels();
+	dst.allocate( src.getWidth(), src.getHeight(), channels );
+
+	size_t numPixels = src.getWidth() * src.getHeight();
+	unsigned numThreads = std::max( 1u, std::thread::hardware_concurrency() );
+	size_t count = ( numPixels + numThreads - 1 ) / numThreads;
+
+	std::vector<std::thread> threads;
+	for( size_t begin = 0; begin < numPixels; begin += count ) {
+		size_t n = std::min( count, numPixels - begin );
+		threads.push_back( std::thread( [&, begin, n]() {
+			apply( &mData[0], mSettings.size, src.getData() + begin * channels, dst.getData() + begin * channels, n, channels );
+		} ) );
+	}
+
+	for( size_t i = 0; i < threads.size(); ++i )
+		threads[i].join();
+}
+
+void WarpColorLut::build( float *dst, const Settings &settings, const float *curve, int curveWidth, unsigned numThreads )
+{
+	int size = settings.size;
+
+	if( numThreads == 0 )
+		numThreads = std::max( 1u, std::thread::hardware_concurrency() );
+	numThreads = std::min( numThreads, (unsigned)size );
+
+	if( numThreads <= 1 ) {
+		buildSlices( dst, settings, curve, curveWidth, 0, size );
+		return;
+	}
+
+	// slices are independent, split them into equal bands
+	std::vector<std::thread> threads;
+	int slices = ( size + numThreads - 1 ) / numThreads;
+
+	for( unsigned i = 0; i < numThreads; ++i ) {
+		int begin = i * slices;
+		int end = std::min( size, begin + slices );
+		if( begin >= end ) break;
+
+		threads.push_back( std::thread( &WarpColorLut::buildSlices, dst, std::cref( settings ), curve, curveWidth, begin, end ) );
+	}
+
+	for( size_t i = 0; i < threads.size(); ++i )
+		threads[i].join();
+}
+
+void WarpColorLut::buildSlices( float *dst, const Settings &settings, const float *curve, int curveWidth, int begin, int end )
+{
+	const int size = settings.size;
+	const float step = 1.0f / ( size - 1 );
+
+	// same constants as the ContrastSaturationBrightness function of the warp shader
+	const glm::vec3 avgLumin( 0.5f, 0.5f, 0.5f );
+	const glm::vec3 lumCoeff( 0.2125f, 0.7154f, 0.0721f );
+
+	for( int b = begin; b < end; ++b ) {
+		for( int g = 0; g < size; ++g ) {
+			float *p = dst + ( size_t( b ) * size + g ) * size * 4;
+
+			for( int r = 0; r < size; ++r, p += 4 ) {
+				glm::vec3 color( r * step, g * step, b * step );
+
+				// brightness, saturation and contrast
+				glm::vec3 brtColor = color * settings.brightness;
+				float intensity = glm::dot( brtColor, lumCoeff );
+				glm::vec3 satColor = glm::vec3( intensity ) + ( brtColor - glm::vec3( intensity ) ) * settings.saturation;
+				glm::vec3 conColor = avgLumin + ( satColor - avgLumin ) * settings.contrast;
+
+				// projector matching
+				color = settings.matrix * conColor;
+
+				// user-supplied lut: a curve per channel, followed by a shared curve in the alpha channel
+				if( curve ) {
+					for( int c = 0; c < 3; ++c ) {
+						float v = sampleCurve( curve, curveWidth, c, color[c] * curveWidth );
+						color[c] = sampleCurve( curve, curveWidth, 3, v * curveWidth );
+					}
+				}
+
+				p[0] = color.x;
+				p[1] = color.y;
+				p[2] = color.z;
+				p[3] = 1.0f;
+			}
+		}
+	}
+}
+
+float WarpColorLut::sampleCurve( const float *curve, int width, int channel, float x )
+{
+	// texel centers are at i + 0.5, coordinates are clamped to the edge
+	float t = x - 0.5f;
+	int i0 = (int)std::floor( t );
+	float f = t - i0;
+
+	int i1 = std::max( 0, std::min( i0 + 1, width - 1 ) );
+	i0 = std::max( 0, std::min( i0, width - 1 ) );
+
+	return curve[i0 * 4 + channel] + f * ( curve[i1 * 4 + channel] - curve[i0 * 4 + channel] );
+}
+
+void WarpColorLut::apply( const float *lut, int size, const unsigned char *src, unsigned char *dst, size_t numPixels, int channels )
+{
+	if( channels < 3 ) return;
+
+	const float scale = ( size - 1 ) / 255.0f;
+	const size_t dr = 4;
+	const size_t dg = size_t( size ) * 4;
+	const size_t db = size_t( size ) * size * 4;
+
+	for( size_t i = 0; i < numPixels; ++i, src += channels, dst += channels ) {
+		float r = src[0] * scale;
+		float g = src[1] * scale;
+		float b = src[2] * scale;
+
+		// the upper corner is always valid, the fraction becomes 1 at the last entry
+		int r0 = std::min( (int)r, size - 2 );
+		int g0 = std::min( (int)g, size - 2 );
+		int b0 = std::min( (int)b, size - 2 );
+		float fr = r - r0;
+		float fg = g - g0;
+		float fb = b - b0;
+
+		const float *c000 = lut + b0 * db + g0 * dg + r0 * dr;
+
+#if defined(__SSE2__)
+		__m128 vr = _mm_set1_ps( fr );
+		__m128 vg = _mm_set1_ps( fg );
+		__m128 vb = _mm_set1_ps( fb );
+
+		__m128 c00 = _mm_loadu_ps( c000 );
+		__m128 c10 = _mm_loadu_ps( c000 + dg );
+		__m128 c01 = _mm_loadu_ps( c000 + db );
+		__m128 c11 = _mm_loadu_ps( c000 + db + dg );
+		c00 = _mm_add_ps( c00, _mm_mul_ps( vr, _mm_sub_ps( _mm_loadu_ps( c000 + dr ), c00 ) ) );
+		c10 = _mm_add_ps( c10, _mm_mul_ps( vr, _mm_sub_ps( _mm_loadu_ps( c000 + dg + dr ), c10 ) ) );
+		c01 = _mm_add_ps( c01, _mm_mul_ps( vr, _mm_sub_ps( _mm_loadu_ps( c000 + db + dr ), c01 ) ) );
+		c11 = _mm_add_ps( c11, _mm_mul_ps( vr, _mm_sub_ps( _mm_loadu_ps( c000 + db + dg + dr ), c11 ) ) );
+
+		__m128 c0 = _mm_add_ps( c00, _mm_mul_ps( vg, _mm_sub_ps( c10, c00 ) ) );
+		__m128 c1 = _mm_add_ps( c01, _mm_mul_ps( vg, _mm_sub_ps( c11, c01 ) ) );
+		__m128 c = _mm_add_ps( c0, _mm_mul_ps( vb, _mm_sub_ps( c1, c0 ) ) );
+
+		// scale, round and clamp to 8 bits
+		c = _mm_add_ps( _mm_mul_ps( c, _mm_set1_ps( 255.0f ) ), _mm_set1_ps( 0.5f ) );
+		c = _mm_min_ps( _mm_max_ps( c, _mm_setzero_ps() ), _mm_set1_ps( 255.0f ) );
+
+		float out[4];
+		_mm_storeu_ps( out, c );
+#else
+		float out[4];
+		for( int k = 0; k < 3; ++k ) {
+			float c00 = c000[k] + fr * ( c000[dr + k] - c000[k] );
+			float c10 = c000[dg + k] + fr * ( c000[dg + dr + k] - c000[dg + k] );
+			float c01 = c000[db + k] + fr * ( c000[db + dr + k] - c000[db + k] );
+			float c11 = c000[db + dg + k] + fr * ( c000[db + dg + dr + k] - c000[db + dg + k] );
+
+			float c0 = c00 + fg * ( c10 - c00 );
+			float c1 = c01 + fg * ( c11 - c01 );
+			float c = c0 + fb * ( c1 - c0 );
+
+			out[k] = std::min( std::max( c * 255.0f + 0.5f, 0.0f ), 255.0f );
+		}
+#endif
+
+		dst[0] = (unsigned char)out[0];
+		dst[1] = (unsigned char)out[1];
+		dst[2] = (unsigned char)out[2];
+		if( channels == 4 ) dst[3] = src[3];
+	}
+}
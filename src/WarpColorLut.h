@@ -0,0 +1,105 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "ofMain.h"
+
+//! Compiles the color pipeline of a warp (brightness, contrast, saturation, an optional color matrix and
+//! the user-supplied color lut) into a single 3D lut. The lut is only rebuilt when a parameter changes,
+//! so the shader only has to do a single trilinear lookup per pixel.
+class WarpColorLut {
+	public:
+		//! color parameters the lut is built from, applied in this order
+		typedef struct Settings {
+			int			size;
+			float		brightness;
+			float		contrast;
+			float		saturation;
+			glm::mat3	matrix;
+
+			Settings() : size(33), brightness(1.0f), contrast(1.0f), saturation(1.0f), matrix(1.0f) {}
+
+			bool operator==(const Settings &rhs) const {
+				return size == rhs.size && brightness == rhs.brightness && contrast == rhs.contrast
+					&& saturation == rhs.saturation && matrix == rhs.matrix;
+			}
+			bool operator!=(const Settings &rhs) const { return !(*this == rhs); }
+		} Settings;
+
+	public:
+		WarpColorLut();
+		virtual ~WarpColorLut(void);
+
+		//! set the user-supplied color lut texture (RGB curves in the color channels, a shared curve in alpha). Pass an empty texture to remove it.
+		void				setSource(const ofTexture &texture);
+		//! set the user-supplied color lut curves, one pixel per entry
+		void				setSource(const ofFloatPixels &pixels);
+
+		//! rebuilds the lut if the settings have changed, without uploading it. Does not use GL, so it can be called from any thread.
+		bool				prepare(const Settings &settings);
+		//! rebuilds and uploads the lut if the settings have changed, returns true if it was rebuilt
+		bool				update(const Settings &settings);
+		//! rebuilds the lut on the next prepare() or update(), and reads back the source texture again even if it is the same one
+		void				markDirty() { mSourceId = 0; mIsDirty = true; }
+
+		//! returns the id of the GL_TEXTURE_3D holding the lut
+		GLuint				getTextureId() const { return mTextureId; }
+		//! returns the number of entries along each axis
+		int					getSize() const { return mSettings.size; }
+		//! returns the lut as RGBA floats, red changes fastest
+		const std::vector<float>& getData() const { return mData; }
+		//! returns the number of times the lut has been rebuilt
+		int					getNumBuilds() const { return mNumBuilds; }
+
+		//! applies the lut to 8-bit RGB or RGBA pixels on the CPU, the pixels are split evenly over threads. Pixels with fewer than 3 channels are left untouched.
+		void				apply(const ofPixels &src, ofPixels &dst) const;
+
+		//! builds a lut of size^3 RGBA floats. If curve is not null, it holds curveWidth RGBA entries of the user-supplied lut.
+		//! Blue slices are spread over the specified number of threads (0 = hardware concurrency).
+		static void			build(float *dst, const Settings &settings, const float *curve = nullptr, int curveWidth = 0, unsigned numThreads = 0);
+		//! applies a lut to 8-bit RGB or RGBA pixels with trilinear interpolation, using SSE when available. Does nothing for fewer than 3 channels.
+		static void			apply(const float *lut, int size, const unsigned char *src, unsigned char *dst, size_t numPixels, int channels);
+
+	protected:
+		//! builds the blue slices [begin, end) of the lut
+		static void			buildSlices(float *dst, const Settings &settings, const float *curve, int curveWidth, int begin, int end);
+		//! samples a channel of the user-supplied curve like a linearly filtered rectangle texture
+		static float		sampleCurve(const float *curve, int width, int channel, float x);
+
+	private:
+		WarpColorLut(const WarpColorLut&);
+		WarpColorLut& operator=(const WarpColorLut&);
+
+	protected:
+		Settings			mSettings;
+		bool				mIsDirty;
+
+		ofFloatPixels		mSource;
+		GLuint				mSourceId;
+
+		std::vector<float>	mData;
+		GLuint				mTextureId;
+		//! set if the lut was rebuilt but not uploaded yet
+		bool				mIsUploadPending;
+
+		int					mNumBuilds;
+};
@@ -21,11 +21,16 @@
  */
 
 #include "Warp.h"
-#define STRINGIFY(A) #A
 
 WarpPerspective::WarpPerspective( void )
 	: Warp( PERSPECTIVE )
+	, mSourceYuv( nullptr )
 {
+	mUniforms.setSampler( "uTex0", 0 );
+	mUniforms.setSampler( "uBlendMask", 2 );
+	mUniforms.setSampler( "uTexU", WarpYuv::UNIT_U );
+	mUniforms.setSampler( "uTexV", WarpYuv::UNIT_V );
+
 	mSource[0].x = 0.0f;
 	mSource[0].y = 0.0f;
 	mSource[1].x = (float)mWidth;
@@ -86,10 +91,14 @@ void WarpPerspective::reset()
 
 void WarpPerspective::bind()
 {
+	if( mFbo && mFbo->isAllocated() )
+		mFbo->getTexture().bind();
 }
 
 void WarpPerspective::unbind()
 {
+	if( mFbo && mFbo->isAllocated() )
+		mFbo->getTexture().unbind();
 }
 
 void WarpPerspective::draw( const ofTexture &texture, const ofRectangle &srcArea, const ofRectangle &destRect )
@@ -99,70 +108,192 @@ void WarpPerspective::draw( const ofTexture &texture, const ofRectangle &srcArea
 	ofRectangle	rect = destRect;
 	clip( area, rect );
 
-	// save current drawing color
-	
-	//FIX
-	//const ofColor &currentColor = gl::context()->getCurrentColor();
-	//gl::ScopedColor color( currentColor );
-	const ofColor currentColor = ofColor(255);
-
-	// adjust brightness
-	if (mBrightness < 1.f) {
-		ofColor drawColor = ofColor(mBrightness * currentColor.r, mBrightness * currentColor.g, mBrightness * currentColor.b);
-		drawColor.a = currentColor.a;
-		ofSetColor(drawColor);
-	}
+	// select the shader variant with only the features this warp uses
+	GLenum target = texture.getTextureData().textureTarget;
+	unsigned features = getShaderFeatures( target );
+	if( mSourceYuv )
+		features |= ( mSourceYuv->format == WarpYuv::I420 ) ? WarpShaderCache::YUV_I420 : WarpShaderCache::YUV_NV12;
 
-	// create shader if necessary
 	createShader();
+	mShader = mShaders.get( features );
+
+	// bake the blend mask, only if any of its parameters have changed
+	if( features & WarpShaderCache::BLEND_MASK ) {
+		mBlendMask.setSource( blendTexture );
+		mBlendMask.update( getBlendSettings() );
+	}
+
+	// rectangle textures are sampled in pixels, 2D textures in normalized coordinates
+	float w = 1.0f;
+	float h = 1.0f;
+	if( target != GL_TEXTURE_RECTANGLE_ARB ) {
+		w = texture.getWidth();
+		h = texture.getHeight();
+	}
+
+	// the shader applies the transform, so the quad is specified in content space
+	mMesh.clear();
+	mMesh.addVertex( ofVec3f( rect.getLeft(), rect.getTop(), 0 ) );
+	mMesh.addVertex( ofVec3f( rect.getRight(), rect.getTop(), 0 ) );
+	mMesh.addVertex( ofVec3f( rect.getRight(), rect.getBottom(), 0 ) );
+	mMesh.addVertex( ofVec3f( rect.getLeft(), rect.getBottom(), 0 ) );
+	mMesh.addTexCoord( ofVec2f( area.getLeft() / w, area.getTop() / h ) );
+	mMesh.addTexCoord( ofVec2f( area.getRight() / w, area.getTop() / h ) );
+	mMesh.addTexCoord( ofVec2f( area.getRight() / w, area.getBottom() / h ) );
+	mMesh.addTexCoord( ofVec2f( area.getLeft() / w, area.getBottom() / h ) );
+	mMesh.addIndex( 0 ); mMesh.addIndex( 1 ); mMesh.addIndex( 2 );
+	mMesh.addIndex( 0 ); mMesh.addIndex( 2 ); mMesh.addIndex( 3 );
+
+	// the transform follows the corners, the block only uploads it if it has changed
+	mUniforms.set( 0, getTransform() );
+
+	// write the parameters to the uniform block, only if any of them have changed
+	if( mIsUniformsDirty ) {
+		mUniforms.set( 4, glm::vec4( float( mWidth ), float( mHeight ), mBrightness, 0.0f ) );
+		mIsUniformsDirty = false;
+	}
 
 	// draw texture
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-	ofMultMatrix( toOf(getTransform()) );
-
-	//texture.bind();
-
-    //mShader->begin();
-       // mShader->setUniform3f( "uLuminance", mLuminance );
-       // mShader->setUniform3f( "uGamma", mGamma );
-       // mShader->setUniform4f( "uEdges", mEdges );
-       // mShader->setUniform1f( "uExponent", mExponent );
-
-	//FIX
-	//auto coords = texture->getAreaTexCoords( srcArea );
-	//gl::drawSolidRect( rect, coords.getUpperLeft(), coords.getLowerRight() );
-	
-    ofDrawRectangle(rect);
-	
-    //mShader->end();    
-    glPopMatrix();
+	ofSetColor( 255 );
+	texture.bind( 0 );
+	if( features & WarpShaderCache::BLEND_MASK )
+		mBlendMask.getTexture().bind( 2 );
+	if( mSourceYuv )
+		WarpYuv::bind( *mSourceYuv );
+	mShader->begin();
+		mUniforms.bind( *mShader );
+		mMesh.draw();
+		mUniforms.unbind();
+	mShader->end();
+	if( mSourceYuv )
+		WarpYuv::unbind( *mSourceYuv );
+	if( features & WarpShaderCache::BLEND_MASK )
+		mBlendMask.getTexture().unbind( 2 );
+	texture.unbind( 0 );
 
 	// draw interface
 	draw();
 }
 
+void WarpPerspective::draw( const WarpYuv::Textures &frame, const ofRectangle &srcArea, const ofRectangle &destRect )
+{
+	if( !frame.isAllocated() ) return;
+
+	// the luma plane is drawn like any texture, the shader fetches the chroma planes at the same coordinates
+	mSourceYuv = &frame;
+	draw( *frame.y, srcArea, destRect );
+	mSourceYuv = nullptr;
+}
+
+void WarpPerspective::setSize( int w, int h )
+{
+	Warp::setSize( w, h );
+
+	// a shared frame buffer region no longer fits the content
+	if( !mContentRegion.isEmpty() )
+		setContentFbo( nullptr, ofRectangle() );
+}
+
+void WarpPerspective::setContentArea( const ofRectangle &area )
+{
+	ofRectangle previous = getContentArea();
+	Warp::setContentArea( area );
+
+	// a shared frame buffer region no longer fits the content area
+	if( getContentArea() != previous && !mContentRegion.isEmpty() )
+		setContentFbo( nullptr, ofRectangle() );
+}
+
+void WarpPerspective::getMesh( ofMesh &mesh )
+{
+	mesh.clear();
+
+	// the content quad, transformed like the shader does
+	const glm::vec2 corners[4] = { glm::vec2( 0, 0 ), glm::vec2( 1, 0 ), glm::vec2( 1, 1 ), glm::vec2( 0, 1 ) };
+	glm::mat4x4 transform = getTransform();
+
+	for( int i = 0; i < 4; ++i ) {
+		glm::vec4 pt = transform * glm::vec4( corners[i].x * mWidth, corners[i].y * mHeight, 0, 1 );
+
+		// store the projected position and keep w as the q coordinate
+		float w = ( pt.w != 0 ) ? 1 / pt.w : 0;
+		mesh.addVertex( glm::vec3( pt.x * w, pt.y * w, pt.w ) );
+		mesh.addTexCoord( corners[i] );
+	}
+
+	mesh.addIndex( 0 ); mesh.addIndex( 1 ); mesh.addIndex( 2 );
+	mesh.addIndex( 0 ); mesh.addIndex( 2 ); mesh.addIndex( 3 );
+}
+
+void WarpPerspective::prepare()
+{
+	// the same condition as the BLEND_MASK shader feature, a user-supplied mask is only known when drawing
+	if( mEdges != ofVec4f( 0.0f ) )
+		mBlendMask.prepare( getBlendSettings() );
+}
+
+void WarpPerspective::setContentFbo( const shared_ptr<ofFbo> &fbo, const ofRectangle &region )
+{
+	mFbo = fbo;
+	mContentRegion = fbo ? region : ofRectangle();
+	mIsContentDirty = true;
+}
+
 void WarpPerspective::begin()
 {
-	glMatrixMode(GL_MODELVIEW);
-    ofPushMatrix();
-	ofMultMatrix(toOf(getTransform()));
+	// render into our region of a shared frame buffer
+	if( !mContentRegion.isEmpty() ) {
+		if( !mFbo || !mFbo->isAllocated() ) return;
+		mFbo->begin();
+		beginContentRegion();
+		return;
+	}
+
+	// check if the FBO was created and is of the correct size
+	if( !mFbo ) {
+		mFbo = make_shared<ofFbo>();
+	}
+	// only allocate the area of the content we display
+	ofRectangle area = getContentArea();
+	if( !mFbo->isAllocated() || mFbo->getWidth() != area.width || mFbo->getHeight() != area.height ) {
+		try {
+			mFbo->allocate( (int)area.width, (int)area.height );
+		}
+		catch( ... ) {
+			return;
+		}
+	}
+
+	mFbo->begin();
+	ofClear( 255 );
+	beginContentArea();
 }
 
 void WarpPerspective::end()
 {
-	// restore warp
-    ofPopMatrix();
+	if( !mFbo || !mFbo->isAllocated() ) return;
 
-	// draw interface
-	draw();
+	if( !mContentRegion.isEmpty() )
+		endContentRegion();
+	mFbo->end();
+	setContentRendered();
+
+	redraw();
+}
+
+void WarpPerspective::redraw()
+{
+	if( !mFbo || !mFbo->isAllocated() ) return;
+
+	// draw warped and blended content
+	ofRectangle area = mContentRegion.isEmpty() ? ofRectangle( 0, 0, mFbo->getWidth(), mFbo->getHeight() ) : mContentRegion;
+	draw( mFbo->getTexture(), area, ofRectangle( getBounds() ) );
 }
 
 void WarpPerspective::draw( bool controls )
 {
 	// only draw grid while editing
 	if( isEditModeEnabled() ) {
-		glMatrixMode(GL_MODELVIEW);
         ofPushMatrix();
         
 		ofMultMatrix(toOf(getTransform()));
@@ -331,68 +462,78 @@ void WarpPerspective::gaussianElimination( float *a, int n ) const
 	}
 }
 
+unsigned WarpPerspective::getShaderFeatures( GLenum textureTarget ) const
+{
+	unsigned features = 0;
+
+	if( mEdges != ofVec4f( 0.0f ) || blendTexture.isAllocated() )
+		features |= WarpShaderCache::BLEND_MASK;
+	if( textureTarget != GL_TEXTURE_RECTANGLE_ARB )
+		features |= WarpShaderCache::TEXTURE_2D;
+
+	return features;
+}
+
 void WarpPerspective::createShader()
 {
-	if( mShader)
+	if( mShaders.hasSource() )
 		return;
 
-	static string VertShader = STRINGIFY(
-		'#version 150'
-		uniform mat4 ciModelViewProjection;
+	// parameters shared by the vertex and fragment shader, see WarpPerspective::draw()
+	static string UniformBlock = R"END(
+		layout(std140) uniform WarpUniforms {
+			mat4 uTransform;
+			vec4 uParams;		// width, height, brightness
+		};
+	)END";
 
-		in vec4 ciPosition;
-		in vec2 ciTexCoord0;
-		in vec4 ciColor;
+	static string VertShader = R"END(
+		uniform mat4 modelViewProjectionMatrix;
+
+		in vec4 position;
+		in vec2 texcoord;
 
 		out vec2 vertTexCoord0;
-		out vec4 vertColor;
+		out vec2 vertBlendCoord;
 
 		void main( void )
 		{
-			vertColor = ciColor;
-			vertTexCoord0 = ciTexCoord0;
+			vertTexCoord0 = texcoord;
+			vertBlendCoord = position.xy / uParams.xy;
 
-			gl_Position = ciModelViewProjection * ciPosition;
+			// the homography produces a w coordinate, so the texture is interpolated perspective correct
+			gl_Position = modelViewProjectionMatrix * ( uTransform * position );
 		}
-	);
-	static string FragShader = STRINGIFY(
-        '#version 150'
+	)END";
 
-		uniform sampler2D  uTex0;
-		uniform vec3       uLuminance;
-		uniform vec3       uGamma;
-		uniform vec4       uEdges;
-		uniform float      uExponent;
+	static string FragShader = R"END(
+		uniform SAMPLER    uTex0;
+#ifdef USE_BLEND_MASK
+		uniform sampler2D  uBlendMask;
+#endif
 
 		in vec2 vertTexCoord0;
-		in vec4 vertColor;
+		in vec2 vertBlendCoord;
 
-		out vec4 fragColor;
+		out vec4 outputColor;
 
 		void main( void )
 		{
+#ifdef USE_YUV
+			vec4 texColor = sampleYuv( uTex0, vertTexCoord0 );
+#else
 			vec4 texColor = texture( uTex0, vertTexCoord0 );
+#endif
+			texColor.rgb *= uParams.z;
 
-			float a = 1.0;
-			if( uEdges.x > 0.0 ) a *= clamp( vertTexCoord0.x / uEdges.x, 0.0, 1.0 );
-			if( uEdges.y > 0.0 ) a *= clamp( vertTexCoord0.y / uEdges.y, 0.0, 1.0 );
-			if( uEdges.z > 0.0 ) a *= clamp( ( 1.0 - vertTexCoord0.x ) / uEdges.z, 0.0, 1.0 );
-			if( uEdges.w > 0.0 ) a *= clamp( ( 1.0 - vertTexCoord0.y ) / uEdges.w, 0.0, 1.0 );
-
-			const vec3 one = vec3( 1.0 );
-			vec3 blend = ( a < 0.5 ) ? ( uLuminance * pow( 2.0 * a, uExponent ) )
-				: one - ( one - uLuminance ) * pow( 2.0 * ( 1.0 - a ), uExponent );
+#ifdef USE_BLEND_MASK
+			// edge blending and gamma are baked into the blend mask
+			texColor.rgb *= texture( uBlendMask, vertBlendCoord ).rgb;
+#endif
 
-			texColor.rgb *= pow( blend, one / uGamma );
-
-			fragColor = texColor;
+			outputColor = texColor;
 		}
-	);
-	try {
-		mShader->load(VertShader, FragShader);
-	}
-	catch( const std::exception &e ) {
-		cout << e.what() << std::endl;
-	}
-}
+	)END";
 
+	mShaders.setSource( UniformBlock + VertShader, UniformBlock + WarpYuv::getShaderSource() + FragShader );
+}
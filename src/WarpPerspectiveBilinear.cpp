@@ -24,6 +24,9 @@
 
 WarpPerspectiveBilinear::WarpPerspectiveBilinear()
 	: WarpBilinear()
+	, mIsScreenDirty( true )
+	, mIsTransformBaked( false )
+	, mBakedTransform( 1.0f )
 {
 	// change type 
 	mType = PERSPECTIVE_BILINEAR;
@@ -48,8 +51,8 @@ ofXml WarpPerspectiveBilinear::toXml() const
 		ofXml cp;
         cp.addChild( "corner" );
 		cp.setTo( "corner" );
-		cp.setAttribute( "x", ofToString(corner.x) );
-		cp.setAttribute( "y", ofToString(corner.y) );
+		cp.setAttribute( "x", toString(corner.x) );
+		cp.setAttribute( "y", toString(corner.y) );
 
 		xml.addXml( cp );
 	}
@@ -60,32 +63,59 @@ ofXml WarpPerspectiveBilinear::toXml() const
 void WarpPerspectiveBilinear::fromXml( ofXml &xml )
 {
 	WarpBilinear::fromXml( xml );
-	unsigned i = 0;
-    if (xml.exists("corner")){
-        
-        int cornerChildren = xml.getNumChildren("corner");
-        
-        for(int i=0; i<cornerChildren; i++){
-            string s = ofToString(i);
-            float x = xml.getFloatValue("corner["+s+"][@x]");
-            float y = xml.getFloatValue("corner["+s+"][@y]");
-			mWarp->setControlPoint(i, ofVec2f(x, y));
-        }
-    }
+
+	// older files have the corners inside <blend>
+	bool inBlend = !xml.exists("corner") && xml.exists("blend");
+	if (inBlend) xml.setTo("blend");
+
+	// visit the children once, instead of looking up each corner by path
+	unsigned index = 0;
+	int children = xml.getNumChildren();
+	for( int i = 0; i < children; i++ ) {
+		xml.setToChild( i );
+		if( xml.getName() == "corner" ) {
+			float x = ofToFloat( xml.getAttribute( "x" ) );
+			float y = ofToFloat( xml.getAttribute( "y" ) );
+			mWarp->setControlPoint( index++, glm::vec2( x, y ) );
+		}
+		xml.setToParent();
+	}
+
+	if (inBlend) xml.setToParent();
+
+	mIsScreenDirty = true;
+}
+
+void WarpPerspectiveBilinear::readXml( std::string_view name, unsigned index, const WarpXmlReader::Attributes &attributes )
+{
+	WarpBilinear::readXml( name, index, attributes );
+
+	if( name == "corner" )
+		mWarp->setControlPoint( index, glm::vec2( attributes.getFloat( "x" ), attributes.getFloat( "y" ) ) );
+
+	mIsScreenDirty = true;
 }
 
 void WarpPerspectiveBilinear::draw( bool controls )
 {
-	// apply perspective transform
-    glMatrixMode(GL_MODELVIEW);
-    ofPushMatrix();
-    ofMultMatrix(toOf( mWarp->getTransform()) );
-    
-	// draw bilinear warp
-	WarpBilinear::draw( false );
+	if( mIsTransformBaked ) {
+		// regenerate the mesh if the corners have moved
+		updateBuffers();
+
+		// draw bilinear warp, the perspective transform is part of the mesh
+		WarpBilinear::draw( false );
+	}
+	else {
+		// apply perspective transform
+		ofPushMatrix();
+		ofMultMatrix(toOf( getTransform()) );
 
-	// restore transform
-    ofPopMatrix();
+		// draw bilinear warp
+		WarpBilinear::draw( false );
+
+		// restore transform
+		ofPopMatrix();
+	}
     
 	// draw edit interface
 	if( isEditModeEnabled() ) {
@@ -101,6 +131,53 @@ void WarpPerspectiveBilinear::draw( bool controls )
 	}
 }
 
+bool WarpPerspectiveBilinear::updateBuffers()
+{
+	if( mIsTransformBaked ) {
+		// the mesh depends on the corners, regenerate it if the transform has changed
+		glm::mat4 transform = getTransform();
+		if( transform != mBakedTransform ) {
+			mBakedTransform = transform;
+			mIsDirty = true;
+		}
+	}
+
+	return WarpBilinear::updateBuffers();
+}
+
+void WarpPerspectiveBilinear::getMesh( ofMesh &mesh )
+{
+	WarpBilinear::getMesh( mesh );
+	if( mIsTransformBaked ) return;
+
+	// apply the transform that is otherwise on the matrix stack while drawing
+	glm::mat4x4 transform = getTransform();
+
+	std::vector<glm::vec3> &vertices = mesh.getVertices();
+	for( size_t i = 0; i < vertices.size(); ++i ) {
+		const glm::vec3 &v = vertices[i];
+		glm::vec4 pt = transform * glm::vec4( v.x * v.z, v.y * v.z, 0, v.z );
+
+		float w = ( pt.w != 0 ) ? 1 / pt.w : 0;
+		vertices[i] = glm::vec3( pt.x * w, pt.y * w, pt.w );
+	}
+}
+
+glm::vec3 WarpPerspectiveBilinear::projectVertex( const glm::vec2 &p ) const
+{
+	if( !mIsTransformBaked )
+		return WarpBilinear::projectVertex( p );
+
+	// updateBuffers() stored the transform before updating the mesh
+	glm::vec4 pt = mBakedTransform * glm::vec4( p.x, p.y, 0, 1 );
+
+	// store the projected position and keep w as the q coordinate for perspective correct texturing
+	float q = pt.w;
+	if( pt.w != 0 ) pt.w = 1 / pt.w;
+
+	return glm::vec3( pt.x * pt.w, pt.y * pt.w, q );
+}
+
 void WarpPerspectiveBilinear::mouseMove( ofMouseEventArgs &event )
 {
 	mWarp->mouseMove( event );
@@ -167,6 +244,9 @@ void WarpPerspectiveBilinear::keyDown( ofKeyEventArgs &event )
 		WarpBilinear::keyDown( event );
 		break;
 	}
+
+	// cursor keys, flipping and changing the number of control points all modify the bilinear points
+	mIsScreenDirty = true;
 }
 
 void WarpPerspectiveBilinear::resize()
@@ -177,29 +257,25 @@ void WarpPerspectiveBilinear::resize()
 	//WarpBilinear::resize();
 }
 
+void WarpPerspectiveBilinear::reset()
+{
+	WarpBilinear::reset();
+	mIsScreenDirty = true;
+}
+
 void WarpPerspectiveBilinear::setSize( int w, int h )
 {
 	mWarp->setSize( w, h );
 	WarpBilinear::setSize( w, h );
+	mIsScreenDirty = true;
 }
 
 glm::vec2 WarpPerspectiveBilinear::getControlPoint( unsigned index ) const
 {
-	// depending on index, return perspective or bilinear control point
-	if( isCorner( index ) ) {
-		// perspective: simply return one of the corners
-		return mWarp->getControlPoint( convertIndex( index ) );
-	}
-	else {
-		// bilinear: transform control point from warped space to normalized screen space
-		ofVec2f p = Warp::getControlPoint( index ) * ofVec2f( mWarp->getSize() );
-		glm::vec4 pt = mWarp->getTransform() * glm::vec4( p.x, p.y, 0, 1 );
+	updateScreenPoints();
 
-		if( pt.w != 0 ) pt.w = 1 / pt.w;
-		pt *= pt.w;
-
-		return ofVec2f( pt.x, pt.y ) / mWindowSize;
-	}
+	if( index >= mScreenPoints.size() ) return glm::vec2( 0 );
+	return mScreenPoints[index];
 }
 
 void WarpPerspectiveBilinear::setControlPoint( unsigned index, const glm::vec2 &pos )
@@ -219,7 +295,7 @@ void WarpPerspectiveBilinear::setControlPoint( unsigned index, const glm::vec2 &
 
 		ofVec2f size( mWarp->getSize() );
 		Warp::setControlPoint( index, ofVec2f( pt.x, pt.y ) / size );
-                
+		mIsScreenDirty = true;
 	}
 }
 
@@ -273,3 +349,43 @@ unsigned WarpPerspectiveBilinear::convertIndex( unsigned index ) const
 	else if( index == ( mControlsY - 1 ) ) return 3;
 	else return index;
 }
+
+glm::mat4 WarpPerspectiveBilinear::getTransform() const
+{
+	// a dirty perspective warp means one of the corners has moved
+	if( mWarp->mIsDirty )
+		mIsScreenDirty = true;
+
+	return mWarp->getTransform();
+}
+
+void WarpPerspectiveBilinear::updateScreenPoints() const
+{
+	glm::mat4 transform = getTransform();
+
+	if( !mIsScreenDirty && mScreenPoints.size() == mPoints.size() )
+		return;
+
+	ofVec2f size( mWarp->getSize() );
+	mScreenPoints.resize( mPoints.size() );
+
+	for( unsigned i = 0; i < mPoints.size(); ++i ) {
+		// depending on index, use perspective or bilinear control point
+		if( isCorner( i ) ) {
+			// perspective: simply use one of the corners
+			mScreenPoints[i] = mWarp->getControlPoint( convertIndex( i ) );
+		}
+		else {
+			// bilinear: transform control point from warped space to normalized screen space
+			ofVec2f p = mPoints[i] * size;
+			glm::vec4 pt = transform * glm::vec4( p.x, p.y, 0, 1 );
+
+			if( pt.w != 0 ) pt.w = 1 / pt.w;
+			pt *= pt.w;
+
+			mScreenPoints[i] = ofVec2f( pt.x, pt.y ) / mWindowSize;
+		}
+	}
+
+	mIsScreenDirty = false;
+}
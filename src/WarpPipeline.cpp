@@ -0,0 +1,243 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarpPipeline.h"
+
+#include <chrono>
+
+//! returns a monotonic time stamp in microseconds
+static uint64_t getTimeMicros()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+WarpPipeline::WarpPipeline()
+	: mLutSize( 0 )
+	, mNextIndex( 0 )
+	, mIsStopping( false )
+	, mNumFrames( 0 )
+	, mStartTime( 0 )
+	, mEndTime( 0 )
+{
+	for( int i = 0; i < NUM_STAGES; ++i )
+		mBusyTime[i] = 0;
+}
+
+WarpPipeline::~WarpPipeline()
+{
+	stop();
+}
+
+bool WarpPipeline::start( Warp &warp, const Source &source, const Sink &sink, const Settings &settings )
+{
+	if( isRunning() ) return false;
+
+	mSource = source;
+	mSink = sink;
+	mSettings = settings;
+	mSettings.numFrames = std::max( size_t( 2 ), settings.numFrames );
+
+	// bake the geometry and the blend weights once, the stages only resample
+	mRemap.bake( warp, settings.width, settings.height, true );
+
+	const float *weights = mRemap.getWeights().getData();
+	mWeights.resize( size_t( mRemap.getWidth() ) * mRemap.getHeight() * 3 );
+	for( size_t i = 0; i < mWeights.size(); ++i )
+		mWeights[i] = uint16_t( weights[i] * 256.0f + 0.5f );
+
+	// the same color pipeline as the warp shader, skipped if it is neutral
+	WarpColorLut::Settings color;
+	color.brightness = warp.getBrightness();
+	color.contrast = warp.getContrast();
+	color.saturation = warp.getSaturation();
+	color.matrix = warp.getColorMatrix();
+
+	mLut.clear();
+	mLutSize = color.size;
+	if( color != WarpColorLut::Settings() ) {
+		mLut.resize( size_t( color.size ) * color.size * color.size * 4 );
+		WarpColorLut::build( &mLut[0], color );
+	}
+
+	// every queue can hold all frames and the end of stream marker, so pushing never has to wait
+	for( int i = 0; i < NUM_STAGES; ++i )
+		mQueues[i].reset( new Queue( mSettings.numFrames + 1 ) );
+
+	if( mPool.size() != mSettings.numFrames ) {
+		mPool.clear();
+		for( size_t i = 0; i < mSettings.numFrames; ++i )
+			mPool.push_back( std::unique_ptr<Frame>( new Frame() ) );
+	}
+
+	for( size_t i = 0; i < mPool.size(); ++i )
+		mQueues[DECODE]->push( mPool[i].get() );
+
+	mIsStopping = false;
+	mNextIndex = 0;
+	mNumFrames = 0;
+	for( int i = 0; i < NUM_STAGES; ++i )
+		mBusyTime[i] = 0;
+	mStartTime = getTimeMicros();
+	mEndTime = 0;
+
+	for( int i = 0; i < NUM_STAGES; ++i )
+		mThreads.push_back( std::thread( &WarpPipeline::run, this, Stage( i ) ) );
+
+	return true;
+}
+
+void WarpPipeline::stop()
+{
+	mIsStopping = true;
+	wait();
+}
+
+void WarpPipeline::wait()
+{
+	for( size_t i = 0; i < mThreads.size(); ++i )
+		mThreads[i].join();
+	mThreads.clear();
+
+	if( mEndTime == 0 && mStartTime != 0 )
+		mEndTime = getTimeMicros();
+}
+
+WarpPipeline::Stats WarpPipeline::getStats() const
+{
+	Stats stats;
+	stats.numFrames = mNumFrames;
+
+	uint64_t end = mEndTime ? mEndTime.load() : getTimeMicros();
+	double seconds = ( end - mStartTime ) * 1e-6;
+	stats.framesPerSecond = ( seconds > 0.0 ) ? stats.numFrames / seconds : 0.0;
+
+	for( int i = 0; i < NUM_STAGES; ++i ) {
+		stats.queueDepth[i] = mQueues[i] ? mQueues[i]->size() : 0;
+		stats.maxQueueDepth[i] = mQueues[i] ? mQueues[i]->getMaxSize() : 0;
+		stats.busyTime[i] = mBusyTime[i] * 1e-6;
+	}
+
+	return stats;
+}
+
+void WarpPipeline::run( Stage stage )
+{
+	Queue &input = *mQueues[stage];
+	Queue &output = *mQueues[( stage + 1 ) % NUM_STAGES];
+
+	// the decode stage takes free frames, the output stage returns them
+	Frame *frame = nullptr;
+	while( pop( input, frame ) ) {
+		// end of the stream, pass it on
+		if( !frame ) {
+			if( stage == OUTPUT )
+				mEndTime = getTimeMicros();
+			else
+				push( output, nullptr );
+			return;
+		}
+
+		uint64_t begin = getTimeMicros();
+		bool ok = process( stage, frame );
+		mBusyTime[stage] += getTimeMicros() - begin;
+
+		if( !ok ) {
+			push( output, nullptr );
+			return;
+		}
+
+		push( output, frame );
+	}
+}
+
+bool WarpPipeline::process( Stage stage, Frame *frame )
+{
+	switch( stage ) {
+		case DECODE:
+			frame->index = mNextIndex;
+			if( !mSource( frame->content, frame->index ) )
+				return false;
+			mNextIndex++;
+			break;
+		case REMAP:
+			mRemap.apply( frame->content, frame->output, mSettings.numRemapThreads );
+			break;
+		case BLEND:
+			blend( frame->output );
+			break;
+		case OUTPUT:
+			mSink( frame->output, frame->index );
+			mNumFrames++;
+			break;
+		default:
+			break;
+	}
+
+	return true;
+}
+
+void WarpPipeline::blend( ofPixels &pixels ) const
+{
+	size_t numPixels = pixels.getWidth() * pixels.getHeight();
+	if( numPixels * 3 != mWeights.size() ) return;
+
+	unsigned char *data = pixels.getData();
+
+	if( !mLut.empty() )
+		WarpColorLut::apply( &mLut[0], mLutSize, data, data, numPixels, 4 );
+
+	const uint16_t *weight = &mWeights[0];
+	for( size_t i = 0; i < numPixels; ++i, data += 4, weight += 3 ) {
+		data[0] = (unsigned char)( ( data[0] * weight[0] + 128 ) >> 8 );
+		data[1] = (unsigned char)( ( data[1] * weight[1] + 128 ) >> 8 );
+		data[2] = (unsigned char)( ( data[2] * weight[2] + 128 ) >> 8 );
+	}
+}
+
+bool WarpPipeline::pop( Queue &queue, Frame *&frame )
+{
+	// spin briefly, then sleep so an idle stage doesn't take a core
+	for( int spins = 0; !queue.pop( frame ); ++spins ) {
+		if( mIsStopping ) return false;
+
+		if( spins < 64 )
+			std::this_thread::yield();
+		else
+			std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+	}
+
+	return true;
+}
+
+bool WarpPipeline::push( Queue &queue, Frame *frame )
+{
+	for( int spins = 0; !queue.push( frame ); ++spins ) {
+		if( mIsStopping ) return false;
+
+		if( spins < 64 )
+			std::this_thread::yield();
+		else
+			std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+	}
+
+	return true;
+}
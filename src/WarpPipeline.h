@@ -0,0 +1,131 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "WarpRemap.h"
+#include "WarpRing.h"
+
+#include <thread>
+
+//! Warps a continuous stream of frames on the CPU, for headless recording nodes. Each stage runs on its own thread:
+//! decode (user callback) -> remap -> blend (color lut and edge blending) -> output (user callback). Stages are
+//! connected by bounded lock-free queues and frames are recycled from a fixed pool, so nothing is allocated per frame
+//! once the stream is running. The warp is baked with WarpRemap, from the same mesh the warp draws on the GPU.
+class WarpPipeline {
+	public:
+		//! fills the content pixels (RGBA) of the frame with the specified index, returns false at the end of the stream
+		typedef std::function<bool(ofPixels &content, uint64_t index)>			Source;
+		//! receives the warped output of the frame with the specified index, the pixels are recycled after it returns
+		typedef std::function<void(const ofPixels &output, uint64_t index)>		Sink;
+
+		typedef struct Settings {
+			//! output size, 0 = output size of the warp (see Warp::getWindowSize())
+			int			width;
+			int			height;
+			//! number of frames in flight, which is also the capacity of each queue
+			size_t		numFrames;
+			//! number of threads used by the remap stage, the slowest stage
+			unsigned	numRemapThreads;
+
+			Settings() : width(0), height(0), numFrames(4), numRemapThreads(1) {}
+		} Settings;
+
+		//! stages of the pipeline
+		typedef enum { DECODE, REMAP, BLEND, OUTPUT, NUM_STAGES } Stage;
+
+		typedef struct Stats {
+			//! number of frames that have left the pipeline
+			uint64_t	numFrames;
+			//! frames per second since the pipeline was started
+			double		framesPerSecond;
+			//! number of frames waiting in front of each stage, and the most that have been waiting
+			size_t		queueDepth[NUM_STAGES];
+			size_t		maxQueueDepth[NUM_STAGES];
+			//! time each stage has spent working, in seconds
+			double		busyTime[NUM_STAGES];
+		} Stats;
+
+	public:
+		WarpPipeline();
+		virtual ~WarpPipeline(void);
+
+		//! bakes the warp and starts the stage threads, returns false if the pipeline is already running
+		bool				start(Warp &warp, const Source &source, const Sink &sink, const Settings &settings = Settings());
+		//! stops all stages without waiting for the remaining frames
+		void				stop();
+		//! waits until the source has ended and all frames have been output
+		void				wait();
+		//! returns true while the stage threads are running
+		bool				isRunning() const { return !mThreads.empty(); }
+
+		//! returns throughput and queue depths, can be called while running
+		Stats				getStats() const;
+
+	protected:
+		//! a frame from the pool, the content and output buffers are reused
+		typedef struct Frame {
+			ofPixels	content;
+			ofPixels	output;
+			uint64_t	index;
+		} Frame;
+
+		typedef WarpRing<Frame*>	Queue;
+
+		//! runs a stage until the end of the stream, passing frames from its input queue to its output queue
+		void				run(Stage stage);
+		//! processes a single frame, returns false if the source has ended
+		bool				process(Stage stage, Frame *frame);
+		//! multiplies the output with the color lut and the blend weights, in place
+		void				blend(ofPixels &pixels) const;
+
+		//! waits for an element of a queue, returns false if the pipeline was stopped
+		bool				pop(Queue &queue, Frame *&frame);
+		//! waits for space in a queue, returns false if the pipeline was stopped
+		bool				push(Queue &queue, Frame *frame);
+
+	protected:
+		Source								mSource;
+		Sink								mSink;
+		Settings							mSettings;
+
+		WarpRemap							mRemap;
+		//! color pipeline of the warp, empty if it is neutral
+		std::vector<float>					mLut;
+		int									mLutSize;
+		//! edge blending weights in 8.8 fixed point, RGB per pixel
+		std::vector<uint16_t>				mWeights;
+
+		std::vector<std::unique_ptr<Frame>>	mPool;
+		//! input queue of each stage, the decode stage takes recycled frames
+		std::unique_ptr<Queue>				mQueues[NUM_STAGES];
+
+		//! index of the next decoded frame, only used by the decode stage
+		uint64_t							mNextIndex;
+
+		std::vector<std::thread>			mThreads;
+		std::atomic<bool>					mIsStopping;
+		std::atomic<uint64_t>				mNumFrames;
+		//! busy time of each stage in microseconds
+		std::atomic<uint64_t>				mBusyTime[NUM_STAGES];
+		uint64_t							mStartTime;
+		std::atomic<uint64_t>				mEndTime;
+};
@@ -0,0 +1,381 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarpProfiles.h"
+#include "WarpSaver.h"
+
+#include <filesystem>
+
+//! Builds warps from the elements of a settings file: <warpconfig> <profile> <map> <warp>. Only the first child of
+//! each map is used, like the original document based reader.
+class WarpProfileHandler : public WarpXmlReader::Handler {
+	public:
+		WarpProfileHandler(std::vector<WarpProfiles::Profile> &profiles, std::string &active, bool activeOnly)
+			: mProfiles(profiles), mActive(active), mIsActiveOnly(activeOnly), mNumProfiles(0), mProfile(-1), mNumMapChildren(0) {}
+
+		void startElement(std::string_view name, const WarpXmlReader::Attributes &attributes, int depth) override
+		{
+			if (depth == 0) {
+				mActive = std::string(attributes.get("profile"));
+			}
+			else if (depth == 1) {
+				std::string_view profile = attributes.get("name");
+
+				mProfile = -1;
+				if (!mIsActiveOnly || mNumProfiles == 0 || profile == mActive) {
+					mProfile = (int)mProfiles.size();
+					mProfiles.push_back(WarpProfiles::Profile());
+					mProfiles.back().name = std::string(profile);
+				}
+				mNumProfiles++;
+			}
+			else if (depth == 2) {
+				mNumMapChildren = 0;
+			}
+			else if (depth == 3 && mProfile >= 0 && mNumMapChildren++ == 0) {
+				std::string_view method = attributes.get("method");
+				if (method == "bilinear") mWarp = WarpRef(new WarpBilinear());
+				else if (method == "perspective") mWarp = WarpRef(new WarpPerspective());
+				else if (method == "perspectivebilinear") mWarp = WarpRef(new WarpPerspectiveBilinear());
+
+				if (mWarp) mProfiles[mProfile].warps.push_back(mWarp);
+				mCounts.clear();
+			}
+
+			if (depth >= 3 && mWarp)
+				mWarp->readXml(name, count(name), attributes);
+		}
+
+		void endElement(std::string_view /*name*/, int depth) override
+		{
+			if (depth == 3) mWarp.reset();
+		}
+
+	protected:
+		//! returns the number of preceding elements with this name in the current warp
+		unsigned count(std::string_view name)
+		{
+			for (auto &c : mCounts) {
+				if (c.first == name) return c.second++;
+			}
+
+			mCounts.emplace_back(name, 1);
+			return 0;
+		}
+
+		std::vector<WarpProfiles::Profile>	&mProfiles;
+		std::string		&mActive;
+		bool			mIsActiveOnly;
+		int				mNumProfiles;
+		int				mProfile;
+		int				mNumMapChildren;
+		WarpRef			mWarp;
+		std::vector<std::pair<std::string_view, unsigned>>	mCounts;
+};
+
+WarpProfiles::WarpProfiles()
+	: mActive( 0 )
+	, mSelected( 0 )
+	, mWidth( 0 )
+	, mHeight( 0 )
+{
+}
+
+WarpProfiles::~WarpProfiles()
+{
+	for( size_t i = 0; i < mPrepared.size(); ++i )
+		wait( i );
+}
+
+bool WarpProfiles::load( const std::string &path )
+{
+	std::vector<Profile> profiles;
+	std::string active;
+	if( !read( path, profiles, active ) || profiles.empty() ) return false;
+
+	for( size_t i = 0; i < mPrepared.size(); ++i )
+		wait( i );
+
+	mProfiles.swap( profiles );
+	mPrepared.assign( mProfiles.size(), std::shared_future<void>() );
+
+	int index = find( active );
+	mActive = mSelected = ( index < 0 ) ? 0 : (size_t)index;
+
+	for( size_t i = 0; i < mProfiles.size(); ++i ) {
+		if( mWidth > 0 && mHeight > 0 ) {
+			for( auto &warp : mProfiles[i].warps )
+				warp->setSize( mWidth, mHeight );
+		}
+
+		if( i != mActive )
+			prepare( i );
+	}
+
+	return true;
+}
+
+bool WarpProfiles::save( const std::string &path ) const
+{
+	return write( path, mProfiles, getActiveName() );
+}
+
+void WarpProfiles::add( const std::string &name, const WarpList &warps )
+{
+	int index = find( name );
+	if( index < 0 ) {
+		index = (int)mProfiles.size();
+		mProfiles.push_back( Profile() );
+		mProfiles.back().name = name;
+		mPrepared.push_back( std::shared_future<void>() );
+	}
+	else {
+		wait( index );
+	}
+
+	mProfiles[index].warps = warps;
+
+	if( mWidth > 0 && mHeight > 0 ) {
+		for( auto &warp : mProfiles[index].warps )
+			warp->setSize( mWidth, mHeight );
+	}
+
+	if( (size_t)index != mActive )
+		prepare( index );
+}
+
+bool WarpProfiles::remove( const std::string &name )
+{
+	int index = find( name );
+	if( index < 0 || (size_t)index == mActive ) return false;
+
+	wait( index );
+	mProfiles.erase( mProfiles.begin() + index );
+	mPrepared.erase( mPrepared.begin() + index );
+
+	if( mActive > (size_t)index ) mActive--;
+	if( mSelected == (size_t)index ) mSelected = mActive;
+	else if( mSelected > (size_t)index ) mSelected--;
+
+	return true;
+}
+
+const std::string& WarpProfiles::getActiveName() const
+{
+	static const std::string none;
+	return mProfiles.empty() ? none : mProfiles[mActive].name;
+}
+
+WarpList& WarpProfiles::getWarps()
+{
+	return mProfiles.empty() ? mNone : mProfiles[mActive].warps;
+}
+
+bool WarpProfiles::select( const std::string &name )
+{
+	int index = find( name );
+	if( index < 0 ) return false;
+
+	// a profile added before any preparation is prepared now
+	mSelected = index;
+	if( mSelected != mActive && !mPrepared[mSelected].valid() )
+		prepare( mSelected );
+
+	return true;
+}
+
+bool WarpProfiles::update()
+{
+	if( mSelected == mActive || !isPrepared( mProfiles[mSelected].name ) ) return false;
+
+	// the profile that was drawn until now is up to date, so switching back is instant as well
+	std::promise<void> ready;
+	ready.set_value();
+	mPrepared[mActive] = ready.get_future().share();
+
+	mActive = mSelected;
+	return true;
+}
+
+bool WarpProfiles::isPrepared( const std::string &name ) const
+{
+	int index = find( name );
+	if( index < 0 ) return false;
+	if( (size_t)index == mActive ) return true;
+
+	const std::shared_future<void> &prepared = mPrepared[index];
+	return prepared.valid() && prepared.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready;
+}
+
+void WarpProfiles::setSize( int w, int h )
+{
+	mWidth = w;
+	mHeight = h;
+
+	for( size_t i = 0; i < mProfiles.size(); ++i ) {
+		bool wasPrepared = mPrepared[i].valid();
+		if( i != mActive )
+			wait( i );
+
+		for( auto &warp : mProfiles[i].warps )
+			warp->setSize( w, h );
+
+		// profiles that have never been prepared are prepared when they are selected
+		if( i != mActive && wasPrepared )
+			prepare( i );
+	}
+}
+
+bool WarpProfiles::read( const std::string &path, std::vector<Profile> &profiles, std::string &active, bool activeOnly )
+{
+	profiles.clear();
+	active.clear();
+
+	// binary settings are memory mapped instead of parsed
+	if( WarpSettings::isBinary( path ) ) {
+		active = "default";
+		profiles.push_back( Profile() );
+		profiles.back().name = active;
+		profiles.back().warps = WarpSettings::read( path );
+		return !profiles.back().warps.empty();
+	}
+
+	// stream the xml file, warps are created while it is being parsed
+	WarpXmlReader reader;
+	WarpProfileHandler handler( profiles, active, activeOnly );
+	if( !reader.load( path, handler ) ) {
+		cout << "WarpProfiles: could not read " << path << ": " << reader.getError() << endl;
+		profiles.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool WarpProfiles::write( const std::string &path, const std::vector<Profile> &profiles, const std::string &active )
+{
+	WarpXmlWriter writer;
+	writer.begin( "warpconfig" );
+	writer.attribute( "version", "1.0" );
+	writer.attribute( "profile", active );
+
+	WarpSettings::Snapshot snapshot;
+	for( auto &profile : profiles ) {
+		WarpSettings::takeSnapshot( profile.warps, snapshot );
+		WarpSettings::writeXml( profile.name, snapshot, writer );
+	}
+
+	writer.end();
+
+	if( !WarpSaver::writeAtomic( ofToDataPath( path ), writer.getString() + "\n" ) ) {
+		cout << "WarpProfiles: could not write " << path << endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool WarpProfiles::write( const std::string &path, const std::string &profile, const WarpSettings::Snapshot &snapshot )
+{
+	std::string buffer;
+	merge( path, profile, snapshot, buffer );
+
+	if( !WarpSaver::writeAtomic( ofToDataPath( path ), buffer ) ) {
+		cout << "WarpProfiles: could not write " << path << endl;
+		return false;
+	}
+
+	return true;
+}
+
+void WarpProfiles::merge( const std::string &path, const std::string &profile, const WarpSettings::Snapshot &snapshot, std::string &buffer )
+{
+	// the profiles that are already in the file
+	std::vector<Profile> profiles;
+	std::string active;
+	std::error_code error;
+	if( std::filesystem::exists( ofToDataPath( path ), error ) )
+		read( path, profiles, active );
+
+	// like Warp::readSettings, an unnamed profile is the active one or the first one
+	std::string name = profile.empty() ? active : profile;
+	int index = -1;
+	for( size_t i = 0; i < profiles.size() && index < 0; ++i ) {
+		if( profiles[i].name == name ) index = (int)i;
+	}
+	if( index < 0 && profile.empty() && !profiles.empty() ) index = 0;
+
+	if( index >= 0 ) name = profiles[index].name;
+	else if( name.empty() ) name = "default";
+	if( active.empty() ) active = profiles.empty() ? name : profiles[0].name;
+
+	WarpXmlWriter writer;
+	writer.begin( "warpconfig" );
+	writer.attribute( "version", "1.0" );
+	writer.attribute( "profile", active );
+
+	WarpSettings::Snapshot other;
+	for( size_t i = 0; i < profiles.size(); ++i ) {
+		if( (int)i == index ) {
+			WarpSettings::writeXml( name, snapshot, writer );
+		}
+		else {
+			WarpSettings::takeSnapshot( profiles[i].warps, other );
+			WarpSettings::writeXml( profiles[i].name, other, writer );
+		}
+	}
+
+	// a new profile is added after the existing ones
+	if( index < 0 )
+		WarpSettings::writeXml( name, snapshot, writer );
+
+	writer.end();
+
+	buffer = writer.getString();
+	buffer += '\n';
+}
+
+int WarpProfiles::find( const std::string &name ) const
+{
+	for( size_t i = 0; i < mProfiles.size(); ++i ) {
+		if( mProfiles[i].name == name ) return (int)i;
+	}
+	return -1;
+}
+
+void WarpProfiles::prepare( size_t index )
+{
+	wait( index );
+
+	// the shared pointers keep the warps alive, even if the profile is replaced
+	WarpList warps = mProfiles[index].warps;
+	mPrepared[index] = std::async( std::launch::async, [warps] {
+		for( auto &warp : warps )
+			warp->prepare();
+	} ).share();
+}
+
+void WarpProfiles::wait( size_t index )
+{
+	if( mPrepared[index].valid() )
+		mPrepared[index].wait();
+}
@@ -0,0 +1,111 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "WarpSettings.h"
+
+#include <future>
+
+//! Multiple sets of warps in one settings file, for example day and night layouts or alternate screen configurations.
+//! Only the active profile is drawn. The inactive profiles are prepared on background threads: their meshes are
+//! tessellated and their blend masks baked ahead of time (see Warp::prepare). Switching is done in update() at a frame
+//! boundary and only swaps the active profile, so it does not stall on parsing or tessellation. Only GL resources,
+//! like frame buffers and textures, are still created on the first draw.
+class WarpProfiles {
+	public:
+		//! a named list of warps
+		typedef struct Profile {
+			std::string		name;
+			WarpList		warps;
+		} Profile;
+
+	public:
+		WarpProfiles();
+		//! waits for the background preparation to finish
+		virtual ~WarpProfiles(void);
+
+		//! reads all profiles from a settings file, activates the profile the file names and prepares the others
+		bool				load(const std::string &path);
+		//! writes all profiles to a settings file, replacing it atomically
+		bool				save(const std::string &path) const;
+
+		//! adds a profile, or replaces the warps of an existing profile with the same name
+		void				add(const std::string &name, const WarpList &warps);
+		//! removes a profile, the active profile can not be removed
+		bool				remove(const std::string &name);
+
+		//! returns the number of profiles
+		size_t				getNumProfiles() const { return mProfiles.size(); }
+		//! returns the name of a profile
+		const std::string&	getName(size_t index) const { return mProfiles[index].name; }
+		//! returns the name of the active profile
+		const std::string&	getActiveName() const;
+		//! returns the warps of the active profile, these are the warps to draw and edit
+		WarpList&			getWarps();
+
+		//! selects the profile to switch to, the switch happens in update() as soon as it is prepared. Returns false if there is no such profile.
+		bool				select(const std::string &name);
+		//! call this at the start of each frame, switches to the selected profile if it is prepared. Returns true if the active profile changed.
+		bool				update();
+		//! returns true if the profile can be switched to without a stall
+		bool				isPrepared(const std::string &name) const;
+
+		//! sets the content size of the warps of all profiles, inactive profiles are prepared again
+		void				setSize(int w, int h);
+
+		//! reads the profiles of a settings file and the name of the active one. A binary settings file holds a single "default" profile.
+		//! If activeOnly is set, only the active profile and the first profile are read.
+		static bool			read(const std::string &path, std::vector<Profile> &profiles, std::string &active, bool activeOnly = false);
+		//! writes profiles to a settings xml file, replacing it atomically
+		static bool			write(const std::string &path, const std::vector<Profile> &profiles, const std::string &active);
+		//! writes the warps of one profile to a settings xml file, replacing it atomically. The other profiles in the file
+		//! are kept. An empty name replaces the profile Warp::readSettings reads.
+		static bool			write(const std::string &path, const std::string &profile, const WarpSettings::Snapshot &snapshot);
+		//! serializes a settings xml file in which one profile is replaced by the snapshot, see write()
+		static void			merge(const std::string &path, const std::string &profile, const WarpSettings::Snapshot &snapshot, std::string &buffer);
+
+	protected:
+		//! returns the index of a profile, or -1
+		int					find(const std::string &name) const;
+		//! prepares the warps of an inactive profile on a background thread
+		void				prepare(size_t index);
+		//! waits until a profile is no longer being prepared
+		void				wait(size_t index);
+
+	private:
+		WarpProfiles(const WarpProfiles&);
+		WarpProfiles& operator=(const WarpProfiles&);
+
+	protected:
+		std::vector<Profile>					mProfiles;
+		//! background preparation of each profile, not valid if the profile has not been prepared
+		std::vector<std::shared_future<void>>	mPrepared;
+
+		size_t				mActive;
+		size_t				mSelected;
+
+		int					mWidth;
+		int					mHeight;
+
+		//! returned by getWarps if there are no profiles
+		WarpList			mNone;
+};
@@ -0,0 +1,579 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarpRemap.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+const float WarpRemap::OUTSIDE = -1.0f;
+
+WarpRemap::WarpRemap()
+	: mContent( 0.0f )
+	, mFixedWidth( 0 )
+	, mFixedHeight( 0 )
+	, mFixedBake( -1 )
+	, mNumBakes( 0 )
+{
+}
+
+WarpRemap::~WarpRemap()
+{
+}
+
+bool WarpRemap::bake( Warp &warp, int width, int height, bool blendWeights, unsigned numThreads )
+{
+	ofMesh mesh;
+	warp.getMesh( mesh );
+
+	// the mesh is in output pixels, which may differ from the content size
+	glm::vec2 window = warp.getWindowSize();
+	if( window.x <= 0 || window.y <= 0 ) {
+		mCoordinates.clear();
+		mWeights.clear();
+		mMesh.clear();
+		return false;
+	}
+
+	if( width <= 0 ) width = (int)std::round( window.x );
+	if( height <= 0 ) height = (int)std::round( window.y );
+
+	// the shader blends in warp coordinates, so the weights use the same settings
+	WarpBlendMask::Settings blend;
+	blend.edges = warp.mEdges;
+	blend.exponent = warp.mExponent;
+	blend.luminance = warp.mLuminance;
+	blend.gamma = warp.mGamma;
+
+	// only rasterize again if anything the table depends on has changed
+	ofRectangle area = warp.getContentArea();
+	glm::vec2 content( warp.getWidth(), warp.getHeight() );
+
+	if( width == getWidth() && height == getHeight() && window == mWindow && blendWeights == mWeights.isAllocated() && area == mArea && content == mContent
+		&& ( !blendWeights || blend == mBlend ) && mesh.getVertices() == mMesh.getVertices()
+		&& mesh.getTexCoords() == mMesh.getTexCoords() && mesh.getIndices() == mMesh.getIndices() )
+		return false;
+
+	mMesh = mesh;
+	mBlend = blend;
+	mArea = area;
+	mContent = content;
+	mWindow = window;
+
+	mCoordinates.allocate( width, height, 2 );
+	std::fill( mCoordinates.getData(), mCoordinates.getData() + size_t( width ) * height * 2, OUTSIDE );
+
+	if( blendWeights ) {
+		mWeights.allocate( width, height, 3 );
+		std::fill( mWeights.getData(), mWeights.getData() + size_t( width ) * height * 3, 0.0f );
+	}
+	else {
+		mWeights.clear();
+	}
+
+	Job job;
+	job.width = width;
+	job.height = height;
+	job.scale = glm::vec2( width / window.x, height / window.y );
+	job.content = content;
+	job.area = area;
+	job.mesh = &mMesh;
+	job.blend = &blend;
+	job.coordinates = mCoordinates.getData();
+	job.weights = blendWeights ? mWeights.getData() : nullptr;
+
+	// every pixel only depends on the mesh, so tiles can be rasterized in any order
+	forEachTile( width, height, numThreads, [&]( int left, int top, int right, int bottom ) {
+		bakeTile( job, left, top, right, bottom );
+	} );
+
+	mNumBakes++;
+	return true;
+}
+
+void WarpRemap::bakeTile( const Job &job, int left, int top, int right, int bottom )
+{
+	const std::vector<glm::vec3> &vertices = job.mesh->getVertices();
+	const std::vector<glm::vec2> &texcoords = job.mesh->getTexCoords();
+	const std::vector<unsigned> &indices = job.mesh->getIndices();
+
+	// mesh texture coordinates are normalized to the content area, the table is normalized to the whole content
+	const double offsetX = job.area.x / job.content.x, scaleX = job.area.width / job.content.x;
+	const double offsetY = job.area.y / job.content.y, scaleY = job.area.height / job.content.y;
+
+	for( size_t t = 0; t + 2 < indices.size(); t += 3 ) {
+		const unsigned i0 = indices[t], i1 = indices[t + 1], i2 = indices[t + 2];
+		if( i0 >= vertices.size() || i1 >= vertices.size() || i2 >= vertices.size() ) continue;
+
+		// positions in output pixels, q for perspective correct interpolation
+		const double x0 = vertices[i0].x * job.scale.x, y0 = vertices[i0].y * job.scale.y, q0 = vertices[i0].z;
+		const double x1 = vertices[i1].x * job.scale.x, y1 = vertices[i1].y * job.scale.y, q1 = vertices[i1].z;
+		const double x2 = vertices[i2].x * job.scale.x, y2 = vertices[i2].y * job.scale.y, q2 = vertices[i2].z;
+
+		// skip degenerate triangles and triangles behind the projector
+		const double area = ( x1 - x0 ) * ( y2 - y0 ) - ( x2 - x0 ) * ( y1 - y0 );
+		if( area == 0.0 || q0 <= 0.0 || q1 <= 0.0 || q2 <= 0.0 ) continue;
+
+		// bounding box, clipped against the tile
+		int minX = std::max( left, (int)std::floor( std::min( x0, std::min( x1, x2 ) ) ) );
+		int maxX = std::min( right - 1, (int)std::ceil( std::max( x0, std::max( x1, x2 ) ) ) );
+		int minY = std::max( top, (int)std::floor( std::min( y0, std::min( y1, y2 ) ) ) );
+		int maxY = std::min( bottom - 1, (int)std::ceil( std::max( y0, std::max( y1, y2 ) ) ) );
+		if( minX > maxX || minY > maxY ) continue;
+
+		// edges are oriented so the inside is positive, regardless of the winding of the triangle
+		const double sign = ( area > 0.0 ) ? 1.0 : -1.0;
+		const double inv = 1.0 / ( area * sign );
+
+		// top-left fill rule, so pixels on a shared edge belong to exactly one triangle
+		const double ex[3] = { ( x2 - x1 ) * sign, ( x0 - x2 ) * sign, ( x1 - x0 ) * sign };
+		const double ey[3] = { ( y2 - y1 ) * sign, ( y0 - y2 ) * sign, ( y1 - y0 ) * sign };
+		bool topLeft[3];
+		for( int e = 0; e < 3; ++e )
+			topLeft[e] = ( ey[e] < 0.0 ) || ( ey[e] == 0.0 && ex[e] > 0.0 );
+
+		const double px[3] = { x1, x2, x0 };
+		const double py[3] = { y1, y2, y0 };
+		const glm::vec2 &t0 = texcoords[i0], &t1 = texcoords[i1], &t2 = texcoords[i2];
+
+		for( int y = minY; y <= maxY; ++y ) {
+			const double cy = y + 0.5;
+
+			for( int x = minX; x <= maxX; ++x ) {
+				const double cx = x + 0.5;
+
+				// edge functions, which are the unnormalized barycentric coordinates
+				double w[3];
+				bool inside = true;
+				for( int e = 0; e < 3 && inside; ++e ) {
+					w[e] = ( cy - py[e] ) * ex[e] - ( cx - px[e] ) * ey[e];
+					inside = ( w[e] > 0.0 ) || ( w[e] == 0.0 && topLeft[e] );
+				}
+				if( !inside ) continue;
+
+				// perspective correct interpolation, like the rasterizer of the GPU
+				const double b0 = w[0] * inv / q0;
+				const double b1 = w[1] * inv / q1;
+				const double b2 = w[2] * inv / q2;
+				const double sum = b0 + b1 + b2;
+
+				const double s = ( b0 * t0.x + b1 * t1.x + b2 * t2.x ) / sum;
+				const double r = ( b0 * t0.y + b1 * t1.y + b2 * t2.y ) / sum;
+
+				const size_t index = size_t( y ) * job.width + x;
+				job.coordinates[index * 2 + 0] = float( offsetX + s * scaleX );
+				job.coordinates[index * 2 + 1] = float( offsetY + r * scaleY );
+
+				if( job.weights ) {
+					glm::vec3 weight = WarpBlendMask::evaluate( *job.blend, float( s ), float( r ) );
+					job.weights[index * 3 + 0] = weight.x;
+					job.weights[index * 3 + 1] = weight.y;
+					job.weights[index * 3 + 2] = weight.z;
+				}
+			}
+		}
+	}
+}
+
+void WarpRemap::forEachTile( int width, int height, unsigned numThreads, const std::function<void( int, int, int, int )> &fn )
+{
+	int tilesX = ( width + TILE_SIZE - 1 ) / TILE_SIZE;
+	int tilesY = ( height + TILE_SIZE - 1 ) / TILE_SIZE;
+	int numTiles = tilesX * tilesY;
+	if( numTiles <= 0 ) return;
+
+	if( numThreads == 0 )
+		numThreads = std::max( 1u, std::thread::hardware_concurrency() );
+	numThreads = std::min( numThreads, (unsigned)numTiles );
+
+	// a shared counter balances the load when some tiles are more expensive than others
+	std::atomic<int> next( 0 );
+	auto worker = [&]() {
+		for( int i = next++; i < numTiles; i = next++ ) {
+			int x = ( i % tilesX ) * TILE_SIZE;
+			int y = ( i / tilesX ) * TILE_SIZE;
+			fn( x, y, std::min( width, x + TILE_SIZE ), std::min( height, y + TILE_SIZE ) );
+		}
+	};
+
+	if( numThreads <= 1 ) {
+		worker();
+		return;
+	}
+
+	std::vector<std::thread> threads;
+	for( unsigned i = 0; i < numThreads; ++i )
+		threads.push_back( std::thread( worker ) );
+
+	for( size_t i = 0; i < threads.size(); ++i )
+		threads[i].join();
+}
+
+void WarpRemap::apply( const ofPixels &src, ofPixels &dst, unsigned numThreads )
+{
+	if( src.getNumChannels() != 4 || src.getWidth() < 2 || src.getHeight() < 2 ) {
+		cout << "WarpRemap: apply() requires RGBA pixels of at least 2 x 2" << endl;
+		return;
+	}
+
+	dst.allocate( getWidth(), getHeight(), 4 );
+	updateFixed( (int)src.getWidth(), (int)src.getHeight() );
+	applyTiles( src.getData(), dst.getData(), numThreads );
+}
+
+void WarpRemap::apply( const ofShortPixels &src, ofShortPixels &dst, unsigned numThreads )
+{
+	if( src.getNumChannels() != 4 || src.getWidth() < 2 || src.getHeight() < 2 ) {
+		cout << "WarpRemap: apply() requires RGBA pixels of at least 2 x 2" << endl;
+		return;
+	}
+
+	dst.allocate( getWidth(), getHeight(), 4 );
+	updateFixed( (int)src.getWidth(), (int)src.getHeight() );
+	applyTiles( src.getData(), dst.getData(), numThreads );
+}
+
+void WarpRemap::apply( const WarpYuv::Planes &src, ofPixels &dst, unsigned numThreads )
+{
+	if( src.width < 4 || src.height < 4 || !src.data[0] || !src.data[1] || ( src.format == WarpYuv::I420 && !src.data[2] ) ) {
+		cout << "WarpRemap: apply() requires all planes of a YUV frame of at least 4 x 4" << endl;
+		return;
+	}
+
+	dst.allocate( getWidth(), getHeight(), 4 );
+	updateFixed( src.width, src.height );
+
+	// nothing to resample before the first bake
+	if( mFixed.empty() ) return;
+
+	const int width = getWidth();
+	const int32_t *fixed = &mFixed[0];
+	unsigned char *out = dst.getData();
+
+	forEachTile( width, getHeight(), numThreads, [&]( int left, int top, int right, int bottom ) {
+		for( int y = top; y < bottom; ++y ) {
+			size_t offset = size_t( y ) * width + left;
+			remapRow( fixed + offset * 2, src, out + offset * 4, right - left );
+		}
+	} );
+}
+
+void WarpRemap::updateFixed( int srcWidth, int srcHeight )
+{
+	if( mFixedBake == mNumBakes && mFixedWidth == srcWidth && mFixedHeight == srcHeight ) return;
+
+	mFixedBake = mNumBakes;
+	mFixedWidth = srcWidth;
+	mFixedHeight = srcHeight;
+
+	size_t numPixels = size_t( getWidth() ) * getHeight();
+	mFixed.resize( numPixels * 2 );
+
+	// texel centers are at +0.5, clamp to the edge like the content texture. Double precision keeps all 16 fractional bits for large sources.
+	const float *coord = mCoordinates.getData();
+	for( size_t i = 0; i < numPixels; ++i, coord += 2 ) {
+		if( coord[0] < 0.0f ) {
+			mFixed[i * 2 + 0] = -1;
+			mFixed[i * 2 + 1] = -1;
+			continue;
+		}
+
+		double x = std::min( std::max( coord[0] * double( srcWidth ) - 0.5, 0.0 ), srcWidth - 1.0 );
+		double y = std::min( std::max( coord[1] * double( srcHeight ) - 0.5, 0.0 ), srcHeight - 1.0 );
+		mFixed[i * 2 + 0] = int32_t( x * 65536.0 + 0.5 );
+		mFixed[i * 2 + 1] = int32_t( y * 65536.0 + 0.5 );
+	}
+}
+
+template<typename T>
+void WarpRemap::applyTiles( const T *src, T *dst, unsigned numThreads )
+{
+	// nothing to resample before the first bake
+	if( mFixed.empty() ) return;
+
+	const int width = getWidth();
+	const int srcWidth = mFixedWidth;
+	const int srcHeight = mFixedHeight;
+	const int32_t *fixed = &mFixed[0];
+
+	// tiles keep the source texels of neighbouring rows in the cache, also when the warp rotates the content
+	forEachTile( width, getHeight(), numThreads, [&]( int left, int top, int right, int bottom ) {
+		for( int y = top; y < bottom; ++y ) {
+			size_t offset = size_t( y ) * width + left;
+			remapRow( fixed + offset * 2, src, srcWidth, srcHeight, dst + offset * 4, right - left );
+		}
+	} );
+}
+
+//! splits a 16.16 coordinate into the first texel and an 8-bit weight within [0, 256], so the last texel can be reached
+static inline void splitFixed( int32_t v, int size, int &i, int &f )
+{
+	i = std::min( v >> 16, size - 2 );
+	f = ( v - ( i << 16 ) + 128 ) >> 8;
+}
+
+//! resamples a single RGBA pixel, the scalar kernel
+template<typename T>
+static inline void remapPixel( const int32_t *coords, const T *src, int srcWidth, int srcHeight, T *dst )
+{
+	if( coords[0] < 0 ) {
+		dst[0] = dst[1] = dst[2] = dst[3] = 0;
+		return;
+	}
+
+	int x0, fx, y0, fy;
+	splitFixed( coords[0], srcWidth, x0, fx );
+	splitFixed( coords[1], srcHeight, y0, fy );
+
+	const size_t stride = size_t( srcWidth ) * 4;
+	const T *p = src + y0 * stride + x0 * 4;
+
+	// the weights sum to 256 in each direction, so 16-bit channels still fit in 32 bits
+	for( int c = 0; c < 4; ++c ) {
+		uint32_t top = p[c] * uint32_t( 256 - fx ) + p[c + 4] * uint32_t( fx );
+		uint32_t bottom = p[stride + c] * uint32_t( 256 - fx ) + p[stride + c + 4] * uint32_t( fx );
+		dst[c] = T( ( top * uint32_t( 256 - fy ) + bottom * uint32_t( fy ) + 32768 ) >> 16 );
+	}
+}
+
+void WarpRemap::remapRow( const int32_t *coords, const unsigned char *src, int srcWidth, int srcHeight, unsigned char *dst, int count )
+{
+	int n = 0;
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+	const size_t stride = size_t( srcWidth ) * 4;
+	// two texels of a row, interleaved per channel so madd blends them horizontally
+	const __m128i order = _mm_setr_epi8( 0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15 );
+#endif
+
+#if defined(__AVX2__)
+	// two pixels per iteration, one in each 128-bit lane
+	const __m256i half = _mm256_set1_epi32( 32768 );
+
+	for( ; n + 1 < count; n += 2, coords += 4, dst += 8 ) {
+		if( coords[0] < 0 || coords[2] < 0 ) {
+			remapPixel( coords, src, srcWidth, srcHeight, dst );
+			remapPixel( coords + 2, src, srcWidth, srcHeight, dst + 4 );
+			continue;
+		}
+
+		int x0, fx0, y0, fy0, x1, fx1, y1, fy1;
+		splitFixed( coords[0], srcWidth, x0, fx0 );
+		splitFixed( coords[1], srcHeight, y0, fy0 );
+		splitFixed( coords[2], srcWidth, x1, fx1 );
+		splitFixed( coords[3], srcHeight, y1, fy1 );
+
+		const unsigned char *p0 = src + y0 * stride + x0 * 4;
+		const unsigned char *p1 = src + y1 * stride + x1 * 4;
+
+		__m128i top = _mm_unpacklo_epi64( _mm_loadl_epi64( (const __m128i*)p0 ), _mm_loadl_epi64( (const __m128i*)p1 ) );
+		__m128i bottom = _mm_unpacklo_epi64( _mm_loadl_epi64( (const __m128i*)( p0 + stride ) ), _mm_loadl_epi64( (const __m128i*)( p1 + stride ) ) );
+		__m256i top16 = _mm256_cvtepu8_epi16( _mm_shuffle_epi8( top, order ) );
+		__m256i bottom16 = _mm256_cvtepu8_epi16( _mm_shuffle_epi8( bottom, order ) );
+
+		int32_t w0 = ( fx0 << 16 ) | ( 256 - fx0 );
+		int32_t w1 = ( fx1 << 16 ) | ( 256 - fx1 );
+		__m256i wx = _mm256_setr_epi32( w0, w0, w0, w0, w1, w1, w1, w1 );
+		__m256i wy0 = _mm256_setr_epi32( 256 - fy0, 256 - fy0, 256 - fy0, 256 - fy0, 256 - fy1, 256 - fy1, 256 - fy1, 256 - fy1 );
+		__m256i wy1 = _mm256_setr_epi32( fy0, fy0, fy0, fy0, fy1, fy1, fy1, fy1 );
+
+		__m256i c = _mm256_add_epi32( _mm256_mullo_epi32( _mm256_madd_epi16( top16, wx ), wy0 ), _mm256_mullo_epi32( _mm256_madd_epi16( bottom16, wx ), wy1 ) );
+		c = _mm256_srli_epi32( _mm256_add_epi32( c, half ), 16 );
+		c = _mm256_packus_epi16( _mm256_packus_epi32( c, c ), c );
+
+		int32_t a = _mm_cvtsi128_si32( _mm256_castsi256_si128( c ) );
+		int32_t b = _mm_cvtsi128_si32( _mm256_extracti128_si256( c, 1 ) );
+		memcpy( dst, &a, 4 );
+		memcpy( dst + 4, &b, 4 );
+	}
+#elif defined(__SSE4_1__)
+	const __m128i half = _mm_set1_epi32( 32768 );
+
+	for( ; n < count; ++n, coords += 2, dst += 4 ) {
+		if( coords[0] < 0 ) {
+			remapPixel( coords, src, srcWidth, srcHeight, dst );
+			continue;
+		}
+
+		int x0, fx, y0, fy;
+		splitFixed( coords[0], srcWidth, x0, fx );
+		splitFixed( coords[1], srcHeight, y0, fy );
+		const unsigned char *p = src + y0 * stride + x0 * 4;
+
+		__m128i top = _mm_cvtepu8_epi16( _mm_shuffle_epi8( _mm_loadl_epi64( (const __m128i*)p ), order ) );
+		__m128i bottom = _mm_cvtepu8_epi16( _mm_shuffle_epi8( _mm_loadl_epi64( (const __m128i*)( p + stride ) ), order ) );
+		__m128i wx = _mm_set1_epi32( ( fx << 16 ) | ( 256 - fx ) );
+
+		__m128i c = _mm_add_epi32( _mm_mullo_epi32( _mm_madd_epi16( top, wx ), _mm_set1_epi32( 256 - fy ) ), _mm_mullo_epi32( _mm_madd_epi16( bottom, wx ), _mm_set1_epi32( fy ) ) );
+		c = _mm_srli_epi32( _mm_add_epi32( c, half ), 16 );
+		c = _mm_packus_epi16( _mm_packus_epi32( c, c ), c );
+
+		int32_t a = _mm_cvtsi128_si32( c );
+		memcpy( dst, &a, 4 );
+	}
+#endif
+
+	for( ; n < count; ++n, coords += 2, dst += 4 )
+		remapPixel( coords, src, srcWidth, srcHeight, dst );
+}
+
+void WarpRemap::remapRow( const int32_t *coords, const unsigned short *src, int srcWidth, int srcHeight, unsigned short *dst, int count )
+{
+	int n = 0;
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+	// one pixel per iteration, 32-bit lanes. The result is below 2^32, so unsigned wrap around of the products is harmless.
+	const size_t stride = size_t( srcWidth ) * 4;
+	const __m128i half = _mm_set1_epi32( 32768 );
+
+	for( ; n < count; ++n, coords += 2, dst += 4 ) {
+		if( coords[0] < 0 ) {
+			remapPixel( coords, src, srcWidth, srcHeight, dst );
+			continue;
+		}
+
+		int x0, fx, y0, fy;
+		splitFixed( coords[0], srcWidth, x0, fx );
+		splitFixed( coords[1], srcHeight, y0, fy );
+		const unsigned short *p = src + y0 * stride + x0 * 4;
+
+		__m128i top = _mm_loadu_si128( (const __m128i*)p );
+		__m128i bottom = _mm_loadu_si128( (const __m128i*)( p + stride ) );
+		__m128i wx0 = _mm_set1_epi32( 256 - fx );
+		__m128i wx1 = _mm_set1_epi32( fx );
+
+		__m128i t = _mm_add_epi32( _mm_mullo_epi32( _mm_cvtepu16_epi32( top ), wx0 ), _mm_mullo_epi32( _mm_cvtepu16_epi32( _mm_srli_si128( top, 8 ) ), wx1 ) );
+		__m128i b = _mm_add_epi32( _mm_mullo_epi32( _mm_cvtepu16_epi32( bottom ), wx0 ), _mm_mullo_epi32( _mm_cvtepu16_epi32( _mm_srli_si128( bottom, 8 ) ), wx1 ) );
+		__m128i c = _mm_add_epi32( _mm_mullo_epi32( t, _mm_set1_epi32( 256 - fy ) ), _mm_mullo_epi32( b, _mm_set1_epi32( fy ) ) );
+		c = _mm_srli_epi32( _mm_add_epi32( c, half ), 16 );
+		c = _mm_packus_epi32( c, c );
+
+		_mm_storel_epi64( (__m128i*)dst, c );
+	}
+#endif
+
+	for( ; n < count; ++n, coords += 2, dst += 4 )
+		remapPixel( coords, src, srcWidth, srcHeight, dst );
+}
+
+//! bilinear sample of a single channel plane, 8-bit weights like remapPixel()
+static inline int samplePlane( const unsigned char *plane, int stride, int step, int x0, int fx, int y0, int fy )
+{
+	const unsigned char *p = plane + y0 * stride + x0 * step;
+	uint32_t top = p[0] * uint32_t( 256 - fx ) + p[step] * uint32_t( fx );
+	uint32_t bottom = p[stride] * uint32_t( 256 - fx ) + p[stride + step] * uint32_t( fx );
+	return int( ( top * uint32_t( 256 - fy ) + bottom * uint32_t( fy ) + 32768 ) >> 16 );
+}
+
+void WarpRemap::remapRow( const int32_t *coords, const WarpYuv::Planes &src, unsigned char *dst, int count )
+{
+	const int chromaWidth = ( src.width + 1 ) / 2;
+	const int chromaHeight = ( src.height + 1 ) / 2;
+	const bool interleaved = ( src.format == WarpYuv::NV12 );
+	const unsigned char *planeU = src.data[1];
+	const unsigned char *planeV = interleaved ? src.data[1] + 1 : src.data[2];
+	const int strideV = interleaved ? src.stride[1] : src.stride[2];
+	const int step = interleaved ? 2 : 1;
+
+	for( int n = 0; n < count; ++n, coords += 2, dst += 4 ) {
+		if( coords[0] < 0 ) {
+			dst[0] = dst[1] = dst[2] = dst[3] = 0;
+			continue;
+		}
+
+		int x0, fx, y0, fy;
+		splitFixed( coords[0], src.width, x0, fx );
+		splitFixed( coords[1], src.height, y0, fy );
+		int luma = samplePlane( src.data[0], src.stride[0], 1, x0, fx, y0, fy );
+
+		// chroma texel centers sit between two luma texels, a quarter chroma texel before the luma coordinate
+		int32_t cx = std::min( std::max( ( coords[0] >> 1 ) - 16384, 0 ), ( chromaWidth - 1 ) << 16 );
+		int32_t cy = std::min( std::max( ( coords[1] >> 1 ) - 16384, 0 ), ( chromaHeight - 1 ) << 16 );
+		splitFixed( cx, chromaWidth, x0, fx );
+		splitFixed( cy, chromaHeight, y0, fy );
+		int u = samplePlane( planeU, src.stride[1], step, x0, fx, y0, fy );
+		int v = samplePlane( planeV, strideV, step, x0, fx, y0, fy );
+
+		WarpYuv::toRgb( luma, u, v, dst );
+		dst[3] = 255;
+	}
+}
+
+void WarpRemap::applyReference( const ofFloatPixels &coordinates, const ofPixels &src, ofPixels &dst )
+{
+	const int width = (int)coordinates.getWidth();
+	const int height = (int)coordinates.getHeight();
+	const int srcWidth = (int)src.getWidth();
+	const int srcHeight = (int)src.getHeight();
+	const int channels = (int)src.getNumChannels();
+
+	dst.allocate( width, height, channels );
+
+	for( int y = 0; y < height; ++y ) {
+		for( int x = 0; x < width; ++x ) {
+			const float *coord = coordinates.getData() + ( size_t( y ) * width + x ) * 2;
+			unsigned char *out = dst.getData() + ( size_t( y ) * width + x ) * channels;
+
+			if( coord[0] < 0.0f ) {
+				for( int c = 0; c < channels; ++c )
+					out[c] = 0;
+				continue;
+			}
+
+			float sx = ofClamp( coord[0] * srcWidth - 0.5f, 0.0f, srcWidth - 1.0f );
+			float sy = ofClamp( coord[1] * srcHeight - 0.5f, 0.0f, srcHeight - 1.0f );
+			int x0 = (int)sx, y0 = (int)sy;
+			int x1 = std::min( x0 + 1, srcWidth - 1 ), y1 = std::min( y0 + 1, srcHeight - 1 );
+			float fx = sx - x0, fy = sy - y0;
+
+			for( int c = 0; c < channels; ++c ) {
+				float c00 = src.getData()[( size_t( y0 ) * srcWidth + x0 ) * channels + c];
+				float c10 = src.getData()[( size_t( y0 ) * srcWidth + x1 ) * channels + c];
+				float c01 = src.getData()[( size_t( y1 ) * srcWidth + x0 ) * channels + c];
+				float c11 = src.getData()[( size_t( y1 ) * srcWidth + x1 ) * channels + c];
+
+				float top = c00 + fx * ( c10 - c00 );
+				float bottom = c01 + fx * ( c11 - c01 );
+				out[c] = (unsigned char)( top + fy * ( bottom - top ) + 0.5f );
+			}
+		}
+	}
+}
+
+const char* WarpRemap::getKernelName()
+{
+#if defined(__AVX2__)
+	return "avx2";
+#elif defined(__SSE4_1__)
+	return "sse4.1";
+#else
+	return "scalar";
+#endif
+}
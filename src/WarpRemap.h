@@ -0,0 +1,122 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "Warp.h"
+
+//! Bakes a warp into a remap table (display map): for every output pixel, the normalized content coordinate
+//! it shows and optionally its edge blending weight. The table is rasterized from the warp mesh on the CPU,
+//! so it can be generated without a GPU, exported for media servers, or uploaded as a floating point texture
+//! and applied with a single dependent fetch whose cost does not depend on the mesh resolution. On the CPU,
+//! apply() resamples content pixels through the table with fixed point bilinear kernels.
+class WarpRemap {
+	public:
+		WarpRemap();
+		virtual ~WarpRemap(void);
+
+		//! rasterizes the warp into a table of width x height output pixels (0 = output size of the warp, see Warp::getWindowSize()).
+		//! Tiles are spread over the specified number of threads (0 = hardware concurrency), the result does not depend on the number of threads.
+		//! Returns true if the table was rasterized, false if the mesh and the blend parameters have not changed since the last call.
+		bool					bake(Warp &warp, int width = 0, int height = 0, bool blendWeights = false, unsigned numThreads = 0);
+
+		//! returns the content coordinate (u, v) of every output pixel, normalized to the content. Pixels outside the warp are set to -1.
+		const ofFloatPixels&	getCoordinates() const { return mCoordinates; }
+		//! returns the RGB edge blending weight of every output pixel, if requested. Pixels outside the warp are set to 0.
+		const ofFloatPixels&	getWeights() const { return mWeights; }
+
+		//! returns the output width of the table
+		int						getWidth() const { return (int)mCoordinates.getWidth(); }
+		//! returns the output height of the table
+		int						getHeight() const { return (int)mCoordinates.getHeight(); }
+		//! returns the number of times the table has been rasterized
+		int						getNumBakes() const { return mNumBakes; }
+
+		//! resamples RGBA content pixels through the table into dst, which is allocated at the size of the table. Pixels
+		//! outside the warp are transparent. Tiles are spread over the specified number of threads (0 = hardware concurrency).
+		void					apply(const ofPixels &src, ofPixels &dst, unsigned numThreads = 0);
+		//! resamples 16-bit RGBA content pixels through the table into dst
+		void					apply(const ofShortPixels &src, ofShortPixels &dst, unsigned numThreads = 0);
+		//! resamples the planes of a YUV video frame through the table into RGBA pixels, converting each output pixel like the warp shaders
+		void					apply(const WarpYuv::Planes &src, ofPixels &dst, unsigned numThreads = 0);
+
+		//! straightforward floating point implementation of apply(), single threaded. Used as a reference for the fixed point kernels.
+		static void				applyReference(const ofFloatPixels &coordinates, const ofPixels &src, ofPixels &dst);
+		//! returns the name of the kernel used by apply(): "avx2", "sse4.1" or "scalar"
+		static const char*		getKernelName();
+
+		//! calls fn(left, top, right, bottom) for all TILE_SIZE tiles of a width x height image. Tiles are spread over the specified
+		//! number of threads (0 = hardware concurrency), threads pick the next tile from a shared counter.
+		static void				forEachTile(int width, int height, unsigned numThreads, const std::function<void(int, int, int, int)> &fn);
+
+		//! value of pixels outside the warp
+		static const float		OUTSIDE;
+		//! width and height of the tiles the table is rasterized in
+		static const int		TILE_SIZE = 64;
+
+	protected:
+		//! everything the rasterizer needs, shared by all threads
+		typedef struct Job {
+			int							width;
+			int							height;
+			glm::vec2					scale;
+			glm::vec2					content;
+			ofRectangle					area;
+			const ofMesh				*mesh;
+			const WarpBlendMask::Settings *blend;
+			float						*coordinates;
+			float						*weights;
+		} Job;
+
+		//! rasterizes all triangles into the tile [left, right) x [top, bottom) of the table
+		static void				bakeTile(const Job &job, int left, int top, int right, int bottom);
+
+		//! converts the table to 16.16 fixed point pixel coordinates for a source of the specified size, if not done already
+		void					updateFixed(int srcWidth, int srcHeight);
+		//! resamples the tile of the table, src and dst are RGBA with 8 or 16 bits per channel
+		template<typename T>
+		void					applyTiles(const T *src, T *dst, unsigned numThreads);
+
+		//! resamples count RGBA pixels at 16.16 fixed point coordinates. Sources must be at least 2 x 2 pixels.
+		static void				remapRow(const int32_t *coords, const unsigned char *src, int srcWidth, int srcHeight, unsigned char *dst, int count);
+		static void				remapRow(const int32_t *coords, const unsigned short *src, int srcWidth, int srcHeight, unsigned short *dst, int count);
+		//! resamples count pixels of a YUV frame at 16.16 fixed point luma coordinates into RGBA
+		static void				remapRow(const int32_t *coords, const WarpYuv::Planes &src, unsigned char *dst, int count);
+
+	protected:
+		ofFloatPixels			mCoordinates;
+		ofFloatPixels			mWeights;
+
+		//! inputs of the last bake, used to detect changes
+		ofMesh					mMesh;
+		WarpBlendMask::Settings	mBlend;
+		ofRectangle				mArea;
+		glm::vec2				mContent;
+		glm::vec2				mWindow;
+
+		//! table in 16.16 fixed point source pixels, x < 0 outside the warp
+		std::vector<int32_t>	mFixed;
+		int						mFixedWidth;
+		int						mFixedHeight;
+		int						mFixedBake;
+
+		int						mNumBakes;
+};
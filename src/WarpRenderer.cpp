@@ -0,0 +1,581 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarpRenderer.h"
+
+WarpRenderer::WarpRenderer()
+	: mShaderTarget( 0 )
+	, mMaskTextureId( 0 )
+	, mLutTextureId( 0 )
+	, mNumDrawCalls( 0 )
+	, mNumUnbatchedDrawCalls( 0 )
+	, mNumGeometryUpdates( 0 )
+	, mNumParameterUpdates( 0 )
+	, mNumTableUpdates( 0 )
+{
+}
+
+WarpRenderer::~WarpRenderer()
+{
+	if( mMaskTextureId )
+		glDeleteTextures( 1, &mMaskTextureId );
+	if( mLutTextureId )
+		glDeleteTextures( 1, &mLutTextureId );
+}
+
+void WarpRenderer::draw( const WarpList &warps, const ofTexture &texture )
+{
+	// drawn one by one, every warp issues its own draw call
+	mNumDrawCalls = 0;
+	mNumUnbatchedDrawCalls = (int)warps.size();
+
+	if( warps.empty() ) return;
+
+	// rebuild the vertex buffer if any of the meshes has changed
+	if( updateWarps( warps ) )
+		createBuffers( warps );
+
+	updateTables( warps );
+	updateParameters( warps, texture );
+	createShader( texture.getTextureData().textureTarget );
+
+	glDisable( GL_DEPTH_TEST );
+
+	ofSetColor( 255 );
+
+	if( !mIndices.empty() ) {
+		const GLsizeiptr size = MAX_WARPS_PER_BATCH * PARAMS_PER_WARP * 4 * sizeof( float );
+
+		mShader->begin();
+		mShader->setUniformTexture( "uTex0", texture, 0 );
+		mShader->setUniform1i( "uColorLuts", 1 );
+		mShader->setUniform1i( "uBlendMasks", 2 );
+
+		glActiveTexture( GL_TEXTURE1 );
+		glBindTexture( GL_TEXTURE_3D, mLutTextureId );
+		glActiveTexture( GL_TEXTURE2 );
+		glBindTexture( GL_TEXTURE_2D_ARRAY, mMaskTextureId );
+		glActiveTexture( GL_TEXTURE0 );
+
+		for( size_t i = 0; i < mBatches.size(); ++i ) {
+			mParams.bindRange( GL_UNIFORM_BUFFER, 0, i * size, size );
+			mVbo.drawElements( GL_TRIANGLES, mBatches[i].second, mBatches[i].first );
+			mNumDrawCalls++;
+		}
+
+		glActiveTexture( GL_TEXTURE2 );
+		glBindTexture( GL_TEXTURE_2D_ARRAY, 0 );
+		glActiveTexture( GL_TEXTURE1 );
+		glBindTexture( GL_TEXTURE_3D, 0 );
+		glActiveTexture( GL_TEXTURE0 );
+
+		mParams.unbindRange( GL_UNIFORM_BUFFER, 0 );
+		mShader->end();
+	}
+
+	// warps that can not be batched are drawn by themselves
+	for( WarpConstIter itr = warps.begin(); itr != warps.end(); ++itr ) {
+		if( isUnbatched( *itr ) ) {
+			(*itr)->draw( texture );
+			mNumDrawCalls++;
+		}
+	}
+}
+
+bool WarpRenderer::updateWarps( const WarpList &warps )
+{
+	bool changed = ( warps.size() != mWarps.size() );
+
+	for( size_t i = 0; i < warps.size(); ++i ) {
+		// creates and updates the mesh if necessary
+		if( warps[i]->getType() == Warp::BILINEAR || warps[i]->getType() == Warp::PERSPECTIVE_BILINEAR )
+			std::static_pointer_cast<WarpBilinear>( warps[i] )->updateBuffers();
+
+		if( changed ) continue;
+
+		Entry entry = getEntry( warps[i] );
+		const Entry &last = mWarps[i];
+
+		changed = ( entry.warp != last.warp || entry.revision != last.revision
+				   || entry.transform != last.transform || entry.unbatched != last.unbatched );
+	}
+
+	return changed;
+}
+
+WarpRenderer::Entry WarpRenderer::getEntry( const WarpRef &warp ) const
+{
+	Entry entry;
+	entry.warp = warp.get();
+	entry.revision = 0;
+	entry.transform = glm::mat4( 1.0f );
+	entry.unbatched = isUnbatched( warp );
+
+	switch( warp->getType() ) {
+		case Warp::BILINEAR:
+			entry.revision = std::static_pointer_cast<WarpBilinear>( warp )->mMeshRevision;
+			break;
+		case Warp::PERSPECTIVE_BILINEAR: {
+			// the transform is applied by the renderer if it is not baked into the mesh
+			WarpPerspectiveBilinearRef pb = std::static_pointer_cast<WarpPerspectiveBilinear>( warp );
+			entry.revision = pb->mMeshRevision;
+			if( !pb->isTransformBaked() )
+				entry.transform = pb->getTransform();
+			break; }
+		case Warp::PERSPECTIVE:
+			entry.transform = std::static_pointer_cast<WarpPerspective>( warp )->getTransform();
+			break;
+		default:
+			break;
+	}
+
+	return entry;
+}
+
+void WarpRenderer::createBuffers( const WarpList &warps )
+{
+	mWarps.clear();
+	mVertices.clear();
+	mTexCoords.clear();
+	mWarpIds.clear();
+	mIndices.clear();
+	mBatches.clear();
+
+	int count = 0;
+
+	for( WarpConstIter itr = warps.begin(); itr != warps.end(); ++itr ) {
+		mWarps.push_back( getEntry( *itr ) );
+
+		if( isUnbatched( *itr ) )
+			continue;
+
+		// start a new batch when the uniform buffer range is full
+		if( count % MAX_WARPS_PER_BATCH == 0 )
+			mBatches.push_back( std::make_pair( (int)mIndices.size(), 0 ) );
+
+		addWarp( *itr, float( count % MAX_WARPS_PER_BATCH ) );
+		mBatches.back().second = (int)mIndices.size() - mBatches.back().first;
+
+		count++;
+	}
+
+	if( mVertices.empty() ) return;
+
+	int total = (int)mVertices.size();
+	mVbo.setVertexData( &mVertices[0], total, GL_DYNAMIC_DRAW );
+	mVbo.setTexCoordData( &mTexCoords[0], total, GL_DYNAMIC_DRAW );
+	mVbo.setAttributeData( WARP_ID_ATTRIBUTE, &mWarpIds[0], 1, total, GL_DYNAMIC_DRAW, sizeof( float ) );
+	mVbo.setIndexData( &mIndices[0], (int)mIndices.size(), GL_DYNAMIC_DRAW );
+
+	mNumGeometryUpdates++;
+}
+
+void WarpRenderer::addWarp( const WarpRef &warp, float id )
+{
+	ofIndexType base = (ofIndexType)mVertices.size();
+
+	if( warp->getType() == Warp::PERSPECTIVE ) {
+		// a single quad, the projective q coordinate makes it perspective correct
+		WarpPerspectiveRef wp = std::static_pointer_cast<WarpPerspective>( warp );
+		glm::mat4 transform = wp->getTransform();
+
+		float w = float( wp->getWidth() );
+		float h = float( wp->getHeight() );
+		glm::vec2 corners[4] = { glm::vec2( 0, 0 ), glm::vec2( w, 0 ), glm::vec2( w, h ), glm::vec2( 0, h ) };
+		glm::vec2 texcoords[4] = { glm::vec2( 0, 0 ), glm::vec2( 1, 0 ), glm::vec2( 1, 1 ), glm::vec2( 0, 1 ) };
+
+		for( int i = 0; i < 4; ++i ) {
+			glm::vec4 pt = transform * glm::vec4( corners[i].x, corners[i].y, 0, 1 );
+			float q = pt.w;
+			if( pt.w != 0 ) pt.w = 1 / pt.w;
+
+			mVertices.push_back( glm::vec3( pt.x * pt.w, pt.y * pt.w, q ) );
+			mTexCoords.push_back( texcoords[i] );
+			mWarpIds.push_back( id );
+		}
+
+		const ofIndexType indices[6] = { 0, 1, 2, 0, 2, 3 };
+		for( int i = 0; i < 6; ++i )
+			mIndices.push_back( base + indices[i] );
+	}
+	else {
+		WarpBilinearRef wb = std::static_pointer_cast<WarpBilinear>( warp );
+		if( !wb->mVboMesh ) return;
+
+		const std::vector<glm::vec3> &vertices = wb->mVboMesh->getVertices();
+		const std::vector<glm::vec2> &texcoords = wb->mVboMesh->getTexCoords();
+		const std::vector<ofIndexType> &indices = wb->mVboMesh->getIndices();
+
+		// perspective-bilinear warps that do not bake their transform are projected here
+		bool project = false;
+		glm::mat4 transform;
+		if( warp->getType() == Warp::PERSPECTIVE_BILINEAR ) {
+			WarpPerspectiveBilinearRef pb = std::static_pointer_cast<WarpPerspectiveBilinear>( warp );
+			project = !pb->isTransformBaked();
+			transform = pb->getTransform();
+		}
+
+		for( size_t i = 0; i < vertices.size(); ++i ) {
+			if( project ) {
+				glm::vec4 pt = transform * glm::vec4( vertices[i].x, vertices[i].y, 0, 1 );
+				float q = pt.w;
+				if( pt.w != 0 ) pt.w = 1 / pt.w;
+
+				mVertices.push_back( glm::vec3( pt.x * pt.w, pt.y * pt.w, q ) );
+			}
+			else {
+				mVertices.push_back( vertices[i] );
+			}
+			mTexCoords.push_back( texcoords[i] );
+			mWarpIds.push_back( id );
+		}
+
+		for( size_t i = 0; i < indices.size(); ++i )
+			mIndices.push_back( base + indices[i] );
+	}
+}
+
+void WarpRenderer::updateTables( const WarpList &warps )
+{
+	std::vector<Tables> tables;
+
+	for( WarpConstIter itr = warps.begin(); itr != warps.end(); ++itr ) {
+		const WarpRef &warp = *itr;
+		if( isUnbatched( warp ) )
+			continue;
+
+		Tables entry;
+		entry.mask = nullptr;
+		entry.numBakes = 0;
+		entry.lut = nullptr;
+		entry.numBuilds = 0;
+
+		// the same tables the warp uses when it is drawn by itself, baked only if any of their parameters have changed
+		unsigned features = 0;
+		if( warp->getType() == Warp::PERSPECTIVE )
+			features = std::static_pointer_cast<WarpPerspective>( warp )->getShaderFeatures( GL_TEXTURE_2D );
+		else
+			features = std::static_pointer_cast<WarpBilinear>( warp )->getShaderFeatures( GL_TEXTURE_2D );
+
+		if( features & WarpShaderCache::BLEND_MASK ) {
+			warp->mBlendMask.setSource( warp->blendTexture );
+			warp->mBlendMask.prepare( warp->getBlendSettings() );
+			entry.mask = &warp->mBlendMask;
+			entry.numBakes = warp->mBlendMask.getNumBakes();
+		}
+
+		if( features & WarpShaderCache::COLOR_LUT ) {
+			WarpBilinearRef wb = std::static_pointer_cast<WarpBilinear>( warp );
+			if( wb->sUseColorLut )
+				wb->mColorLut.setSource( wb->lutTexture );
+			wb->mColorLut.prepare( wb->getColorSettings() );
+			entry.lut = &wb->mColorLut;
+			entry.numBuilds = wb->mColorLut.getNumBuilds();
+		}
+
+		tables.push_back( entry );
+	}
+
+	// only pack and upload if any of the tables has changed
+	bool changed = ( tables.size() != mTables.size() );
+	for( size_t i = 0; i < tables.size() && !changed; ++i ) {
+		changed = ( tables[i].mask != mTables[i].mask || tables[i].numBakes != mTables[i].numBakes
+				   || tables[i].lut != mTables[i].lut || tables[i].numBuilds != mTables[i].numBuilds );
+	}
+
+	if( !changed ) return;
+
+	// pack the masks into as few layers as possible, the shader clamps to the region so no padding is needed
+	std::vector<ofRectangle> sizes;
+	for( size_t i = 0; i < tables.size(); ++i ) {
+		if( tables[i].mask )
+			sizes.push_back( ofRectangle( 0, 0, tables[i].mask->getPixels().getWidth(), tables[i].mask->getPixels().getHeight() ) );
+	}
+
+	std::vector<WarpAtlas::Region> regions = WarpAtlas::pack( sizes, MASK_PAGE_SIZE, MASK_PAGE_SIZE );
+
+	int width = 0, height = 0, layers = 0;
+	for( size_t i = 0, n = 0; i < tables.size(); ++i ) {
+		if( !tables[i].mask ) continue;
+
+		tables[i].region = regions[n++];
+		if( tables[i].region.page < 0 ) continue;
+
+		width = std::max( width, (int)tables[i].region.rect.getRight() );
+		height = std::max( height, (int)tables[i].region.rect.getBottom() );
+		layers = std::max( layers, tables[i].region.page + 1 );
+	}
+
+	if( layers > 0 ) {
+		if( !mMaskTextureId )
+			glGenTextures( 1, &mMaskTextureId );
+
+		// half floats are precise enough for the blend factors of 8-bit output
+		glBindTexture( GL_TEXTURE_2D_ARRAY, mMaskTextureId );
+		glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+		glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+		glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+		glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+		glTexImage3D( GL_TEXTURE_2D_ARRAY, 0, GL_RGB16F, width, height, layers, 0, GL_RGB, GL_FLOAT, nullptr );
+
+		for( size_t i = 0; i < tables.size(); ++i ) {
+			if( !tables[i].mask || tables[i].region.page < 0 ) continue;
+
+			const ofFloatPixels &pixels = tables[i].mask->getPixels();
+			glTexSubImage3D( GL_TEXTURE_2D_ARRAY, 0, (int)tables[i].region.rect.x, (int)tables[i].region.rect.y, tables[i].region.page,
+							 (int)pixels.getWidth(), (int)pixels.getHeight(), 1, GL_RGB, GL_FLOAT, pixels.getData() );
+		}
+
+		glBindTexture( GL_TEXTURE_2D_ARRAY, 0 );
+	}
+
+	// place the luts side by side in a square of tiles, all luts have the same size
+	int numLuts = 0, size = 0;
+	for( size_t i = 0; i < tables.size(); ++i ) {
+		if( !tables[i].lut ) continue;
+
+		size = tables[i].lut->getSize();
+		numLuts++;
+	}
+
+	if( numLuts > 0 ) {
+		int columns = (int)std::ceil( std::sqrt( float( numLuts ) ) );
+		int rows = ( numLuts + columns - 1 ) / columns;
+		int lutWidth = columns * size;
+		int lutHeight = rows * size;
+
+		std::vector<float> data( size_t( lutWidth ) * lutHeight * size * 4, 0.0f );
+
+		for( size_t i = 0, n = 0; i < tables.size(); ++i ) {
+			if( !tables[i].lut ) continue;
+
+			int x = int( n % columns ) * size;
+			int y = int( n / columns ) * size;
+			tables[i].tile = glm::vec2( x, y );
+			n++;
+
+			// copy the rows of every blue slice, red changes fastest
+			const float *src = &tables[i].lut->getData()[0];
+			for( int b = 0; b < size; ++b ) {
+				for( int g = 0; g < size; ++g, src += size * 4 )
+					std::copy( src, src + size * 4, &data[( ( size_t( b ) * lutHeight + y + g ) * lutWidth + x ) * 4] );
+			}
+		}
+
+		if( !mLutTextureId )
+			glGenTextures( 1, &mLutTextureId );
+
+		glBindTexture( GL_TEXTURE_3D, mLutTextureId );
+		glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+		glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+		glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+		glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+		glTexParameteri( GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE );
+		glTexImage3D( GL_TEXTURE_3D, 0, GL_RGBA32F, lutWidth, lutHeight, size, 0, GL_RGBA, GL_FLOAT, &data[0] );
+		glBindTexture( GL_TEXTURE_3D, 0 );
+	}
+
+	mTables.swap( tables );
+	mNumTableUpdates++;
+}
+
+void WarpRenderer::updateParameters( const WarpList &warps, const ofTexture &texture )
+{
+	// rectangle textures are sampled in pixels, 2D textures in normalized coordinates
+	glm::vec2 scale( 1.0f );
+	if( texture.getTextureData().textureTarget == GL_TEXTURE_RECTANGLE_ARB )
+		scale = glm::vec2( texture.getWidth(), texture.getHeight() );
+
+	// every batch occupies a full uniform block, unused warps are left at zero
+	size_t numBatches = std::max<size_t>( mBatches.size(), 1 );
+	std::vector<float> data( numBatches * MAX_WARPS_PER_BATCH * PARAMS_PER_WARP * 4, 0.0f );
+
+	float *p = &data[0];
+	size_t index = 0;
+	for( WarpConstIter itr = warps.begin(); itr != warps.end(); ++itr ) {
+		const WarpRef &warp = *itr;
+		if( isUnbatched( warp ) )
+			continue;
+
+		const Tables &tables = mTables[index++];
+		bool hasMask = tables.mask && tables.region.page >= 0;
+
+		float w = float( warp->mWidth );
+		float h = float( warp->mHeight );
+
+		// extends
+		*p++ = w;
+		*p++ = h;
+		*p++ = w / float( warp->mControlsX - 1 );
+		*p++ = h / float( warp->mControlsY - 1 );
+		// texture region, the texture holds all content but the warp only displays its area
+		ofRectangle area = warp->getContentArea();
+		*p++ = area.x / w * scale.x;
+		*p++ = area.y / h * scale.y;
+		*p++ = area.width / w * scale.x;
+		*p++ = area.height / h * scale.y;
+		// region of the blend mask in its layer, in pixels
+		*p++ = hasMask ? tables.region.rect.x : 0.0f;
+		*p++ = hasMask ? tables.region.rect.y : 0.0f;
+		*p++ = hasMask ? tables.region.rect.width : 0.0f;
+		*p++ = hasMask ? tables.region.rect.height : 0.0f;
+		// tile of the color lut, layer of the blend mask and whether the lut is used
+		*p++ = tables.tile.x;
+		*p++ = tables.tile.y;
+		*p++ = hasMask ? float( tables.region.page ) : 0.0f;
+		*p++ = tables.lut ? 1.0f : 0.0f;
+		// brightness, compiled into the lut if the warp has one, and edit mode
+		*p++ = tables.lut ? 1.0f : warp->mBrightness;
+		*p++ = warp->isEditModeEnabled() ? 1.0f : 0.0f;
+		*p++ = 0.0f;
+		*p++ = 0.0f;
+	}
+
+	// only upload if anything has changed
+	if( data == mParamData ) return;
+
+	if( data.size() != mParamData.size() )
+		mParams.allocate( data.size() * sizeof( float ), GL_DYNAMIC_DRAW );
+
+	mParams.updateData( 0, data.size() * sizeof( float ), &data[0] );
+	mParamData.swap( data );
+
+	mNumParameterUpdates++;
+}
+
+bool WarpRenderer::isUnbatched( const WarpRef &warp ) const
+{
+	// a user-supplied blend mask that does not fit a layer of the mask array
+	const ofTexture &blend = warp->blendTexture;
+	if( blend.isAllocated() && ( blend.getWidth() > MASK_PAGE_SIZE || blend.getHeight() > MASK_PAGE_SIZE ) ) return true;
+
+	return ( warp->getType() == Warp::UNKNOWN );
+}
+
+void WarpRenderer::createShader( GLenum textureTarget )
+{
+	if( mShader && mShaderTarget == textureTarget )
+		return;
+
+	mShader = make_shared<ofShader>();
+	mShaderTarget = textureTarget;
+
+	static string VertShader = R"END(
+		uniform mat4 modelViewProjectionMatrix;
+
+		in vec4 position;
+		in vec2 texcoord;
+		in float warpId;
+
+		out vec2 vertTexCoord0;
+		flat out int vertWarpId;
+
+		void main( void )
+		{
+			vertTexCoord0 = texcoord;
+			vertWarpId = int( warpId + 0.5 );
+
+			// position.z holds the projective q coordinate, which makes the interpolation perspective correct
+			gl_Position = modelViewProjectionMatrix * vec4( position.xy * position.z, 0.0, position.z );
+		}
+	)END";
+
+	static string FragShader = R"END(
+		uniform SAMPLER			uTex0;
+		uniform sampler3D		uColorLuts;
+		uniform sampler2DArray	uBlendMasks;
+
+		layout(std140) uniform WarpParams {
+			vec4 uParams[MAX_WARPS * PARAMS_PER_WARP];
+		};
+
+		in vec2 vertTexCoord0;
+		flat in int vertWarpId;
+
+		out vec4 outputColor;
+
+		float grid( in vec2 uv, in vec2 size )
+		{
+			vec2 coord = uv / size;
+			vec2 grid = abs( fract( coord - 0.5 ) - 0.5 ) / ( 2.0 * fwidth( coord ) );
+			float line = min( grid.x, grid.y );
+			return 1.0 - min( line, 1.0 );
+		}
+
+		void main( void )
+		{
+			int base = vertWarpId * PARAMS_PER_WARP;
+			vec4 extends = uParams[base];
+			vec4 region = uParams[base + 1];
+			vec4 mask = uParams[base + 2];
+			vec4 lut = uParams[base + 3];
+			vec4 settings = uParams[base + 4];
+
+			vec2 uv = vertTexCoord0;
+			vec4 texColor = texture( uTex0, region.xy + uv * region.zw );
+
+			if( lut.w > 0.0 ) {
+				// brightness, contrast, saturation, color matrix and color lut, compiled into the tile of the warp
+				vec3 size = vec3( textureSize( uColorLuts, 0 ) );
+				vec3 coord = clamp( texColor.rgb, 0.0, 1.0 ) * ( size.z - 1.0 ) + 0.5;
+				texColor.rgb = texture( uColorLuts, ( vec3( lut.xy, 0.0 ) + coord ) / size ).rgb;
+			}
+			else {
+				texColor.rgb *= settings.x;
+			}
+
+			if( mask.z > 0.0 ) {
+				// edge blending and gamma, baked into the region of the warp, clamped like a texture of its own
+				vec2 coord = mask.xy + clamp( uv * mask.zw, vec2( 0.5 ), mask.zw - 0.5 );
+				texColor.rgb *= texture( uBlendMasks, vec3( coord / vec2( textureSize( uBlendMasks, 0 ).xy ), lut.z ) ).rgb;
+			}
+
+			if( settings.y > 0.0 ) {
+				float f = grid( uv * extends.xy, extends.zw );
+				outputColor = mix( texColor, vec4( 1.0 ), f );
+			}
+			else {
+				outputColor = texColor;
+			}
+		}
+	)END";
+
+	string header = "#version 150\n";
+	header += "#define MAX_WARPS " + ofToString( (int)MAX_WARPS_PER_BATCH ) + "\n";
+	header += "#define PARAMS_PER_WARP " + ofToString( (int)PARAMS_PER_WARP ) + "\n";
+	if( textureTarget == GL_TEXTURE_RECTANGLE_ARB )
+		header += "#define SAMPLER sampler2DRect\n";
+	else
+		header += "#define SAMPLER sampler2D\n";
+
+	try {
+		mShader->setupShaderFromSource( GL_VERTEX_SHADER, header + VertShader );
+		mShader->setupShaderFromSource( GL_FRAGMENT_SHADER, header + FragShader );
+		mShader->bindDefaults();
+		mShader->bindAttribute( WARP_ID_ATTRIBUTE, "warpId" );
+		mShader->linkProgram();
+		mShader->bindUniformBlock( 0, "WarpParams" );
+	}
+	catch( const std::exception &e ) {
+		cout << e.what() << std::endl;
+	}
+}
@@ -0,0 +1,126 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "Warp.h"
+#include "WarpAtlas.h"
+
+//! Draws all warps of a WarpList in as few draw calls as possible. The meshes of all warps are packed
+//! into a single vertex buffer with a per-vertex warp id, the parameters of each warp are stored in a
+//! uniform buffer. The baked blend masks of all warps are packed into the layers of a texture array and
+//! their color luts into a single 3D texture, so the shader does the same fetches as the warp shaders.
+class WarpRenderer {
+	public:
+		WarpRenderer();
+		virtual ~WarpRenderer(void);
+
+		//! draws all warps using the same content texture
+		void				draw(const WarpList &warps, const ofTexture &texture);
+
+		//! returns the number of draw calls issued by the last call to draw()
+		int					getNumDrawCalls() const { return mNumDrawCalls; }
+		//! returns the number of draw calls the warps would have issued when drawn one by one
+		int					getNumUnbatchedDrawCalls() const { return mNumUnbatchedDrawCalls; }
+		//! returns the number of times the vertex buffer has been rebuilt
+		int					getNumGeometryUpdates() const { return mNumGeometryUpdates; }
+		//! returns the number of times the warp parameters have been uploaded
+		int					getNumParameterUpdates() const { return mNumParameterUpdates; }
+		//! returns the number of times the blend masks and color luts have been packed and uploaded
+		int					getNumTableUpdates() const { return mNumTableUpdates; }
+
+		//! maximum number of warps drawn by a single draw call
+		static const int	MAX_WARPS_PER_BATCH = 64;
+		//! number of vec4's in the uniform buffer per warp
+		static const int	PARAMS_PER_WARP = 5;
+		//! attribute location of the warp id
+		static const int	WARP_ID_ATTRIBUTE = 4;
+		//! maximum width and height of a layer of the blend mask array, warps with a larger blend texture are drawn by themselves
+		static const int	MASK_PAGE_SIZE = 2048;
+
+	protected:
+		//! updates the meshes of all warps, returns true if any of them has changed
+		bool				updateWarps(const WarpList &warps);
+		//! packs the meshes of all warps into the vertex buffer
+		void				createBuffers(const WarpList &warps);
+		//! adds the mesh of a single warp to the vertex arrays
+		void				addWarp(const WarpRef &warp, float id);
+		//! bakes the blend masks and color luts of all batched warps, packs and uploads them only if any has changed
+		void				updateTables(const WarpList &warps);
+		//! packs the parameters of all warps into the uniform buffer, uploads only if changed
+		void				updateParameters(const WarpList &warps, const ofTexture &texture);
+		//! returns true if the warp can not be batched and must be drawn by itself
+		bool				isUnbatched(const WarpRef &warp) const;
+		//! creates the batched shader for either GL_TEXTURE_2D or GL_TEXTURE_RECTANGLE_ARB
+		void				createShader(GLenum textureTarget);
+
+	protected:
+		ofVbo						mVbo;
+		ofBufferObject				mParams;
+		shared_ptr<ofShader>		mShader;
+		GLenum						mShaderTarget;
+
+		//! state of a warp when it was added to the vertex buffer, used to detect changes
+		typedef struct Entry {
+			Warp*		warp;
+			unsigned	revision;
+			glm::mat4x4	transform;
+			bool		unbatched;
+		} Entry;
+
+		//! returns the current state of the warp
+		Entry				getEntry(const WarpRef &warp) const;
+
+		std::vector<Entry>			mWarps;
+
+		//! blend mask and color lut of a batched warp, and where they are packed
+		typedef struct Tables {
+			const WarpBlendMask	*mask;
+			int					numBakes;
+			WarpAtlas::Region	region;
+			const WarpColorLut	*lut;
+			int					numBuilds;
+			glm::vec2			tile;
+		} Tables;
+
+		//! tables of the batched warps when they were last packed, used to detect changes
+		std::vector<Tables>			mTables;
+		//! blend masks, a layer per page of the packed masks
+		GLuint						mMaskTextureId;
+		//! color luts, side by side
+		GLuint						mLutTextureId;
+
+		std::vector<glm::vec3>		mVertices;
+		std::vector<glm::vec2>		mTexCoords;
+		std::vector<float>			mWarpIds;
+		std::vector<ofIndexType>	mIndices;
+		//! first index and number of indices of each batch
+		std::vector<std::pair<int, int>>	mBatches;
+
+		//! last uploaded parameters
+		std::vector<float>			mParamData;
+
+		int							mNumDrawCalls;
+		int							mNumUnbatchedDrawCalls;
+		int							mNumGeometryUpdates;
+		int							mNumParameterUpdates;
+		int							mNumTableUpdates;
+};
@@ -0,0 +1,86 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+//! Bounded lock-free queue for exactly one producer and one consumer thread. Used to connect the stages of
+//! WarpPipeline: each stage only reads from one queue and writes to the next, so no locks are needed.
+template<typename T>
+class WarpRing {
+	public:
+		//! creates a queue that holds up to capacity elements
+		explicit WarpRing(size_t capacity) : mBuffer(capacity + 1), mHead(0), mTail(0), mMaxSize(0) {}
+
+		//! adds an element, returns false if the queue is full. Only call from the producer thread.
+		bool push(const T &value)
+		{
+			size_t tail = mTail.load( std::memory_order_relaxed );
+			size_t next = ( tail + 1 ) % mBuffer.size();
+			if( next == mHead.load( std::memory_order_acquire ) ) return false;
+
+			mBuffer[tail] = value;
+			mTail.store( next, std::memory_order_release );
+
+			// the producer is the only writer of the peak size
+			size_t count = size();
+			if( count > mMaxSize.load( std::memory_order_relaxed ) )
+				mMaxSize.store( count, std::memory_order_relaxed );
+			return true;
+		}
+
+		//! removes the oldest element, returns false if the queue is empty. Only call from the consumer thread.
+		bool pop(T &value)
+		{
+			size_t head = mHead.load( std::memory_order_relaxed );
+			if( head == mTail.load( std::memory_order_acquire ) ) return false;
+
+			value = mBuffer[head];
+			mHead.store( ( head + 1 ) % mBuffer.size(), std::memory_order_release );
+			return true;
+		}
+
+		//! returns the number of elements in the queue, approximate while the other thread is active
+		size_t size() const
+		{
+			size_t head = mHead.load( std::memory_order_acquire );
+			size_t tail = mTail.load( std::memory_order_acquire );
+			return ( tail + mBuffer.size() - head ) % mBuffer.size();
+		}
+		//! returns the maximum number of elements
+		size_t capacity() const { return mBuffer.size() - 1; }
+		//! returns the largest number of elements the queue has held
+		size_t getMaxSize() const { return mMaxSize.load( std::memory_order_relaxed ); }
+
+	private:
+		WarpRing(const WarpRing&);
+		WarpRing& operator=(const WarpRing&);
+
+	private:
+		std::vector<T>				mBuffer;
+		//! consumer and producer positions on separate cache lines, so the threads don't invalidate each other
+		alignas(64) std::atomic<size_t>	mHead;
+		alignas(64) std::atomic<size_t>	mTail;
+		std::atomic<size_t>			mMaxSize;
+};
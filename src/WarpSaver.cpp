@@ -0,0 +1,154 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarpSaver.h"
+#include "WarpProfiles.h"
+
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+WarpSaver::WarpSaver()
+	: mHasPending( false )
+	, mIsWriting( false )
+	, mIsStopping( false )
+	, mNumRequests( 0 )
+	, mNumWrites( 0 )
+	, mLastResult( true )
+{
+}
+
+WarpSaver::~WarpSaver()
+{
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mIsStopping = true;
+	}
+	mCondition.notify_all();
+
+	// the thread writes the pending request before it exits
+	if( mThread.joinable() )
+		mThread.join();
+}
+
+void WarpSaver::save( const WarpList &warps, const std::string &path, Format format )
+{
+	std::string file = ofToDataPath( path );
+
+	{
+		// copying the parameters is cheap, the thread only swaps the request out under the lock
+		std::lock_guard<std::mutex> lock( mMutex );
+		WarpSettings::takeSnapshot( warps, mPending.snapshot );
+		mPending.path = file;
+		mPending.format = format;
+		mHasPending = true;
+
+		if( !mThread.joinable() )
+			mThread = std::thread( &WarpSaver::run, this );
+	}
+
+	mNumRequests++;
+	mCondition.notify_all();
+}
+
+void WarpSaver::flush()
+{
+	std::unique_lock<std::mutex> lock( mMutex );
+	mCondition.wait( lock, [this] { return !mHasPending && !mIsWriting; } );
+}
+
+bool WarpSaver::isSaving() const
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mHasPending || mIsWriting;
+}
+
+void WarpSaver::run()
+{
+	Request request;
+	std::string buffer;
+
+	std::unique_lock<std::mutex> lock( mMutex );
+	for( ;; ) {
+		mCondition.wait( lock, [this] { return mHasPending || mIsStopping; } );
+		if( !mHasPending ) break;
+
+		// take the most recent request, keeping the memory of the previous one for the next snapshot
+		std::swap( request, mPending );
+		mHasPending = false;
+		mIsWriting = true;
+		lock.unlock();
+
+		if( request.format == BINARY ) {
+			WarpSettings::write( request.snapshot, buffer );
+		}
+		else {
+			// the other profiles in the file are kept
+			WarpProfiles::merge( request.path, "", request.snapshot, buffer );
+		}
+
+		bool result = writeAtomic( request.path, buffer );
+		if( !result )
+			cout << "WarpSaver: could not write " << request.path << endl;
+
+		lock.lock();
+		mIsWriting = false;
+		mLastResult = result;
+		mNumWrites++;
+		mCondition.notify_all();
+	}
+}
+
+bool WarpSaver::writeAtomic( const std::string &path, const std::string &buffer )
+{
+	std::string temp = path + ".tmp";
+
+	FILE *file = fopen( temp.c_str(), "wb" );
+	if( !file ) return false;
+
+	bool result = fwrite( buffer.data(), 1, buffer.size(), file ) == buffer.size() && fflush( file ) == 0;
+
+	// make sure the data is on disk before the rename makes it visible
+#if defined(_WIN32)
+	result = result && _commit( _fileno( file ) ) == 0;
+#else
+	result = result && fsync( fileno( file ) ) == 0;
+#endif
+
+	result = ( fclose( file ) == 0 ) && result;
+
+#if defined(_WIN32)
+	result = result && MoveFileExA( temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH );
+#else
+	result = result && rename( temp.c_str(), path.c_str() ) == 0;
+#endif
+
+	if( !result )
+		remove( temp.c_str() );
+
+	return result;
+}
@@ -0,0 +1,89 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "WarpSettings.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+//! Saves settings without blocking the render thread. save() only copies the warp parameters into a snapshot;
+//! serializing and writing happen on a background thread. Files are written to a temporary file first and then
+//! renamed over the target, so a crash never leaves a partially written file. Saves that are requested while
+//! the previous one is still being written are coalesced, only the most recent one is written.
+class WarpSaver {
+	public:
+		typedef enum { XML, BINARY } Format;
+
+	public:
+		WarpSaver();
+		//! waits for the last requested save to be written
+		virtual ~WarpSaver(void);
+
+		//! snapshots the warps and queues them to be written, returns immediately. Like Warp::writeSettings, an xml file
+		//! keeps its other profiles, a binary file holds only these warps.
+		void				save(const WarpList &warps, const std::string &path, Format format = XML);
+		//! blocks until all requested saves are written
+		void				flush();
+
+		//! returns true if a save is queued or being written
+		bool				isSaving() const;
+		//! returns the number of saves requested and the number of files actually written
+		uint64_t			getNumRequests() const { return mNumRequests; }
+		uint64_t			getNumWrites() const { return mNumWrites; }
+		//! returns false if the last write failed
+		bool				getLastResult() const { return mLastResult; }
+
+		//! writes a buffer to a temporary file next to the path and renames it over the path, returns false on failure
+		static bool			writeAtomic(const std::string &path, const std::string &buffer);
+
+	protected:
+		//! a snapshot waiting to be written
+		typedef struct Request {
+			WarpSettings::Snapshot	snapshot;
+			std::string				path;
+			Format					format;
+		} Request;
+
+		void				run();
+
+	private:
+		WarpSaver(const WarpSaver&);
+		WarpSaver& operator=(const WarpSaver&);
+
+	protected:
+		mutable std::mutex			mMutex;
+		std::condition_variable		mCondition;
+		std::thread					mThread;
+
+		//! the most recent request, replaced by newer ones until the thread picks it up
+		Request						mPending;
+		bool						mHasPending;
+		bool						mIsWriting;
+		bool						mIsStopping;
+
+		std::atomic<uint64_t>		mNumRequests;
+		std::atomic<uint64_t>		mNumWrites;
+		std::atomic<bool>			mLastResult;
+};
@@ -0,0 +1,602 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarpSettings.h"
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert( sizeof( WarpSettings::Header ) == 32, "unexpected header layout" );
+static_assert( sizeof( WarpSettings::Block ) == 184, "unexpected block layout" );
+
+static const char sMagic[4] = { 'W', 'P', 'S', 'T' };
+
+WarpSettings::WarpSettings()
+	: mData( nullptr )
+	, mSize( 0 )
+	, mHeader( nullptr )
+	, mFile( nullptr )
+	, mMapping( nullptr )
+{
+}
+
+WarpSettings::~WarpSettings()
+{
+	close();
+}
+
+bool WarpSettings::open( const std::string &path )
+{
+	close();
+
+	std::string file = ofToDataPath( path );
+
+#if defined(_WIN32)
+	HANDLE handle = CreateFileA( file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( handle == INVALID_HANDLE_VALUE ) return false;
+
+	LARGE_INTEGER size;
+	GetFileSizeEx( handle, &size );
+	HANDLE mapping = ( size.QuadPart > 0 ) ? CreateFileMappingA( handle, nullptr, PAGE_READONLY, 0, 0, nullptr ) : nullptr;
+	if( !mapping ) {
+		CloseHandle( handle );
+		return false;
+	}
+
+	mData = (const uint8_t*)MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	mSize = (size_t)size.QuadPart;
+	mFile = handle;
+	mMapping = mapping;
+#else
+	int fd = ::open( file.c_str(), O_RDONLY );
+	if( fd < 0 ) return false;
+
+	struct stat info;
+	if( fstat( fd, &info ) != 0 || info.st_size <= 0 ) {
+		::close( fd );
+		return false;
+	}
+
+	// the mapping stays valid after the descriptor is closed
+	void *data = mmap( nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	::close( fd );
+	if( data == MAP_FAILED ) return false;
+
+	mData = (const uint8_t*)data;
+	mSize = (size_t)info.st_size;
+#endif
+
+	if( !mData ) {
+		close();
+		return false;
+	}
+
+	// validate everything that is accessed later, so the accessors don't have to
+	const Header *header = (const Header*)mData;
+	bool valid = mSize >= sizeof( Header ) && memcmp( header->magic, sMagic, 4 ) == 0 && header->version >= 1 && header->version <= VERSION
+		&& header->blockSize >= getBlockSize( header->version ) && header->fileSize == mSize
+		&& header->numWarps <= ( mSize - sizeof( Header ) ) / header->blockSize;
+
+	// older blocks are copied and get the defaults of the fields they lack, current ones are used in place
+	bool isUpgraded = valid && header->blockSize < sizeof( Block );
+	for( uint32_t i = 0; valid && i < header->numWarps; ++i ) {
+		const uint8_t *data = mData + sizeof( Header ) + size_t( i ) * header->blockSize;
+		if( isUpgraded ) {
+			mBlocks.push_back( upgradeBlock( data, header->version, header->blockSize ) );
+			data = (const uint8_t*)&mBlocks.back();
+		}
+
+		const Block &block = *(const Block*)data;
+		valid = ( block.pointsOffset % ALIGNMENT ) == 0 && block.pointsOffset <= mSize
+			&& block.numPoints <= ( mSize - block.pointsOffset ) / sizeof( glm::vec2 ) && isValidGrid( block );
+	}
+
+	if( !valid ) {
+		cout << "WarpSettings: " << path << " is not a valid settings file" << endl;
+		close();
+		return false;
+	}
+
+	mHeader = header;
+	return true;
+}
+
+void WarpSettings::close()
+{
+#if defined(_WIN32)
+	if( mData ) UnmapViewOfFile( mData );
+	if( mMapping ) CloseHandle( (HANDLE)mMapping );
+	if( mFile ) CloseHandle( (HANDLE)mFile );
+#else
+	if( mData ) munmap( (void*)mData, mSize );
+#endif
+
+	mData = nullptr;
+	mSize = 0;
+	mHeader = nullptr;
+	mBlocks.clear();
+	mFile = nullptr;
+	mMapping = nullptr;
+}
+
+const WarpSettings::Block& WarpSettings::getBlock( size_t index ) const
+{
+	if( !mBlocks.empty() )
+		return mBlocks[index];
+
+	return *(const Block*)( mData + sizeof( Header ) + index * mHeader->blockSize );
+}
+
+const glm::vec2* WarpSettings::getPoints( size_t index ) const
+{
+	return (const glm::vec2*)( mData + getBlock( index ).pointsOffset );
+}
+
+WarpList WarpSettings::getWarps() const
+{
+	WarpList warps;
+	for( size_t i = 0; i < getNumWarps(); ++i ) {
+		WarpRef warp = fromBlock( getBlock( i ), getPoints( i ) );
+		if( warp )
+			warps.push_back( warp );
+	}
+
+	return warps;
+}
+
+bool WarpSettings::write( const WarpList &warps, const std::string &path )
+{
+	Snapshot snapshot;
+	takeSnapshot( warps, snapshot );
+
+	std::string buffer;
+	write( snapshot, buffer );
+
+	std::ofstream file( ofToDataPath( path ).c_str(), std::ios::binary | std::ios::trunc );
+	if( !file ) {
+		cout << "WarpSettings: could not write " << path << endl;
+		return false;
+	}
+
+	file.write( buffer.data(), buffer.size() );
+	return file.good();
+}
+
+void WarpSettings::takeSnapshot( const WarpList &warps, Snapshot &snapshot )
+{
+	snapshot.blocks.resize( warps.size() );
+	snapshot.points.clear();
+
+	for( size_t i = 0; i < warps.size(); ++i ) {
+		Block &block = snapshot.blocks[i];
+		toBlock( *warps[i], block );
+
+		block.pointsOffset = snapshot.points.size();
+		snapshot.points.insert( snapshot.points.end(), warps[i]->mPoints.begin(), warps[i]->mPoints.end() );
+	}
+}
+
+void WarpSettings::write( const Snapshot &snapshot, std::string &buffer )
+{
+	Header header;
+	memcpy( header.magic, sMagic, 4 );
+	header.version = VERSION;
+	header.numWarps = (uint32_t)snapshot.blocks.size();
+	header.blockSize = sizeof( Block );
+	header.reserved = 0;
+
+	// the point arrays follow the blocks, each one aligned
+	std::vector<Block> blocks = snapshot.blocks;
+	uint64_t offset = sizeof( Header ) + blocks.size() * sizeof( Block );
+	for( Block &block : blocks ) {
+		offset = ( offset + ALIGNMENT - 1 ) / ALIGNMENT * ALIGNMENT;
+		block.pointsOffset = offset;
+		offset += block.numPoints * sizeof( glm::vec2 );
+	}
+	header.fileSize = offset;
+
+	// padding is zero
+	buffer.assign( (size_t)offset, '\0' );
+	memcpy( &buffer[0], &header, sizeof( Header ) );
+	if( !blocks.empty() )
+		memcpy( &buffer[sizeof( Header )], &blocks[0], blocks.size() * sizeof( Block ) );
+
+	for( size_t i = 0; i < blocks.size(); ++i ) {
+		if( blocks[i].numPoints )
+			memcpy( &buffer[blocks[i].pointsOffset], &snapshot.points[snapshot.blocks[i].pointsOffset], blocks[i].numPoints * sizeof( glm::vec2 ) );
+	}
+}
+
+void WarpSettings::writeXml( const Snapshot &snapshot, WarpXmlWriter &writer )
+{
+	// create config document and root <warpconfig>
+	writer.begin( "warpconfig" );
+	writer.attribute( "version", "1.0" );
+	writer.attribute( "profile", "default" );
+
+	// create a single <profile>, see WarpProfiles for files with more than one
+	writeXml( "default", snapshot, writer );
+
+	writer.end();
+}
+
+void WarpSettings::writeXml( const std::string &profile, const Snapshot &snapshot, WarpXmlWriter &writer )
+{
+	writer.begin( "profile" );
+	writer.attribute( "name", profile );
+
+	for( size_t i = 0; i < snapshot.blocks.size(); ++i ) {
+		// create <map>
+		writer.begin( "map" );
+		writer.attribute( "id", int( i + 1 ) );
+		writer.attribute( "display", 1 );	// not supported yet
+
+		// create <warp>
+		const Block &block = snapshot.blocks[i];
+		writer.begin( "warp" );
+		writeXml( block, snapshot.points.data() + block.pointsOffset, writer );
+		writer.end();
+
+		writer.end();
+	}
+
+	writer.end();
+}
+
+void WarpSettings::writeXml( const Block &block, const glm::vec2 *points, WarpXmlWriter &writer )
+{
+	switch( block.type ) {
+		case Warp::BILINEAR: writer.attribute( "method", "bilinear" ); break;
+		case Warp::PERSPECTIVE: writer.attribute( "method", "perspective" ); break;
+		case Warp::PERSPECTIVE_BILINEAR: writer.attribute( "method", "perspectivebilinear" ); break;
+		default: writer.attribute( "method", "unknown" ); break;
+	}
+
+	writer.attribute( "width", block.controlsX );
+	writer.attribute( "height", block.controlsY );
+	writer.attribute( "brightness", block.brightness );
+	writer.attribute( "contrast", block.contrast );
+	writer.attribute( "saturation", block.saturation );
+
+	// add <controlpoint> tags (column-major)
+	for( uint32_t i = 0; i < block.numPoints; ++i ) {
+		writer.begin( "controlpoint" );
+		writer.attribute( "x", points[i].x );
+		writer.attribute( "y", points[i].y );
+		writer.end();
+	}
+
+	// add <blend> parameters
+	writer.begin( "blend" );
+	writer.attribute( "exponent", block.exponent );
+	if( block.type == Warp::BILINEAR ) {
+		writer.attribute( "resolution", block.resolution );
+		writer.attribute( "linear", ( block.flags & LINEAR ) != 0 );
+		writer.attribute( "adaptive", ( block.flags & ADAPTIVE ) != 0 );
+	}
+
+	writer.begin( "edges" );
+	writer.attribute( "left", block.edges[0] );
+	writer.attribute( "top", block.edges[1] );
+	writer.attribute( "right", block.edges[2] );
+	writer.attribute( "bottom", block.edges[3] );
+	writer.end();
+
+	writer.begin( "gamma" );
+	writer.attribute( "red", block.gamma[0] );
+	writer.attribute( "green", block.gamma[1] );
+	writer.attribute( "blue", block.gamma[2] );
+	writer.end();
+
+	writer.begin( "luminance" );
+	writer.attribute( "red", block.luminance[0] );
+	writer.attribute( "green", block.luminance[1] );
+	writer.attribute( "blue", block.luminance[2] );
+	writer.end();
+
+	writer.end();
+
+	// add <colormatrix>, a row per output channel. Left out if it is the identity, like in older files
+	static const float identity[9] = { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+	if( memcmp( block.colorMatrix, identity, sizeof( identity ) ) != 0 ) {
+		writer.begin( "colormatrix" );
+		for( unsigned i = 0; i < 3; ++i ) {
+			writer.begin( "row" );
+			writer.attribute( "red", block.colorMatrix[0 + i] );
+			writer.attribute( "green", block.colorMatrix[3 + i] );
+			writer.attribute( "blue", block.colorMatrix[6 + i] );
+			writer.end();
+		}
+		writer.end();
+	}
+
+	// add <content>, the area of the content the warp displays. Left out if it displays all content
+	if( block.contentArea[2] > 0.0f && block.contentArea[3] > 0.0f ) {
+		writer.begin( "content" );
+		writer.attribute( "x", block.contentArea[0] );
+		writer.attribute( "y", block.contentArea[1] );
+		writer.attribute( "width", block.contentArea[2] );
+		writer.attribute( "height", block.contentArea[3] );
+		writer.end();
+	}
+
+	// add corners
+	if( block.type == Warp::PERSPECTIVE_BILINEAR ) {
+		for( unsigned i = 0; i < 4; ++i ) {
+			writer.begin( "corner" );
+			writer.attribute( "x", block.corners[i * 2 + 0] );
+			writer.attribute( "y", block.corners[i * 2 + 1] );
+			writer.end();
+		}
+	}
+}
+
+WarpList WarpSettings::read( const std::string &path )
+{
+	WarpSettings settings;
+	if( !settings.open( path ) )
+		return WarpList();
+
+	return settings.getWarps();
+}
+
+bool WarpSettings::isBinary( const std::string &path )
+{
+	char magic[4] = {};
+	std::ifstream file( ofToDataPath( path ).c_str(), std::ios::binary );
+	file.read( magic, 4 );
+
+	return file.good() && memcmp( magic, sMagic, 4 ) == 0;
+}
+
+bool WarpSettings::convertFromXml( const std::string &xmlPath, const std::string &binaryPath )
+{
+	WarpList warps = Warp::readSettings( xmlPath );
+	if( warps.empty() ) return false;
+
+	return write( warps, binaryPath );
+}
+
+bool WarpSettings::convertToXml( const std::string &binaryPath, const std::string &xmlPath )
+{
+	WarpList warps = read( binaryPath );
+	if( warps.empty() ) return false;
+
+	std::string target = xmlPath;
+	Warp::writeSettings( warps, target );
+	return true;
+}
+
+void WarpSettings::toBlock( const Warp &warp, Block &block )
+{
+	memset( &block, 0, sizeof( Block ) );
+
+	block.type = (uint32_t)warp.mType;
+	block.controlsX = warp.mControlsX;
+	block.controlsY = warp.mControlsY;
+	block.numPoints = (uint32_t)warp.mPoints.size();
+	block.brightness = warp.mBrightness;
+	block.contrast = warp.mContrast;
+	block.saturation = warp.mSaturation;
+	block.exponent = warp.mExponent;
+
+	block.edges[0] = warp.mEdges.x; block.edges[1] = warp.mEdges.y; block.edges[2] = warp.mEdges.z; block.edges[3] = warp.mEdges.w;
+	block.gamma[0] = warp.mGamma.x; block.gamma[1] = warp.mGamma.y; block.gamma[2] = warp.mGamma.z;
+	block.luminance[0] = warp.mLuminance.x; block.luminance[1] = warp.mLuminance.y; block.luminance[2] = warp.mLuminance.z;
+	for( int i = 0; i < 9; ++i ) block.colorMatrix[i] = warp.mColorMatrix[i / 3][i % 3];
+	block.contentArea[0] = warp.mContentArea.x; block.contentArea[1] = warp.mContentArea.y;
+	block.contentArea[2] = warp.mContentArea.width; block.contentArea[3] = warp.mContentArea.height;
+
+	// the same type specific values as the xml settings
+	if( warp.mType == Warp::BILINEAR ) {
+		const WarpBilinear &bilinear = (const WarpBilinear&)warp;
+		block.resolution = bilinear.mResolution;
+		block.flags = ( bilinear.mIsLinear ? LINEAR : 0 ) | ( bilinear.mIsAdaptive ? ADAPTIVE : 0 );
+	}
+	else if( warp.mType == Warp::PERSPECTIVE_BILINEAR ) {
+		const WarpPerspectiveBilinear &pb = (const WarpPerspectiveBilinear&)warp;
+		for( unsigned i = 0; i < 4; ++i ) {
+			glm::vec2 corner = pb.mWarp->getControlPoint( i );
+			block.corners[i * 2 + 0] = corner.x;
+			block.corners[i * 2 + 1] = corner.y;
+		}
+	}
+}
+
+size_t WarpSettings::getBlockSize( uint32_t version )
+{
+	// each version appends fields to the block
+	if( version < 2 ) return offsetof( Block, colorMatrix );
+	if( version < 3 ) return offsetof( Block, contentArea );
+	return sizeof( Block );
+}
+
+WarpSettings::Block WarpSettings::upgradeBlock( const uint8_t *data, uint32_t version, size_t size )
+{
+	Block block;
+	memset( &block, 0, sizeof( Block ) );
+	memcpy( &block, data, std::min( size, sizeof( Block ) ) );
+
+	if( version < 2 )
+		block.colorMatrix[0] = block.colorMatrix[4] = block.colorMatrix[8] = 1.0f;
+
+	return block;
+}
+
+ofRectangle WarpSettings::getContentArea( const Block &block )
+{
+	return ofRectangle( block.contentArea[0], block.contentArea[1], block.contentArea[2], block.contentArea[3] );
+}
+
+bool WarpSettings::isValidGrid( const Block &block )
+{
+	// the warps index their points as a controlsX x controlsY grid
+	return block.controlsX >= 2 && block.controlsY >= 2
+		&& uint64_t( block.controlsX ) * uint64_t( block.controlsY ) == block.numPoints;
+}
+
+WarpRef WarpSettings::fromBlock( const Block &block, const glm::vec2 *points )
+{
+	WarpRef warp;
+	switch( block.type ) {
+		case Warp::BILINEAR: warp = WarpRef( new WarpBilinear() ); break;
+		case Warp::PERSPECTIVE: warp = WarpRef( new WarpPerspective() ); break;
+		case Warp::PERSPECTIVE_BILINEAR: warp = WarpRef( new WarpPerspectiveBilinear() ); break;
+		default: return warp;
+	}
+
+	applyBlock( *warp, block, points );
+
+	// the warp has no size yet, setSize() fits the area to the content
+	warp->mContentArea = getContentArea( block );
+
+	// reconstruct warp
+	warp->mIsDirty = true;
+	warp->mIsUniformsDirty = true;
+	if( block.type == Warp::PERSPECTIVE_BILINEAR )
+		( (WarpPerspectiveBilinear&)*warp ).mIsScreenDirty = true;
+
+	return warp;
+}
+
+void WarpSettings::applyBlock( Warp &warp, const Block &block, const glm::vec2 *points )
+{
+	warp.mControlsX = block.controlsX;
+	warp.mControlsY = block.controlsY;
+	warp.mBrightness = block.brightness;
+	warp.mContrast = block.contrast;
+	warp.mSaturation = block.saturation;
+	warp.mExponent = block.exponent;
+	warp.mPoints.assign( points, points + block.numPoints );
+
+	warp.mEdges = ofVec4f( block.edges[0], block.edges[1], block.edges[2], block.edges[3] );
+	warp.mGamma = ofVec3f( block.gamma[0], block.gamma[1], block.gamma[2] );
+	warp.mLuminance = ofVec3f( block.luminance[0], block.luminance[1], block.luminance[2] );
+	for( int i = 0; i < 9; ++i ) warp.mColorMatrix[i / 3][i % 3] = block.colorMatrix[i];
+
+	if( block.type == Warp::BILINEAR ) {
+		WarpBilinear &bilinear = (WarpBilinear&)warp;
+		bilinear.mResolution = block.resolution;
+		bilinear.mIsLinear = ( block.flags & LINEAR ) != 0;
+		bilinear.mIsAdaptive = ( block.flags & ADAPTIVE ) != 0;
+	}
+	else if( block.type == Warp::PERSPECTIVE_BILINEAR ) {
+		WarpPerspectiveBilinear &pb = (WarpPerspectiveBilinear&)warp;
+		for( unsigned i = 0; i < 4; ++i )
+			pb.mWarp->setControlPoint( i, glm::vec2( block.corners[i * 2 + 0], block.corners[i * 2 + 1] ) );
+	}
+}
+
+WarpSettings::Changes WarpSettings::apply( const Snapshot &snapshot, WarpList &warps )
+{
+	Changes changes;
+
+	// new warps get the size of the existing ones
+	int width = warps.empty() ? 0 : warps.back()->getWidth();
+	int height = warps.empty() ? 0 : warps.back()->getHeight();
+
+	for( size_t i = 0; i < snapshot.blocks.size(); ++i ) {
+		const Block &next = snapshot.blocks[i];
+
+		// leave the warp as it is if its block is not valid
+		if( !isValidGrid( next ) || next.pointsOffset > snapshot.points.size() || next.numPoints > snapshot.points.size() - next.pointsOffset ) {
+			cout << "WarpSettings: warp " << i << " has an invalid control point grid, it is left unchanged" << endl;
+			continue;
+		}
+
+		const glm::vec2 *points = snapshot.points.data() + next.pointsOffset;
+
+		// a new warp, or one that changed its type, is created from scratch
+		if( i >= warps.size() || warps[i]->mType != (Warp::WarpType)next.type ) {
+			WarpRef warp = fromBlock( next, points );
+			if( !warp ) continue;
+
+			if( i < warps.size() ) {
+				warp->setSize( warps[i]->getWidth(), warps[i]->getHeight() );
+				warps[i] = warp;
+				changes.numReplaced++;
+			}
+			else {
+				if( width > 0 && height > 0 ) warp->setSize( width, height );
+				warps.push_back( warp );
+				changes.numAdded++;
+			}
+			continue;
+		}
+
+		Warp &warp = *warps[i];
+		Block live;
+		toBlock( warp, live );
+
+		// the grid size and mesh resolution determine the mesh topology
+		bool topology = live.controlsX != next.controlsX || live.controlsY != next.controlsY
+			|| live.resolution != next.resolution || ( ( live.flags ^ next.flags ) & ADAPTIVE ) != 0;
+		bool geometry = topology || live.numPoints != next.numPoints
+			|| ( next.numPoints && memcmp( warp.mPoints.data(), points, next.numPoints * sizeof( glm::vec2 ) ) != 0 )
+			|| memcmp( live.corners, next.corners, sizeof( live.corners ) ) != 0 || ( ( live.flags ^ next.flags ) & LINEAR ) != 0;
+		bool area = memcmp( live.contentArea, next.contentArea, sizeof( live.contentArea ) ) != 0;
+		bool parameters = area || live.brightness != next.brightness || live.contrast != next.contrast || live.saturation != next.saturation
+			|| live.exponent != next.exponent || memcmp( live.edges, next.edges, sizeof( live.edges ) ) != 0
+			|| memcmp( live.gamma, next.gamma, sizeof( live.gamma ) ) != 0 || memcmp( live.luminance, next.luminance, sizeof( live.luminance ) ) != 0
+			|| memcmp( live.colorMatrix, next.colorMatrix, sizeof( live.colorMatrix ) ) != 0;
+
+		if( !geometry && !parameters ) {
+			changes.numUnchanged++;
+			continue;
+		}
+
+		applyBlock( warp, next, points );
+		if( area )
+			warp.setContentArea( getContentArea( next ) );
+
+		// only a changed resolution makes the mesh rebuild its indices, see WarpBilinear::createMesh
+		if( geometry ) {
+			warp.mIsDirty = true;
+			if( warp.mType == Warp::PERSPECTIVE_BILINEAR )
+				( (WarpPerspectiveBilinear&)warp ).mIsScreenDirty = true;
+		}
+		if( parameters )
+			warp.mIsUniformsDirty = true;
+
+		if( topology ) changes.numTopology++;
+		else if( geometry ) changes.numGeometry++;
+		else changes.numParameters++;
+	}
+
+	// warps that are no longer in the settings
+	if( warps.size() > snapshot.blocks.size() ) {
+		changes.numRemoved = warps.size() - snapshot.blocks.size();
+		warps.resize( snapshot.blocks.size() );
+	}
+
+	return changes;
+}
@@ -0,0 +1,182 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "Warp.h"
+
+//! Compact binary settings file, an alternative to the xml written by Warp::writeSettings. The file starts with a
+//! versioned header, followed by a fixed size parameter block per warp and the control points of each warp as raw,
+//! 16-byte aligned float arrays. Files are memory mapped, so the point arrays can be used in place without parsing.
+//! Conversion to and from xml is lossless. All values are stored little endian.
+class WarpSettings {
+	public:
+		//! file header
+		typedef struct Header {
+			char		magic[4];
+			uint32_t	version;
+			uint32_t	numWarps;
+			//! size of a parameter block, newer versions may append fields
+			uint32_t	blockSize;
+			uint64_t	fileSize;
+			uint64_t	reserved;
+		} Header;
+
+		//! parameters of a single warp, the same values as the xml settings
+		typedef struct Block {
+			uint32_t	type;
+			int32_t		controlsX;
+			int32_t		controlsY;
+			uint32_t	numPoints;
+			float		brightness;
+			float		contrast;
+			float		saturation;
+			float		exponent;
+			float		edges[4];
+			float		gamma[4];
+			float		luminance[4];
+			//! corners of a perspective-bilinear warp
+			float		corners[8];
+			//! mesh resolution of a bilinear warp
+			int32_t		resolution;
+			uint32_t	flags;
+			//! offset of the control points from the start of the file, numPoints x (x, y) floats
+			uint64_t	pointsOffset;
+			//! color matrix, column-major. Added in version 2, version 1 files read as the identity
+			float		colorMatrix[9];
+			uint32_t	reserved;
+			//! content area (x, y, width, height), all zero if the warp displays all content. Added in version 3
+			float		contentArea[4];
+		} Block;
+
+		//! copy of the settings of a list of warps, independent of the warps themselves
+		typedef struct Snapshot {
+			std::vector<Block>		blocks;
+			//! the control points of all warps, Block::pointsOffset is the index of the first point of a warp
+			std::vector<glm::vec2>	points;
+		} Snapshot;
+
+		//! what WarpSettings::apply changed, per warp
+		typedef struct Changes {
+			size_t	numAdded;
+			size_t	numRemoved;
+			//! warps that changed their type are replaced
+			size_t	numReplaced;
+			//! the grid size or mesh resolution changed, the mesh is rebuilt
+			size_t	numTopology;
+			//! control points, corners or the interpolation changed, the mesh vertices are updated
+			size_t	numGeometry;
+			//! only shader parameters changed
+			size_t	numParameters;
+			size_t	numUnchanged;
+
+			Changes() : numAdded(0), numRemoved(0), numReplaced(0), numTopology(0), numGeometry(0), numParameters(0), numUnchanged(0) {}
+
+			//! returns true if no warp was changed
+			bool empty() const { return numAdded + numRemoved + numReplaced + numTopology + numGeometry + numParameters == 0; }
+		} Changes;
+
+		//! bits of Block::flags
+		typedef enum { LINEAR = 1 << 0, ADAPTIVE = 1 << 1 } Flag;
+
+		static const uint32_t	VERSION = 3;
+		//! alignment of the point arrays
+		static const size_t		ALIGNMENT = 16;
+
+	public:
+		WarpSettings();
+		virtual ~WarpSettings(void);
+
+		//! memory maps a binary settings file and validates it, returns false if it can not be used
+		bool					open(const std::string &path);
+		//! unmaps the file
+		void					close();
+		//! returns true if a file is mapped
+		bool					isOpen() const { return mData != nullptr; }
+
+		//! returns the number of warps in the mapped file
+		size_t					getNumWarps() const { return mHeader ? mHeader->numWarps : 0; }
+		//! returns the parameters of a warp in the mapped file
+		const Block&			getBlock(size_t index) const;
+		//! returns the control points of a warp, pointing into the mapped file
+		const glm::vec2*		getPoints(size_t index) const;
+		//! creates the warps stored in the mapped file
+		WarpList				getWarps() const;
+
+		//! writes warps to a binary settings file, returns false on failure
+		static bool				write(const WarpList &warps, const std::string &path);
+		//! reads the warps from a binary settings file
+		static WarpList			read(const std::string &path);
+		//! returns true if the file is a binary settings file
+		static bool				isBinary(const std::string &path);
+
+		//! copies the settings of the warps, reusing the memory of the snapshot
+		static void				takeSnapshot(const WarpList &warps, Snapshot &snapshot);
+		//! serializes a snapshot as a binary settings file
+		static void				write(const Snapshot &snapshot, std::string &buffer);
+		//! serializes a snapshot as a settings xml document
+		static void				writeXml(const Snapshot &snapshot, WarpXmlWriter &writer);
+		//! writes a <profile> element with the warps of a snapshot
+		static void				writeXml(const std::string &profile, const Snapshot &snapshot, WarpXmlWriter &writer);
+		//! writes the attributes and children of the <warp> element of a single warp
+		static void				writeXml(const Block &block, const glm::vec2 *points, WarpXmlWriter &writer);
+
+		//! fills a parameter block with the settings of a warp
+		static void				toBlock(const Warp &warp, Block &block);
+
+		//! updates live warps to match a snapshot, touching only what differs. Warps are matched by their position.
+		//! Unchanged warps keep their meshes, frame buffers and shaders, warps with an invalid control point grid in the snapshot are left as they are.
+		static Changes			apply(const Snapshot &snapshot, WarpList &warps);
+
+		//! converts an xml settings file to a binary one
+		static bool				convertFromXml(const std::string &xmlPath, const std::string &binaryPath);
+		//! converts a binary settings file to an xml one
+		static bool				convertToXml(const std::string &binaryPath, const std::string &xmlPath);
+
+	protected:
+		//! returns the size of a parameter block written by a version of the file format
+		static size_t			getBlockSize(uint32_t version);
+		//! copies a parameter block written by an older version, fields it lacks get their defaults
+		static Block			upgradeBlock(const uint8_t *data, uint32_t version, size_t size);
+		//! returns the content area of a parameter block, empty if the warp displays all content
+		static ofRectangle		getContentArea(const Block &block);
+		//! returns true if the control points of a parameter block form a grid of at least 2 x 2
+		static bool				isValidGrid(const Block &block);
+		//! creates a warp from a parameter block and its points
+		static WarpRef			fromBlock(const Block &block, const glm::vec2 *points);
+		//! copies the settings of a parameter block to a warp of the same type, without marking anything dirty
+		static void				applyBlock(Warp &warp, const Block &block, const glm::vec2 *points);
+
+	private:
+		WarpSettings(const WarpSettings&);
+		WarpSettings& operator=(const WarpSettings&);
+
+	protected:
+		const uint8_t			*mData;
+		size_t					mSize;
+		const Header			*mHeader;
+		//! parameter blocks of a file written by an older version, converted to the current layout
+		std::vector<Block>		mBlocks;
+
+		//! platform handles of the mapping
+		void					*mFile;
+		void					*mMapping;
+};
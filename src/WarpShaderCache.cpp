@@ -0,0 +1,151 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarpShaderCache.h"
+
+int WarpShaderCache::sNumSharedCompiles = 0;
+
+WarpShaderCache::WarpShaderCache()
+	: mNumCompiles( 0 )
+{
+}
+
+WarpShaderCache::~WarpShaderCache()
+{
+}
+
+void WarpShaderCache::setSource( const std::string &vertex, const std::string &fragment )
+{
+	mVertex = vertex;
+	mFragment = fragment;
+
+	// variants compiled from the previous source are no longer valid
+	for( auto &variant : mVariants )
+		variant.second.shader.reset();
+}
+
+shared_ptr<ofShader> WarpShaderCache::get( unsigned features )
+{
+	Variant &variant = mVariants[features];
+	if( variant.shader )
+		return variant.shader;
+
+	std::string header = getHeader( features );
+	std::string vertex = header + mVertex;
+	std::string fragment = header + mFragment;
+
+	// reuse the program if another warp has already linked the same source
+	auto &programs = getSharedPrograms();
+	std::weak_ptr<ofShader> &shared = programs[vertex + fragment];
+
+	variant.shader = shared.lock();
+	if( variant.shader )
+		return variant.shader;
+
+	variant.shader = make_shared<ofShader>();
+	variant.compiles++;
+	mNumCompiles++;
+	sNumSharedCompiles++;
+
+	try {
+		variant.shader->setupShaderFromSource( GL_VERTEX_SHADER, vertex );
+		variant.shader->setupShaderFromSource( GL_FRAGMENT_SHADER, fragment );
+		variant.shader->bindDefaults();
+		variant.shader->linkProgram();
+	}
+	catch( const std::exception &e ) {
+		cout << e.what() << std::endl;
+	}
+
+	shared = variant.shader;
+
+	// forget programs that are no longer used by any warp
+	for( auto itr = programs.begin(); itr != programs.end(); ) {
+		if( itr->second.expired() )
+			itr = programs.erase( itr );
+		else
+			++itr;
+	}
+
+	return variant.shader;
+}
+
+std::vector<unsigned> WarpShaderCache::getVariants() const
+{
+	std::vector<unsigned> variants;
+	for( const auto &variant : mVariants ) {
+		if( variant.second.shader )
+			variants.push_back( variant.first );
+	}
+
+	return variants;
+}
+
+int WarpShaderCache::getNumCompiles( unsigned features ) const
+{
+	auto itr = mVariants.find( features );
+	if( itr == mVariants.end() )
+		return 0;
+
+	return itr->second.compiles;
+}
+
+std::string WarpShaderCache::getHeader( unsigned features )
+{
+	std::string header = "#version 150\n";
+
+	if( features & COLOR_LUT )
+		header += "#define USE_COLOR_LUT\n";
+	if( features & BLEND_MASK )
+		header += "#define USE_BLEND_MASK\n";
+	if( features & EDIT_GRID )
+		header += "#define USE_EDIT_GRID\n";
+	if( features & ( YUV_NV12 | YUV_I420 ) )
+		header += "#define USE_YUV\n";
+	if( features & YUV_I420 )
+		header += "#define USE_YUV_I420\n";
+
+	// select the sampler type for the texture target
+	if( features & TEXTURE_2D )
+		header += "#define TEXTURE_2D\n#define SAMPLER sampler2D\n";
+	else
+		header += "#define SAMPLER sampler2DRect\n";
+
+	return header;
+}
+
+size_t WarpShaderCache::getNumSharedPrograms()
+{
+	size_t count = 0;
+	for( const auto &program : getSharedPrograms() ) {
+		if( !program.second.expired() )
+			count++;
+	}
+
+	return count;
+}
+
+std::map<std::string, std::weak_ptr<ofShader>>& WarpShaderCache::getSharedPrograms()
+{
+	static std::map<std::string, std::weak_ptr<ofShader>> programs;
+	return programs;
+}
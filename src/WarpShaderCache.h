@@ -0,0 +1,95 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "ofMain.h"
+#include <map>
+
+//! Compiles specialized variants of a warp shader on demand. Each variant is identified by a bitmask of
+//! features, which are passed to the shader as #defines, so a warp only pays for the features it uses.
+//! Linked programs are shared by all caches in the process: warps of the same type reuse a single program
+//! for each variant, which is released when the last warp using it is destroyed.
+class WarpShaderCache {
+	public:
+		//! features that can be compiled into a variant
+		typedef enum {
+			//! color correction, compiled into a 3D lut (USE_COLOR_LUT)
+			COLOR_LUT = 1 << 0,
+			//! edge blending or a blend texture (USE_BLEND_MASK)
+			BLEND_MASK = 1 << 1,
+			//! wireframe grid shown in edit mode (USE_EDIT_GRID)
+			EDIT_GRID = 1 << 2,
+			//! content is a GL_TEXTURE_2D instead of a GL_TEXTURE_RECTANGLE_ARB (TEXTURE_2D)
+			TEXTURE_2D = 1 << 3,
+			//! content is an NV12 frame, converted from YUV in the shader (USE_YUV)
+			YUV_NV12 = 1 << 4,
+			//! content is an I420 frame, converted from YUV in the shader (USE_YUV, USE_YUV_I420)
+			YUV_I420 = 1 << 5,
+			//! number of feature bits
+			NUM_FEATURES = 6
+		} Feature;
+
+	public:
+		WarpShaderCache();
+		virtual ~WarpShaderCache(void);
+
+		//! set the vertex and fragment source shared by all variants, without a #version directive. Clears all compiled variants.
+		void						setSource(const std::string &vertex, const std::string &fragment);
+		//! returns whether the shader source has been set
+		bool						hasSource() const { return !mFragment.empty(); }
+
+		//! returns the variant with the specified features, from the shared programs or compiled if necessary
+		shared_ptr<ofShader>		get(unsigned features);
+
+		//! returns the feature masks of all variants in use
+		std::vector<unsigned>		getVariants() const;
+		//! returns the number of times this cache has compiled the variant with the specified features
+		int							getNumCompiles(unsigned features) const;
+		//! returns the total number of variants this cache has compiled, variants found in the shared programs are not counted
+		int							getNumCompiles() const { return mNumCompiles; }
+
+		//! returns the #version directive and #defines for the specified features
+		static std::string			getHeader(unsigned features);
+
+		//! returns the number of linked programs currently shared by all caches
+		static size_t				getNumSharedPrograms();
+		//! returns the total number of programs compiled by all caches
+		static int					getNumSharedCompiles() { return sNumSharedCompiles; }
+
+	protected:
+		typedef struct Variant {
+			shared_ptr<ofShader>	shader;
+			int						compiles;
+
+			Variant() : compiles(0) {}
+		} Variant;
+
+		std::string					mVertex;
+		std::string					mFragment;
+
+		std::map<unsigned, Variant>	mVariants;
+		int							mNumCompiles;
+
+		//! returns the shared programs, keyed by their complete vertex and fragment source
+		static std::map<std::string, std::weak_ptr<ofShader>>&	getSharedPrograms();
+		static int					sNumSharedCompiles;
+};
@@ -0,0 +1,199 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarpSoftwareRenderer.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+WarpSoftwareRenderer::WarpSoftwareRenderer()
+	: mNumLutBuilds( 0 )
+{
+}
+
+WarpSoftwareRenderer::~WarpSoftwareRenderer()
+{
+}
+
+void WarpSoftwareRenderer::render( Warp &warp, const ofPixels &src, ofPixels &dst, unsigned numThreads )
+{
+	if( !src.isAllocated() || src.getNumChannels() < 3 ) {
+		cout << "WarpSoftwareRenderer: the content must be 8-bit RGB or RGBA pixels" << endl;
+		return;
+	}
+
+	// without an allocated output, the table is baked at the output size of the warp
+	mRemap.bake( warp, dst.isAllocated() ? (int)dst.getWidth() : 0, dst.isAllocated() ? (int)dst.getHeight() : 0, true, numThreads );
+
+	int width = mRemap.getWidth();
+	int height = mRemap.getHeight();
+	if( width <= 0 || height <= 0 ) return;
+
+	if( !dst.isAllocated() || dst.getNumChannels() != 4 )
+		dst.allocate( width, height, 4 );
+
+	bool useLut = updateLut( warp );
+
+	Job job;
+	job.src = &src;
+	job.dst = &dst;
+	job.coordinates = mRemap.getCoordinates().getData();
+	job.weights = mRemap.getWeights().getData();
+	job.lut = useLut ? &mLut[0] : nullptr;
+	job.lutSize = mLutSettings.size;
+
+	// tiles are independent, shade them in the same tiles the table was rasterized in
+	WarpRemap::forEachTile( width, height, numThreads, [&]( int left, int top, int right, int bottom ) {
+		renderTile( job, left, top, right, bottom );
+	} );
+}
+
+bool WarpSoftwareRenderer::updateLut( const Warp &warp )
+{
+	WarpColorLut::Settings settings;
+	settings.brightness = warp.getBrightness();
+	settings.contrast = warp.getContrast();
+	settings.saturation = warp.getSaturation();
+	settings.matrix = warp.getColorMatrix();
+
+	// neutral parameters leave the content untouched, skip the lookup altogether
+	if( settings == WarpColorLut::Settings() )
+		return false;
+
+	if( mLut.empty() || settings != mLutSettings ) {
+		mLutSettings = settings;
+		mLut.resize( size_t( settings.size ) * settings.size * settings.size * 4 );
+		WarpColorLut::build( &mLut[0], settings );
+		mNumLutBuilds++;
+	}
+
+	return true;
+}
+
+void WarpSoftwareRenderer::renderTile( const Job &job, int left, int top, int right, int bottom )
+{
+	const int srcWidth = (int)job.src->getWidth();
+	const int srcHeight = (int)job.src->getHeight();
+	const int srcChannels = (int)job.src->getNumChannels();
+	const size_t srcStride = size_t( srcWidth ) * srcChannels;
+	const unsigned char *srcData = job.src->getData();
+
+	const float maxX = float( srcWidth - 1 );
+	const float maxY = float( srcHeight - 1 );
+	const int width = (int)job.dst->getWidth();
+
+	// without a lut, the weights can be applied before the sample is rounded to 8 bits
+	const bool blendInSample = ( job.lut == nullptr );
+
+	for( int y = top; y < bottom; ++y ) {
+		unsigned char *row = job.dst->getData() + ( size_t( y ) * width + left ) * 4;
+		const float *coord = job.coordinates + ( size_t( y ) * width + left ) * 2;
+		const float *weight = job.weights + ( size_t( y ) * width + left ) * 3;
+		unsigned char *out = row;
+
+		// bilinear sample of the content, clamped to the edge like the content texture
+		for( int x = left; x < right; ++x, coord += 2, weight += 3, out += 4 ) {
+			if( coord[0] < 0.0f ) {
+				out[0] = out[1] = out[2] = out[3] = 0;
+				continue;
+			}
+
+			float sx = std::min( std::max( coord[0] * srcWidth - 0.5f, 0.0f ), maxX );
+			float sy = std::min( std::max( coord[1] * srcHeight - 0.5f, 0.0f ), maxY );
+			int x0 = (int)sx;
+			int y0 = (int)sy;
+			int x1 = std::min( x0 + 1, srcWidth - 1 );
+			int y1 = std::min( y0 + 1, srcHeight - 1 );
+			float fx = sx - x0;
+			float fy = sy - y0;
+
+			const unsigned char *p00 = srcData + y0 * srcStride + x0 * srcChannels;
+			const unsigned char *p10 = srcData + y0 * srcStride + x1 * srcChannels;
+			const unsigned char *p01 = srcData + y1 * srcStride + x0 * srcChannels;
+			const unsigned char *p11 = srcData + y1 * srcStride + x1 * srcChannels;
+
+#if defined(__SSE2__)
+			if( srcChannels == 4 ) {
+				// all four channels at once
+				const __m128i zero = _mm_setzero_si128();
+				int32_t v00, v10, v01, v11;
+				memcpy( &v00, p00, 4 );
+				memcpy( &v10, p10, 4 );
+				memcpy( &v01, p01, 4 );
+				memcpy( &v11, p11, 4 );
+
+				__m128 c00 = _mm_cvtepi32_ps( _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( v00 ), zero ), zero ) );
+				__m128 c10 = _mm_cvtepi32_ps( _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( v10 ), zero ), zero ) );
+				__m128 c01 = _mm_cvtepi32_ps( _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( v01 ), zero ), zero ) );
+				__m128 c11 = _mm_cvtepi32_ps( _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( v11 ), zero ), zero ) );
+
+				__m128 vx = _mm_set1_ps( fx );
+				__m128 upper = _mm_add_ps( c00, _mm_mul_ps( vx, _mm_sub_ps( c10, c00 ) ) );
+				__m128 lower = _mm_add_ps( c01, _mm_mul_ps( vx, _mm_sub_ps( c11, c01 ) ) );
+				__m128 c = _mm_add_ps( upper, _mm_mul_ps( _mm_set1_ps( fy ), _mm_sub_ps( lower, upper ) ) );
+
+				if( blendInSample )
+					c = _mm_mul_ps( c, _mm_setr_ps( weight[0], weight[1], weight[2], 1.0f ) );
+
+				// round and pack to 8 bits, the values are already within [0, 255]
+				__m128i i = _mm_cvttps_epi32( _mm_add_ps( c, _mm_set1_ps( 0.5f ) ) );
+				i = _mm_packs_epi32( i, i );
+				i = _mm_packus_epi16( i, i );
+				int32_t packed = _mm_cvtsi128_si32( i );
+				memcpy( out, &packed, 4 );
+				continue;
+			}
+#endif
+
+			for( int c = 0; c < 4; ++c ) {
+				float c00 = ( c < srcChannels ) ? p00[c] : 255.0f;
+				float c10 = ( c < srcChannels ) ? p10[c] : 255.0f;
+				float c01 = ( c < srcChannels ) ? p01[c] : 255.0f;
+				float c11 = ( c < srcChannels ) ? p11[c] : 255.0f;
+
+				float upper = c00 + fx * ( c10 - c00 );
+				float lower = c01 + fx * ( c11 - c01 );
+				float value = upper + fy * ( lower - upper );
+				if( blendInSample && c < 3 )
+					value *= weight[c];
+
+				out[c] = (unsigned char)( value + 0.5f );
+			}
+		}
+
+		if( blendInSample )
+			continue;
+
+		// color pipeline, in place
+		WarpColorLut::apply( job.lut, job.lutSize, row, row, right - left, 4 );
+
+		// edge blending, the weights already include luminance and gamma
+		weight = job.weights + ( size_t( y ) * width + left ) * 3;
+		out = row;
+		for( int x = left; x < right; ++x, weight += 3, out += 4 ) {
+			out[0] = (unsigned char)( out[0] * weight[0] + 0.5f );
+			out[1] = (unsigned char)( out[1] * weight[1] + 0.5f );
+			out[2] = (unsigned char)( out[2] * weight[2] + 0.5f );
+		}
+	}
+}
@@ -0,0 +1,68 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "WarpRemap.h"
+
+//! Renders a warp on the CPU, for machines without a GPU: previews on a render farm or regression checks of
+//! warp settings. The warp mesh is rasterized into a remap table (only when the mesh or the blend parameters
+//! change), then the output is shaded in tiles spread over threads: a bilinear sample of the content, the
+//! color pipeline of the warp as a 3D lut and the edge blending weights, like the warp shaders.
+class WarpSoftwareRenderer {
+	public:
+		WarpSoftwareRenderer();
+		virtual ~WarpSoftwareRenderer(void);
+
+		//! renders the warp with the content pixels (8-bit RGB or RGBA, covering the whole content of the warp) into dst.
+		//! The output is RGBA at the size of dst, or the output size of the warp if dst is not allocated. Pixels outside the warp are transparent.
+		//! Tiles are spread over the specified number of threads (0 = hardware concurrency).
+		void				render(Warp &warp, const ofPixels &src, ofPixels &dst, unsigned numThreads = 0);
+
+		//! returns the remap table of the last rendered warp
+		const WarpRemap&	getRemap() const { return mRemap; }
+		//! returns the number of times the color lut has been rebuilt
+		int					getNumLutBuilds() const { return mNumLutBuilds; }
+
+	protected:
+		//! everything the shader needs, shared by all threads
+		typedef struct Job {
+			const ofPixels		*src;
+			ofPixels			*dst;
+			const float			*coordinates;
+			const float			*weights;
+			const float			*lut;
+			int					lutSize;
+		} Job;
+
+		//! shades the tile [left, right) x [top, bottom) of the output
+		static void			renderTile(const Job &job, int left, int top, int right, int bottom);
+
+		//! rebuilds the color lut if the color parameters of the warp have changed, returns false if they are neutral
+		bool				updateLut(const Warp &warp);
+
+	protected:
+		WarpRemap					mRemap;
+
+		WarpColorLut::Settings		mLutSettings;
+		std::vector<float>			mLut;
+		int							mNumLutBuilds;
+};
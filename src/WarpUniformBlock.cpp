@@ -0,0 +1,109 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarpUniformBlock.h"
+
+WarpUniformBlock::WarpUniformBlock( const std::string &name )
+	: mName( name )
+	, mDirtyBegin( 0 )
+	, mDirtyEnd( 0 )
+	, mBufferSize( 0 )
+	, mNumUploads( 0 )
+{
+}
+
+WarpUniformBlock::~WarpUniformBlock()
+{
+}
+
+void WarpUniformBlock::set( int slot, const glm::vec4 &value )
+{
+	if( size_t( slot ) >= mData.size() )
+		mData.resize( slot + 1, glm::vec4( 0.0f ) );
+	else if( mData[slot] == value )
+		return;
+
+	mData[slot] = value;
+	markDirty( slot, slot + 1 );
+}
+
+void WarpUniformBlock::set( int slot, const glm::mat4 &value )
+{
+	for( int i = 0; i < 4; ++i )
+		set( slot + i, value[i] );
+}
+
+void WarpUniformBlock::setSampler( const std::string &name, int unit )
+{
+	mSamplers.push_back( std::make_pair( name, unit ) );
+	mPrograms.clear();
+}
+
+void WarpUniformBlock::bind( const ofShader &shader )
+{
+	if( mData.empty() ) return;
+
+	// (re)allocate the buffer if the block has grown, which uploads all data at once
+	size_t size = mData.size() * sizeof( glm::vec4 );
+	if( size != mBufferSize ) {
+		mBuffer.allocate();
+		mBuffer.setData( size, &mData[0], GL_DYNAMIC_DRAW );
+		mBufferSize = size;
+		mDirtyBegin = mDirtyEnd = 0;
+		mNumUploads++;
+	}
+	else if( isDirty() ) {
+		mBuffer.updateData( mDirtyBegin * sizeof( glm::vec4 ), ( mDirtyEnd - mDirtyBegin ) * sizeof( glm::vec4 ), &mData[mDirtyBegin] );
+		mDirtyBegin = mDirtyEnd = 0;
+		mNumUploads++;
+	}
+
+	// connect the block and samplers only once for every program
+	GLuint program = shader.getProgram();
+	if( mPrograms.insert( program ).second ) {
+		shader.bindUniformBlock( BINDING, mName );
+		for( size_t i = 0; i < mSamplers.size(); ++i ) {
+			shader.setUniform1i( mSamplers[i].first, mSamplers[i].second );
+			mNumUploads++;
+		}
+	}
+
+	mBuffer.bindBase( GL_UNIFORM_BUFFER, BINDING );
+}
+
+void WarpUniformBlock::unbind()
+{
+	if( mBufferSize )
+		mBuffer.unbindBase( GL_UNIFORM_BUFFER, BINDING );
+}
+
+void WarpUniformBlock::markDirty( size_t begin, size_t end )
+{
+	if( mDirtyBegin < mDirtyEnd ) {
+		mDirtyBegin = std::min( mDirtyBegin, begin );
+		mDirtyEnd = std::max( mDirtyEnd, end );
+	}
+	else {
+		mDirtyBegin = begin;
+		mDirtyEnd = end;
+	}
+}
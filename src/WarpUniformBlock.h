@@ -0,0 +1,75 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "ofMain.h"
+#include <set>
+
+//! CPU-side copy of a std140 uniform block, backed by a uniform buffer object. Values are compared when set,
+//! and only the range that changed is uploaded, in a single buffer update. Sampler units are assigned once
+//! per shader program, so drawing a warp with unchanged parameters doesn't upload any uniforms.
+class WarpUniformBlock {
+	public:
+		WarpUniformBlock(const std::string &name = "WarpUniforms");
+		virtual ~WarpUniformBlock(void);
+
+		//! set a vec4 slot of the block
+		void				set(int slot, const glm::vec4 &value);
+		//! set four consecutive vec4 slots of the block to the columns of a matrix
+		void				set(int slot, const glm::mat4 &value);
+		//! assign a sampler uniform to a texture unit, in every program the block is bound to
+		void				setSampler(const std::string &name, int unit);
+
+		//! uploads the changed range, if any, and binds the buffer to the block of the shader. The shader must be active.
+		void				bind(const ofShader &shader);
+		//! unbinds the buffer
+		void				unbind();
+
+		//! returns whether values have changed since the last upload
+		bool				isDirty() const { return mDirtyBegin < mDirtyEnd; }
+		//! returns the number of buffer updates and sampler assignments since the last reset
+		int					getNumUploads() const { return mNumUploads; }
+		//! resets the upload counter, e.g. at the start of every frame
+		void				resetNumUploads() { mNumUploads = 0; }
+
+		//! binding point warp uniform blocks are bound to
+		static const GLuint	BINDING = 1;
+
+	protected:
+		//! marks slots [begin, end) for upload
+		void				markDirty(size_t begin, size_t end);
+
+	protected:
+		std::string			mName;
+
+		std::vector<glm::vec4>	mData;
+		size_t				mDirtyBegin;
+		size_t				mDirtyEnd;
+
+		ofBufferObject		mBuffer;
+		size_t				mBufferSize;
+
+		std::vector<std::pair<std::string, int>>	mSamplers;
+		std::set<GLuint>	mPrograms;
+
+		int					mNumUploads;
+};
@@ -0,0 +1,124 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarpWatcher.h"
+
+#include <filesystem>
+
+WarpWatcher::WarpWatcher()
+	: mInterval( 500 )
+	, mIsStopping( false )
+	, mHasPending( false )
+	, mNumReloads( 0 )
+{
+}
+
+WarpWatcher::~WarpWatcher()
+{
+	stop();
+}
+
+void WarpWatcher::setup( const std::string &path, uint64_t interval )
+{
+	stop();
+
+	mPath = path;
+	mFile = ofToDataPath( path );
+	mInterval = interval;
+	mIsStopping = false;
+	mHasPending = false;
+
+	mThread = std::thread( &WarpWatcher::run, this );
+}
+
+void WarpWatcher::stop()
+{
+	if( !mThread.joinable() ) return;
+
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mIsStopping = true;
+	}
+	mCondition.notify_all();
+	mThread.join();
+}
+
+WarpSettings::Changes WarpWatcher::update( WarpList &warps )
+{
+	WarpSettings::Snapshot snapshot;
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( !mHasPending ) return WarpSettings::Changes();
+
+		std::swap( snapshot, mPending );
+		mHasPending = false;
+	}
+
+	return WarpSettings::apply( snapshot, warps );
+}
+
+void WarpWatcher::run()
+{
+	// the settings that are already loaded don't count as a change
+	uint64_t loaded = getSignature();
+
+	std::unique_lock<std::mutex> lock( mMutex );
+	while( !mIsStopping ) {
+		mCondition.wait_for( lock, std::chrono::milliseconds( mInterval ) );
+		if( mIsStopping ) break;
+
+		uint64_t signature = getSignature();
+		if( signature == 0 || signature == loaded ) continue;
+
+		// parse without holding the lock, so update() never waits for it
+		lock.unlock();
+
+		WarpSettings::Snapshot snapshot;
+		WarpList warps = Warp::readSettings( mPath );
+		WarpSettings::takeSnapshot( warps, snapshot );
+
+		lock.lock();
+
+		// a file that is still being written may not parse yet, try again on the next check
+		if( warps.empty() ) continue;
+
+		loaded = signature;
+		std::swap( mPending, snapshot );
+		mHasPending = true;
+		mNumReloads++;
+	}
+}
+
+uint64_t WarpWatcher::getSignature() const
+{
+	std::error_code error;
+	std::filesystem::path file( mFile );
+
+	auto time = std::filesystem::last_write_time( file, error );
+	if( error ) return 0;
+
+	uintmax_t size = std::filesystem::file_size( file, error );
+	if( error ) return 0;
+
+	// a file that is rewritten within the timer resolution usually differs in size
+	return uint64_t( time.time_since_epoch().count() ) * 31 + size + 1;
+}
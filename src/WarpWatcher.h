@@ -0,0 +1,78 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "WarpSettings.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+//! Watches a settings file (xml or binary) for changes made by other tools and applies them to live warps.
+//! A background thread polls the modification time and parses a changed file into a snapshot, so the render
+//! thread only has to apply the differences in update(). Warps that did not change keep their meshes, frame
+//! buffers and shaders; see WarpSettings::apply.
+class WarpWatcher {
+	public:
+		WarpWatcher();
+		virtual ~WarpWatcher(void);
+
+		//! starts watching a file, checking it every interval milliseconds
+		void					setup(const std::string &path, uint64_t interval = 500);
+		//! stops watching
+		void					stop();
+		//! returns true while a file is being watched
+		bool					isWatching() const { return mThread.joinable(); }
+
+		//! applies the last reloaded settings to the warps, call this from the thread that draws them.
+		//! Returns what was changed, which is empty if the file has not changed.
+		WarpSettings::Changes	update(WarpList &warps);
+
+		//! returns the number of times the file was reloaded
+		uint64_t				getNumReloads() const { return mNumReloads; }
+
+	protected:
+		void					run();
+		//! returns a value that changes whenever the file is modified, or 0 if it does not exist
+		uint64_t				getSignature() const;
+
+	private:
+		WarpWatcher(const WarpWatcher&);
+		WarpWatcher& operator=(const WarpWatcher&);
+
+	protected:
+		std::string				mPath;
+		std::string				mFile;
+		uint64_t				mInterval;
+
+		std::mutex				mMutex;
+		std::condition_variable	mCondition;
+		std::thread				mThread;
+		bool					mIsStopping;
+
+		//! the most recently reloaded settings, waiting to be applied
+		WarpSettings::Snapshot	mPending;
+		bool					mHasPending;
+
+		std::atomic<uint64_t>	mNumReloads;
+};
@@ -0,0 +1,507 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarpXml.h"
+#include "ofMain.h"
+
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+
+// floating point from_chars and to_chars are missing from some standard libraries (libstdc++ before 11, older
+// libc++), those fall back to strtof and snprintf in the C locale, so the decimal separator is always a point
+#if !defined(__cpp_lib_to_chars)
+#include <cerrno>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#if defined(__APPLE__)
+#include <xlocale.h>
+#endif
+
+static float strtofC( const char *text, char **end )
+{
+#if defined(_WIN32)
+	static _locale_t locale = _create_locale( LC_NUMERIC, "C" );
+	return _strtof_l( text, end, locale );
+#else
+	static locale_t locale = newlocale( LC_NUMERIC_MASK, "C", (locale_t)0 );
+	locale_t previous = uselocale( locale );
+	float value = strtof( text, end );
+	uselocale( previous );
+	return value;
+#endif
+}
+
+static int formatC( char *buffer, size_t size, int precision, float value )
+{
+#if defined(_WIN32)
+	static _locale_t locale = _create_locale( LC_NUMERIC, "C" );
+	return _snprintf_l( buffer, size, "%.*g", locale, precision, value );
+#else
+	static locale_t locale = newlocale( LC_NUMERIC_MASK, "C", (locale_t)0 );
+	locale_t previous = uselocale( locale );
+	int length = snprintf( buffer, size, "%.*g", precision, value );
+	uselocale( previous );
+	return length;
+#endif
+}
+#endif
+
+static bool isSpace( char c )
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+//! compares ascii text case-insensitively
+static bool equalsNoCase( std::string_view text, const char *other )
+{
+	size_t length = strlen( other );
+	if( text.size() != length ) return false;
+
+	for( size_t i = 0; i < length; ++i ) {
+		if( tolower( (unsigned char)text[i] ) != other[i] ) return false;
+	}
+	return true;
+}
+
+static std::string_view trim( std::string_view text )
+{
+	while( !text.empty() && isSpace( text.front() ) ) text.remove_prefix( 1 );
+	while( !text.empty() && isSpace( text.back() ) ) text.remove_suffix( 1 );
+	if( !text.empty() && text.front() == '+' ) text.remove_prefix( 1 );
+	return text;
+}
+
+//! returns the first occurrence of a string in [p, end), or nullptr
+static const char* search( const char *p, const char *end, const char *text )
+{
+	size_t length = strlen( text );
+	for( ; p + length <= end; ++p ) {
+		if( memcmp( p, text, length ) == 0 ) return p;
+	}
+	return nullptr;
+}
+
+//! scans an element or attribute name
+static std::string_view scanName( const char *&p, const char *end )
+{
+	const char *begin = p;
+	while( p < end && !isSpace( *p ) && *p != '/' && *p != '>' && *p != '=' && *p != '<' ) ++p;
+	return std::string_view( begin, p - begin );
+}
+
+static void skipSpace( const char *&p, const char *end )
+{
+	while( p < end && isSpace( *p ) ) ++p;
+}
+
+std::string_view WarpXmlReader::Attributes::get( std::string_view name ) const
+{
+	const std::string_view *value = find( name );
+	return value ? *value : std::string_view();
+}
+
+const std::string_view* WarpXmlReader::Attributes::find( std::string_view name ) const
+{
+	for( auto &attribute : mValues ) {
+		if( attribute.first == name ) return &attribute.second;
+	}
+	return nullptr;
+}
+
+float WarpXmlReader::Attributes::getFloat( std::string_view name, float fallback ) const
+{
+	float value;
+	return toFloat( get( name ), value ) ? value : fallback;
+}
+
+int WarpXmlReader::Attributes::getInt( std::string_view name, int fallback ) const
+{
+	int value;
+	return toInt( get( name ), value ) ? value : fallback;
+}
+
+bool WarpXmlReader::Attributes::getBool( std::string_view name, bool fallback ) const
+{
+	std::string_view text = trim( get( name ) );
+	if( equalsNoCase( text, "true" ) ) return true;
+	if( equalsNoCase( text, "false" ) ) return false;
+
+	int value;
+	return toInt( text, value ) ? value != 0 : fallback;
+}
+
+bool WarpXmlReader::parse( const char *data, size_t size, Handler &handler )
+{
+	mBegin = data;
+	mStack.clear();
+	mError.clear();
+
+	const char *p = data;
+	const char *end = data + size;
+	bool hasRoot = false;
+
+	while( p < end ) {
+		// skip text up to the next tag
+		const char *tag = (const char*)memchr( p, '<', end - p );
+		if( !tag ) break;
+
+		p = tag + 1;
+		if( p >= end ) return fail( "unexpected end of file", tag );
+
+		// skip declarations, processing instructions, comments, cdata and doctype
+		if( *p == '?' ) {
+			const char *close = search( p, end, "?>" );
+			if( !close ) return fail( "unterminated processing instruction", tag );
+			p = close + 2;
+			continue;
+		}
+		if( *p == '!' ) {
+			const char *close;
+			if( end - p >= 3 && memcmp( p, "!--", 3 ) == 0 ) {
+				close = search( p + 3, end, "-->" );
+				p = close ? close + 3 : nullptr;
+			}
+			else if( end - p >= 8 && memcmp( p, "![CDATA[", 8 ) == 0 ) {
+				close = search( p + 8, end, "]]>" );
+				p = close ? close + 3 : nullptr;
+			}
+			else {
+				close = (const char*)memchr( p, '>', end - p );
+				p = close ? close + 1 : nullptr;
+			}
+
+			if( !p ) return fail( "unterminated markup declaration", tag );
+			continue;
+		}
+
+		// end tag
+		if( *p == '/' ) {
+			++p;
+			std::string_view name = scanName( p, end );
+			skipSpace( p, end );
+			if( p >= end || *p != '>' ) return fail( "malformed end tag", tag );
+			++p;
+
+			if( mStack.empty() || mStack.back() != name ) return fail( "mismatched end tag", tag );
+			mStack.pop_back();
+
+			handler.endElement( name, (int)mStack.size() );
+			continue;
+		}
+
+		// start tag
+		std::string_view name = scanName( p, end );
+		if( name.empty() ) return fail( "missing element name", tag );
+		if( mStack.empty() && hasRoot ) return fail( "more than one root element", tag );
+
+		mAttributes.mValues.clear();
+		mAttributes.mNumDecoded = 0;
+
+		bool isEmpty = false;
+		for( ;; ) {
+			skipSpace( p, end );
+			if( p >= end ) return fail( "unexpected end of file", tag );
+
+			if( *p == '>' ) {
+				++p;
+				break;
+			}
+			if( *p == '/' ) {
+				if( p + 1 >= end || p[1] != '>' ) return fail( "malformed empty element", tag );
+				p += 2;
+				isEmpty = true;
+				break;
+			}
+
+			std::string_view attribute = scanName( p, end );
+			if( attribute.empty() ) return fail( "missing attribute name", p );
+
+			skipSpace( p, end );
+			if( p >= end || *p != '=' ) return fail( "missing attribute value", p );
+			++p;
+			skipSpace( p, end );
+
+			char quote = ( p < end ) ? *p : 0;
+			if( quote != '"' && quote != '\'' ) return fail( "unquoted attribute value", p );
+			++p;
+
+			const char *close = (const char*)memchr( p, quote, end - p );
+			if( !close ) return fail( "unterminated attribute value", p );
+
+			std::string_view value( p, close - p );
+			p = close + 1;
+
+			// only values with character references are copied
+			if( value.find( '&' ) != std::string_view::npos ) {
+				if( mAttributes.mNumDecoded == mAttributes.mDecoded.size() )
+					mAttributes.mDecoded.emplace_back();
+
+				std::string &decoded = mAttributes.mDecoded[mAttributes.mNumDecoded++];
+				decode( value, decoded );
+				value = decoded;
+			}
+
+			mAttributes.mValues.emplace_back( attribute, value );
+		}
+
+		hasRoot = true;
+
+		int depth = (int)mStack.size();
+		handler.startElement( name, mAttributes, depth );
+
+		if( isEmpty )
+			handler.endElement( name, depth );
+		else
+			mStack.push_back( name );
+	}
+
+	if( !mStack.empty() ) return fail( "unclosed element", end );
+	if( !hasRoot ) return fail( "no root element", end );
+
+	return true;
+}
+
+bool WarpXmlReader::load( const std::string &path, Handler &handler )
+{
+	std::ifstream file( ofToDataPath( path ).c_str(), std::ios::binary | std::ios::ate );
+	if( !file ) {
+		mError = "could not open " + path;
+		return false;
+	}
+
+	// read the whole file at once, names and values point into it while parsing
+	std::string buffer( (size_t)file.tellg(), '\0' );
+	file.seekg( 0 );
+	file.read( &buffer[0], buffer.size() );
+
+	return parse( buffer.data(), buffer.size(), handler );
+}
+
+bool WarpXmlReader::toFloat( std::string_view text, float &value )
+{
+	text = trim( text );
+#if defined(__cpp_lib_to_chars)
+	return !text.empty() && std::from_chars( text.data(), text.data() + text.size(), value ).ec == std::errc();
+#else
+	// strtof needs a terminated string
+	char buffer[64];
+	if( text.empty() || text.size() >= sizeof( buffer ) ) return false;
+	memcpy( buffer, text.data(), text.size() );
+	buffer[text.size()] = 0;
+
+	char *end;
+	errno = 0;
+	float result = strtofC( buffer, &end );
+	// like from_chars, a number followed by other text is accepted
+	if( end == buffer || errno == ERANGE ) return false;
+
+	value = result;
+	return true;
+#endif
+}
+
+bool WarpXmlReader::toInt( std::string_view text, int &value )
+{
+	text = trim( text );
+	return !text.empty() && std::from_chars( text.data(), text.data() + text.size(), value ).ec == std::errc();
+}
+
+bool WarpXmlReader::fail( const char *message, const char *position )
+{
+	mError = std::string( message ) + " at offset " + std::to_string( position - mBegin );
+	return false;
+}
+
+void WarpXmlReader::decode( std::string_view value, std::string &result )
+{
+	result.clear();
+
+	size_t i = 0;
+	while( i < value.size() ) {
+		size_t semicolon = ( value[i] == '&' ) ? value.find( ';', i ) : std::string_view::npos;
+		if( semicolon == std::string_view::npos ) {
+			result += value[i++];
+			continue;
+		}
+
+		std::string_view entity = value.substr( i + 1, semicolon - i - 1 );
+		uint32_t code = 0;
+
+		if( entity == "lt" ) code = '<';
+		else if( entity == "gt" ) code = '>';
+		else if( entity == "amp" ) code = '&';
+		else if( entity == "quot" ) code = '"';
+		else if( entity == "apos" ) code = '\'';
+		else if( entity.size() > 1 && entity[0] == '#' ) {
+			bool isHex = entity[1] == 'x' || entity[1] == 'X';
+			const char *first = entity.data() + ( isHex ? 2 : 1 );
+			const char *last = entity.data() + entity.size();
+			if( std::from_chars( first, last, code, isHex ? 16 : 10 ).ptr != last )
+				code = 0;
+		}
+
+		// keep unknown references as they are
+		if( code == 0 || code > 0x10FFFF ) {
+			result += value[i++];
+			continue;
+		}
+
+		// encode as utf-8
+		if( code < 0x80 ) {
+			result += char( code );
+		}
+		else if( code < 0x800 ) {
+			result += char( 0xC0 | ( code >> 6 ) );
+			result += char( 0x80 | ( code & 0x3F ) );
+		}
+		else if( code < 0x10000 ) {
+			result += char( 0xE0 | ( code >> 12 ) );
+			result += char( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+			result += char( 0x80 | ( code & 0x3F ) );
+		}
+		else {
+			result += char( 0xF0 | ( code >> 18 ) );
+			result += char( 0x80 | ( ( code >> 12 ) & 0x3F ) );
+			result += char( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+			result += char( 0x80 | ( code & 0x3F ) );
+		}
+
+		i = semicolon + 1;
+	}
+}
+
+WarpXmlWriter::WarpXmlWriter()
+	: mBuffer( "<?xml version=\"1.0\"?>" )
+	, mIsTagOpen( false )
+{
+}
+
+void WarpXmlWriter::begin( const char *name )
+{
+	closeTag();
+	indent();
+
+	mBuffer += '<';
+	mBuffer += name;
+
+	mStack.push_back( name );
+	mIsTagOpen = true;
+}
+
+void WarpXmlWriter::end()
+{
+	if( mStack.empty() ) return;
+
+	const char *name = mStack.back();
+	mStack.pop_back();
+
+	// elements without children are written as empty elements
+	if( mIsTagOpen ) {
+		mBuffer += "/>";
+		mIsTagOpen = false;
+		return;
+	}
+
+	indent();
+	mBuffer += "</";
+	mBuffer += name;
+	mBuffer += '>';
+}
+
+void WarpXmlWriter::attribute( const char *name, const char *value )
+{
+	if( !mIsTagOpen ) return;
+
+	mBuffer += ' ';
+	mBuffer += name;
+	mBuffer += "=\"";
+
+	for( const char *c = value; *c; ++c ) {
+		switch( *c ) {
+			case '&': mBuffer += "&amp;"; break;
+			case '<': mBuffer += "&lt;"; break;
+			case '>': mBuffer += "&gt;"; break;
+			case '"': mBuffer += "&quot;"; break;
+			default: mBuffer += *c; break;
+		}
+	}
+
+	mBuffer += '"';
+}
+
+void WarpXmlWriter::attribute( const char *name, float value )
+{
+	char buffer[32];
+	buffer[format( value, buffer, sizeof( buffer ) - 1 )] = 0;
+	attribute( name, buffer );
+}
+
+void WarpXmlWriter::attribute( const char *name, int value )
+{
+	char buffer[16];
+	*std::to_chars( buffer, buffer + sizeof( buffer ) - 1, value ).ptr = 0;
+	attribute( name, buffer );
+}
+
+bool WarpXmlWriter::save( const std::string &path ) const
+{
+	std::ofstream file( ofToDataPath( path ).c_str(), std::ios::binary | std::ios::trunc );
+	if( !file ) return false;
+
+	file.write( mBuffer.data(), mBuffer.size() );
+	file.put( '\n' );
+
+	return file.good();
+}
+
+size_t WarpXmlWriter::format( float value, char *buffer, size_t size )
+{
+#if defined(__cpp_lib_to_chars)
+	std::to_chars_result result = std::to_chars( buffer, buffer + size, value );
+	return ( result.ec == std::errc() ) ? size_t( result.ptr - buffer ) : 0;
+#else
+	// the fewest digits that read back as the same float, 9 significant digits always do
+	for( int precision = 6; precision <= 9; ++precision ) {
+		int length = formatC( buffer, size, precision, value );
+		if( length < 0 || size_t( length ) >= size ) return 0;
+		if( precision == 9 || strtofC( buffer, nullptr ) == value ) return size_t( length );
+	}
+	return 0;
+#endif
+}
+
+void WarpXmlWriter::closeTag()
+{
+	if( mIsTagOpen ) {
+		mBuffer += '>';
+		mIsTagOpen = false;
+	}
+}
+
+void WarpXmlWriter::indent()
+{
+	mBuffer += '\n';
+	mBuffer.append( mStack.size(), '\t' );
+}
@@ -0,0 +1,143 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <deque>
+#include <utility>
+#include <vector>
+
+//! Single-pass (SAX-style) reader for the settings xml. The whole file is scanned once and every element is reported
+//! to a handler as it is encountered, without building a document tree. Names and attribute values point into the
+//! source buffer, so parsing only allocates when a value contains character references. Numbers are converted with
+//! std::from_chars. Text, comments, processing instructions and doctype declarations are skipped.
+class WarpXmlReader {
+	public:
+		//! attributes of the current element, only valid during the handler call
+		class Attributes {
+			public:
+				Attributes() : mNumDecoded(0) {}
+
+				//! returns the number of attributes
+				size_t				size() const { return mValues.size(); }
+				//! returns true if the attribute exists
+				bool				has(std::string_view name) const { return find( name ) != nullptr; }
+				//! returns the value of an attribute, or an empty string if it does not exist
+				std::string_view	get(std::string_view name) const;
+
+				//! returns the value of an attribute as a float, or the fallback if it does not exist or is not a number
+				float				getFloat(std::string_view name, float fallback = 0.0f) const;
+				//! returns the value of an attribute as an integer, or the fallback if it does not exist or is not a number
+				int					getInt(std::string_view name, int fallback = 0) const;
+				//! returns the value of an attribute as a boolean ("true", "false" or a number)
+				bool				getBool(std::string_view name, bool fallback = false) const;
+
+			protected:
+				const std::string_view*	find(std::string_view name) const;
+
+				//! (name, value) pairs, pointing into the source or into mDecoded
+				std::vector<std::pair<std::string_view, std::string_view>>	mValues;
+				//! storage for values containing character references, reused between elements
+				std::deque<std::string>		mDecoded;
+				size_t						mNumDecoded;
+
+				friend class WarpXmlReader;
+		};
+
+		//! receives the elements in document order
+		class Handler {
+			public:
+				virtual ~Handler() {}
+
+				//! called for each start tag (and empty element), depth is 0 for the root element
+				virtual void		startElement(std::string_view name, const Attributes &attributes, int depth) = 0;
+				//! called for each end tag (and after each empty element)
+				virtual void		endElement(std::string_view /*name*/, int /*depth*/) {}
+		};
+
+	public:
+		//! parses a buffer, returns false if it is not well-formed
+		bool				parse(const char *data, size_t size, Handler &handler);
+		//! reads a file into memory and parses it
+		bool				load(const std::string &path, Handler &handler);
+
+		//! returns a description of the last error
+		const std::string&	getError() const { return mError; }
+
+		//! parses a float, ignoring surrounding whitespace and a leading plus sign
+		static bool			toFloat(std::string_view text, float &value);
+		//! parses an integer, ignoring surrounding whitespace and a leading plus sign
+		static bool			toInt(std::string_view text, int &value);
+
+	protected:
+		//! returns false and stores the error
+		bool				fail(const char *message, const char *position);
+
+		//! replaces the predefined entities and numeric character references of a value
+		static void			decode(std::string_view value, std::string &result);
+
+	protected:
+		const char			*mBegin;
+		Attributes			mAttributes;
+		std::vector<std::string_view>	mStack;
+		std::string			mError;
+};
+
+//! Single-pass writer for the settings xml. Elements are appended to a string as they are written, so a document is
+//! never built in memory. Floats are written with std::to_chars, which produces the shortest text that reads back
+//! as the same value.
+class WarpXmlWriter {
+	public:
+		WarpXmlWriter();
+
+		//! starts an element, attributes can be added until the first child or the end of the element
+		void				begin(const char *name);
+		//! ends the last element that was started
+		void				end();
+
+		void				attribute(const char *name, const char *value);
+		void				attribute(const char *name, const std::string &value) { attribute( name, value.c_str() ); }
+		void				attribute(const char *name, float value);
+		void				attribute(const char *name, int value);
+		//! booleans are written as 1 or 0, like ofToString
+		void				attribute(const char *name, bool value) { attribute( name, value ? "1" : "0" ); }
+
+		//! returns the document written so far
+		const std::string&	getString() const { return mBuffer; }
+		//! writes the document to a file, returns false on failure
+		bool				save(const std::string &path) const;
+
+		//! formats a float with the shortest representation that reads back as the same value, returns the length
+		static size_t		format(float value, char *buffer, size_t size);
+
+	protected:
+		//! closes the start tag of the current element before a child is added
+		void				closeTag();
+		void				indent();
+
+	protected:
+		std::string			mBuffer;
+		std::vector<const char*>	mStack;
+		//! set while attributes can be added to the current element
+		bool				mIsTagOpen;
+};
@@ -0,0 +1,88 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarpYuv.h"
+
+const std::string& WarpYuv::getShaderSource()
+{
+	static const std::string source = R"END(
+#ifdef USE_YUV
+        uniform SAMPLER		uTexU;
+#ifdef USE_YUV_I420
+        uniform SAMPLER		uTexV;
+#endif
+
+        // samples the planes and converts to RGB (BT.709, video range), like WarpYuv::toRgb()
+        vec4 sampleYuv( SAMPLER luma, vec2 coord )
+        {
+#ifdef TEXTURE_2D
+            vec2 chroma = coord;
+#else
+            vec2 chroma = coord * 0.5;
+#endif
+            float y = texture( luma, coord ).r;
+#ifdef USE_YUV_I420
+            vec2 uv = vec2( texture( uTexU, chroma ).r, texture( uTexV, chroma ).r );
+#else
+            vec2 uv = texture( uTexU, chroma ).rg;
+#endif
+            vec3 yuv = vec3( y - 16.0 / 255.0, uv - 128.0 / 255.0 );
+            vec3 rgb = mat3( 1.164, 1.164, 1.164, 0.0, -0.213, 2.112, 1.793, -0.533, 0.0 ) * yuv;
+            return vec4( clamp( rgb, 0.0, 1.0 ), 1.0 );
+        }
+#endif
+    )END";
+
+	return source;
+}
+
+void WarpYuv::bind( const Textures &frame )
+{
+	frame.u->bind( UNIT_U );
+	if( frame.format == I420 )
+		frame.v->bind( UNIT_V );
+}
+
+void WarpYuv::unbind( const Textures &frame )
+{
+	if( frame.format == I420 )
+		frame.v->unbind( UNIT_V );
+	frame.u->unbind( UNIT_U );
+}
+
+void WarpYuv::toRgba( const Planes &planes, ofPixels &dst )
+{
+	dst.allocate( planes.width, planes.height, 4 );
+
+	for( int y = 0; y < planes.height; ++y ) {
+		const unsigned char *luma = planes.data[0] + size_t( y ) * planes.stride[0];
+		const unsigned char *u = planes.data[1] + size_t( y / 2 ) * planes.stride[1];
+		const unsigned char *v = ( planes.format == I420 ) ? planes.data[2] + size_t( y / 2 ) * planes.stride[2] : u + 1;
+		const int step = ( planes.format == I420 ) ? 1 : 2;
+
+		unsigned char *out = dst.getData() + size_t( y ) * planes.width * 4;
+		for( int x = 0; x < planes.width; ++x, out += 4 ) {
+			toRgb( luma[x], u[( x / 2 ) * step], v[( x / 2 ) * step], out );
+			out[3] = 255;
+		}
+	}
+}
@@ -0,0 +1,90 @@
+/*
+ Original work Copyright (c) 2010-2015, Paul Houx - All rights reserved.
+ Modified work Copyright (c) 2015-2016, Charles Veasey - All rights reserved.
+ 
+ This code is intended for use with the openFrameworks C++ library: http://openframeworks.cc/
+ 
+ This file is part of ofxWarpBlend.
+ 
+ ofxWarpBlend is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ ofxWarpBlend is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with ofxWarpBlend.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "ofMain.h"
+
+//! Video frames in planar YUV, as delivered by hardware decoders: a luma plane at full resolution and chroma planes
+//! at half the width and height, either interleaved (NV12) or separate (I420). The warps sample the planes directly
+//! and convert to RGB in their shader (BT.709, video range), so no separate conversion pass is needed.
+class WarpYuv {
+	public:
+		typedef enum {
+			//! luma plane and an interleaved UV plane
+			NV12,
+			//! luma plane and separate U and V planes
+			I420
+		} Format;
+
+		//! planes of a frame on the GPU. Luma is a single channel texture (GL_R8), chroma is a two channel texture (GL_RG8) in u for NV12,
+		//! or two single channel textures in u and v for I420. All planes must use the same texture target.
+		typedef struct Textures {
+			Format				format;
+			const ofTexture		*y;
+			const ofTexture		*u;
+			const ofTexture		*v;
+
+			Textures() : format(NV12), y(nullptr), u(nullptr), v(nullptr) {}
+			Textures(Format format, const ofTexture &y, const ofTexture &u, const ofTexture *v = nullptr) : format(format), y(&y), u(&u), v(v) {}
+
+			//! returns true if all planes of the format are allocated
+			bool isAllocated() const { return y && y->isAllocated() && u && u->isAllocated() && ( format == NV12 || ( v && v->isAllocated() ) ); }
+		} Textures;
+
+		//! planes of a frame in memory, rows can be padded to a stride in bytes. NV12 uses data[0] and data[1], I420 all three.
+		typedef struct Planes {
+			Format					format;
+			int						width;
+			int						height;
+			const unsigned char		*data[3];
+			int						stride[3];
+
+			Planes() : format(NV12), width(0), height(0) { data[0] = data[1] = data[2] = nullptr; stride[0] = stride[1] = stride[2] = 0; }
+		} Planes;
+
+		//! binds the chroma planes to their texture units, the luma plane is bound like any content texture
+		static void			bind(const Textures &frame);
+		//! unbinds the chroma planes
+		static void			unbind(const Textures &frame);
+
+		//! returns the sampling function used by the warp shaders, vec4 sampleYuv(SAMPLER luma, vec2 coord), enabled by USE_YUV
+		static const std::string&	getShaderSource();
+
+		//! converts a single sample to 8-bit RGB in fixed point, like the shader
+		static inline void	toRgb(int y, int u, int v, unsigned char *rgb)
+		{
+			int c = 298 * ( y - 16 ) + 128;
+			int d = u - 128;
+			int e = v - 128;
+
+			rgb[0] = (unsigned char)std::min( std::max( ( c + 459 * e ) >> 8, 0 ), 255 );
+			rgb[1] = (unsigned char)std::min( std::max( ( c - 55 * d - 136 * e ) >> 8, 0 ), 255 );
+			rgb[2] = (unsigned char)std::min( std::max( ( c + 541 * d ) >> 8, 0 ), 255 );
+		}
+
+		//! converts a whole frame to RGBA pixels with nearest chroma, as a reference for the warps sampling the planes directly
+		static void			toRgba(const Planes &planes, ofPixels &dst);
+
+		//! texture units of the chroma planes in the warp shaders
+		static const int	UNIT_U = 3;
+		static const int	UNIT_V = 4;
+};
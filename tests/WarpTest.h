@@ -0,0 +1,43 @@
+// Shared by the test-* projects: every project is a command-line tool that runs its checks on the CPU (test-gl
+// renders through a hidden window), prints each failed check and returns the number of failures from main(), so
+// it can run as part of a build.
+
+#pragma once
+#include "ofMain.h"
+#include "Warp.h"
+
+//! returns the number of failed checks so far
+inline int& getNumFailures()
+{
+	static int numFailures = 0;
+	return numFailures;
+}
+
+//! prints the message if the condition does not hold
+inline void check( bool condition, const string &message )
+{
+	if( !condition ) {
+		cout << "FAILED: " << message << endl;
+		getNumFailures()++;
+	}
+}
+
+//! reports the result, returns the value for main()
+inline int finish()
+{
+	if( getNumFailures() == 0 )
+		cout << "all checks passed" << endl;
+
+	return getNumFailures();
+}
+
+//! a warp of the given content size, displayed in a window of the given size without an application window
+template<typename T>
+class TestWarp : public T {
+	public:
+		TestWarp( int width, int height, int windowWidth, int windowHeight )
+		{
+			T::setSize( width, height );
+			T::mWindowSize = glm::vec2( windowWidth, windowHeight );
+		}
+};
@@ -0,0 +1,145 @@
+// Checks the skyline packer of WarpAtlas: rectangles that fit, rectangles that overflow a page, padding between
+// regions and against the page edges, and packing again after the sizes have changed.
+//
+// usage: test-atlas
+
+#include "ofMain.h"
+#include "WarpAtlas.h"
+#include "../../WarpTest.h"
+
+//! checks that every placed region has its size, lies within its page with the padding around it,
+//! and does not overlap the padded region of any other rectangle on the same page
+static void checkLayout( const string &name, const vector<ofRectangle> &sizes, const vector<WarpAtlas::Region> &regions, int pageWidth, int pageHeight, int padding )
+{
+	check( regions.size() == sizes.size(), name + ": one region per rectangle" );
+	if( regions.size() != sizes.size() ) return;
+
+	for( size_t i = 0; i < regions.size(); ++i ) {
+		const WarpAtlas::Region &a = regions[i];
+		if( a.page < 0 ) continue;
+
+		string label = name + ": region " + ofToString( i );
+		check( a.rect.width == sizes[i].width && a.rect.height == sizes[i].height, label + " keeps its size" );
+		check( a.rect.x >= padding && a.rect.y >= padding, label + " is padded against the top left of the page" );
+		check( a.rect.getRight() + padding <= pageWidth && a.rect.getBottom() + padding <= pageHeight, label + " is padded against the bottom right of the page" );
+
+		for( size_t j = i + 1; j < regions.size(); ++j ) {
+			const WarpAtlas::Region &b = regions[j];
+			if( b.page != a.page ) continue;
+
+			// padded regions may touch, but not overlap
+			bool separate = a.rect.getRight() + 2 * padding <= b.rect.x || b.rect.getRight() + 2 * padding <= a.rect.x
+				|| a.rect.getBottom() + 2 * padding <= b.rect.y || b.rect.getBottom() + 2 * padding <= a.rect.y;
+			check( separate, label + " does not overlap region " + ofToString( j ) );
+		}
+	}
+}
+
+static int countPages( const vector<WarpAtlas::Region> &regions )
+{
+	int pages = 0;
+	for( size_t i = 0; i < regions.size(); ++i )
+		pages = std::max( pages, regions[i].page + 1 );
+
+	return pages;
+}
+
+static void testFit()
+{
+	// four quadrants fill a page exactly
+	vector<ofRectangle> sizes( 4, ofRectangle( 0, 0, 512, 512 ) );
+	vector<WarpAtlas::Region> regions = WarpAtlas::pack( sizes, 1024, 1024 );
+	checkLayout( "fit", sizes, regions, 1024, 1024, 0 );
+	check( countPages( regions ) == 1, "fit: four quadrants share one page" );
+	for( size_t i = 0; i < regions.size(); ++i )
+		check( regions[i].page == 0, "fit: quadrant " + ofToString( i ) + " is placed" );
+
+	// mixed sizes, the tallest first
+	sizes = { ofRectangle( 0, 0, 300, 100 ), ofRectangle( 0, 0, 200, 400 ), ofRectangle( 0, 0, 500, 250 ), ofRectangle( 0, 0, 120, 120 ) };
+	regions = WarpAtlas::pack( sizes, 1024, 1024 );
+	checkLayout( "mixed", sizes, regions, 1024, 1024, 0 );
+	check( countPages( regions ) == 1, "mixed: all rectangles share one page" );
+	check( regions[1].rect.x == 0 && regions[1].rect.y == 0, "mixed: the tallest rectangle is placed first" );
+}
+
+static void testOverflow()
+{
+	// a rectangle larger than a page is not placed, the others are
+	vector<ofRectangle> sizes = { ofRectangle( 0, 0, 100, 100 ), ofRectangle( 0, 0, 2048, 100 ), ofRectangle( 0, 0, 100, 2048 ) };
+	vector<WarpAtlas::Region> regions = WarpAtlas::pack( sizes, 1024, 1024 );
+	checkLayout( "oversized", sizes, regions, 1024, 1024, 0 );
+	check( regions[0].page == 0, "oversized: the small rectangle is placed" );
+	check( regions[1].page == -1 && regions[2].page == -1, "oversized: rectangles larger than a page are not placed" );
+
+	// rectangles that do not fit on one page start a new one
+	sizes.assign( 5, ofRectangle( 0, 0, 600, 600 ) );
+	regions = WarpAtlas::pack( sizes, 1024, 1024 );
+	checkLayout( "pages", sizes, regions, 1024, 1024, 0 );
+	check( countPages( regions ) == 5, "pages: every rectangle gets a page of its own" );
+
+	sizes.assign( 9, ofRectangle( 0, 0, 512, 512 ) );
+	regions = WarpAtlas::pack( sizes, 1024, 1024 );
+	checkLayout( "quadrants", sizes, regions, 1024, 1024, 0 );
+	check( countPages( regions ) == 3, "quadrants: nine quadrants fill three pages" );
+
+	// a rectangle that only fits without padding
+	sizes = { ofRectangle( 0, 0, 1024, 1024 ) };
+	check( WarpAtlas::pack( sizes, 1024, 1024, 0 )[0].page == 0, "exact: a rectangle of the page size fits without padding" );
+	check( WarpAtlas::pack( sizes, 1024, 1024, 1 )[0].page == -1, "exact: a rectangle of the page size does not fit with padding" );
+}
+
+static void testPadding()
+{
+	const int padding = 2;
+
+	vector<ofRectangle> sizes( 16, ofRectangle( 0, 0, 250, 250 ) );
+	vector<WarpAtlas::Region> regions = WarpAtlas::pack( sizes, 1024, 1024, padding );
+	checkLayout( "padding", sizes, regions, 1024, 1024, padding );
+	check( countPages( regions ) == 1, "padding: sixteen padded rectangles share one page" );
+
+	// fractional sizes are padded from the next whole pixel
+	sizes = { ofRectangle( 0, 0, 99.5f, 50.25f ), ofRectangle( 0, 0, 99.5f, 50.25f ) };
+	regions = WarpAtlas::pack( sizes, 1024, 1024, padding );
+	checkLayout( "fractional", sizes, regions, 1024, 1024, padding );
+	check( regions[1].rect.x - regions[0].rect.getRight() >= 2 * padding || regions[1].rect.y - regions[0].rect.getBottom() >= 2 * padding, "fractional: padding after rounding up" );
+}
+
+static void testRepack()
+{
+	vector<ofRectangle> sizes = { ofRectangle( 0, 0, 640, 480 ), ofRectangle( 0, 0, 640, 480 ), ofRectangle( 0, 0, 1280, 720 ) };
+	vector<WarpAtlas::Region> first = WarpAtlas::pack( sizes, 2048, 2048, 2 );
+	checkLayout( "repack", sizes, first, 2048, 2048, 2 );
+
+	// the same sizes give the same layout
+	vector<WarpAtlas::Region> again = WarpAtlas::pack( sizes, 2048, 2048, 2 );
+	bool same = again.size() == first.size();
+	for( size_t i = 0; same && i < first.size(); ++i )
+		same = again[i].page == first[i].page && again[i].rect == first[i].rect;
+	check( same, "repack: packing is deterministic" );
+
+	// a resized warp moves the others out of its way
+	sizes[0] = ofRectangle( 0, 0, 1920, 1080 );
+	vector<WarpAtlas::Region> resized = WarpAtlas::pack( sizes, 2048, 2048, 2 );
+	checkLayout( "resized", sizes, resized, 2048, 2048, 2 );
+	for( size_t i = 0; i < resized.size(); ++i )
+		check( resized[i].page >= 0, "resized: region " + ofToString( i ) + " is placed" );
+
+	// removing a warp never needs more pages
+	sizes.pop_back();
+	vector<WarpAtlas::Region> removed = WarpAtlas::pack( sizes, 2048, 2048, 2 );
+	checkLayout( "removed", sizes, removed, 2048, 2048, 2 );
+	check( countPages( removed ) <= countPages( resized ), "removed: no more pages than before" );
+
+	// no rectangles, no pages
+	check( WarpAtlas::pack( vector<ofRectangle>(), 2048, 2048, 2 ).empty(), "empty: no regions" );
+}
+
+int main()
+{
+	testFit();
+	testOverflow();
+	testPadding();
+	testRepack();
+
+	return finish();
+}
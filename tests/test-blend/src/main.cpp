@@ -0,0 +1,130 @@
+// Checks WarpBlendMask::bake() against the edge blending formula the warp shader used before the mask was baked,
+// evaluated at every texel center in double precision. Also checks that the result does not depend on the number
+// of threads, that evaluate() agrees with the mask, that a user-supplied mask only gets gamma applied and that a
+// mask is only baked again when its settings change or it is marked dirty.
+//
+// usage: test-blend
+
+#include "ofMain.h"
+#include "WarpBlendMask.h"
+#include "../../WarpTest.h"
+
+//! the fragment shader of WarpBilinear before the blend mask, transcribed from GLSL
+static double shaderBlend( const WarpBlendMask::Settings &settings, double u, double v, int channel )
+{
+	double a = 1.0;
+	if( settings.edges.x > 0.0f ) a *= std::min( std::max( u / settings.edges.x, 0.0 ), 1.0 );
+	if( settings.edges.y > 0.0f ) a *= std::min( std::max( v / settings.edges.y, 0.0 ), 1.0 );
+	if( settings.edges.z > 0.0f ) a *= std::min( std::max( ( 1.0 - u ) / settings.edges.z, 0.0 ), 1.0 );
+	if( settings.edges.w > 0.0f ) a *= std::min( std::max( ( 1.0 - v ) / settings.edges.w, 0.0 ), 1.0 );
+
+	const double luminance = settings.luminance[channel];
+	const double gamma = settings.gamma[channel];
+
+	double blend = ( a < 0.5 ) ? ( luminance * std::pow( 2.0 * a, (double)settings.exponent ) )
+		: 1.0 - ( 1.0 - luminance ) * std::pow( 2.0 * ( 1.0 - a ), (double)settings.exponent );
+
+	return std::pow( blend, 1.0 / gamma );
+}
+
+static void testCurve( const string &name, const WarpBlendMask::Settings &settings )
+{
+	const size_t numValues = size_t( settings.width ) * settings.height * 3;
+	vector<float> mask( numValues ), threaded( numValues );
+	WarpBlendMask::bake( &mask[0], settings, nullptr, 1 );
+	WarpBlendMask::bake( &threaded[0], settings, nullptr, 7 );
+
+	double maxError = 0.0, maxEvaluate = 0.0;
+	for( int y = 0; y < settings.height; ++y ) {
+		for( int x = 0; x < settings.width; ++x ) {
+			// texel centers, where the shader samples the mask without interpolation
+			double u = ( x + 0.5 ) / settings.width;
+			double v = ( y + 0.5 ) / settings.height;
+			glm::vec3 evaluated = WarpBlendMask::evaluate( settings, float( u ), float( v ) );
+
+			for( int c = 0; c < 3; ++c ) {
+				float value = mask[( size_t( y ) * settings.width + x ) * 3 + c];
+				maxError = std::max( maxError, std::abs( value - shaderBlend( settings, u, v, c ) ) );
+				maxEvaluate = std::max( maxEvaluate, (double)std::abs( value - evaluated[c] ) );
+			}
+		}
+	}
+
+	check( maxError < 1e-4, name + ": differs from the shader by " + ofToString( maxError ) );
+	check( maxEvaluate < 1e-4, name + ": differs from evaluate() by " + ofToString( maxEvaluate ) );
+	check( mask == threaded, name + ": result does not depend on the number of threads" );
+
+	cout << name << ": " << settings.width << " x " << settings.height << ", largest difference from the shader " << maxError << endl;
+}
+
+static void testSource()
+{
+	WarpBlendMask::Settings settings;
+	settings.width = 64;
+	settings.height = 32;
+	settings.edges = ofVec4f( 0.25f );
+	settings.gamma = ofVec3f( 1.0f, 2.2f, 0.5f );
+
+	// a gradient mask, the edges of the settings must be ignored
+	vector<float> source( size_t( settings.width ) * settings.height * 3 ), mask( source.size() );
+	for( size_t i = 0; i < source.size(); ++i )
+		source[i] = float( i % 97 ) / 96.0f;
+
+	WarpBlendMask::bake( &mask[0], settings, &source[0], 3 );
+
+	double maxError = 0.0;
+	for( size_t i = 0; i < source.size(); ++i )
+		maxError = std::max( maxError, std::abs( mask[i] - std::pow( (double)source[i], 1.0 / settings.gamma[i % 3] ) ) );
+
+	check( maxError < 1e-5, "source: differs from the gamma corrected mask by " + ofToString( maxError ) );
+}
+
+static void testRebake()
+{
+	WarpBlendMask::Settings settings;
+	settings.width = 64;
+	settings.height = 32;
+	settings.edges = ofVec4f( 0.25f );
+
+	WarpBlendMask mask;
+	check( mask.prepare( settings ) && !mask.prepare( settings ), "rebake: unchanged settings are not baked again" );
+
+	settings.exponent = 3.0f;
+	check( mask.prepare( settings ) && mask.getNumBakes() == 2, "rebake: changed settings are baked" );
+
+	// e.g. a blend texture that was drawn into
+	mask.markDirty();
+	check( mask.prepare( settings ) && mask.getNumBakes() == 3, "rebake: a mask marked dirty is baked again" );
+}
+
+int main()
+{
+	WarpBlendMask::Settings settings;
+	settings.width = 256;
+	settings.height = 128;
+
+	// no edges, the mask is white
+	testCurve( "none", settings );
+
+	// the defaults of a warp with edges on all sides
+	settings.edges = ofVec4f( 0.2f, 0.1f, 0.3f, 0.15f );
+	testCurve( "all edges", settings );
+
+	// a single edge, with per channel luminance and gamma
+	settings.edges = ofVec4f( 0.0f, 0.0f, 0.4f, 0.0f );
+	settings.luminance = ofVec3f( 0.3f, 0.5f, 0.7f );
+	settings.gamma = ofVec3f( 1.8f, 2.2f, 2.4f );
+	testCurve( "right edge", settings );
+
+	// overlapping edges and an odd size
+	settings.width = 333;
+	settings.height = 77;
+	settings.edges = ofVec4f( 0.6f, 0.7f, 0.6f, 0.7f );
+	settings.exponent = 3.5f;
+	testCurve( "overlapping", settings );
+
+	testSource();
+	testRebake();
+
+	return finish();
+}
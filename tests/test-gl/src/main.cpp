@@ -0,0 +1,221 @@
+// Checks the shaders on the GPU: a perspective warp, with and without edge blending, is rendered through its
+// shader into a frame buffer in an OpenGL 3.2 core profile context and compared with WarpSoftwareRenderer, and
+// WarpRenderer draws warps with blend masks and color luts in a single draw call that matches drawing them one by
+// one, for GL_TEXTURE_2D and rectangle textures.
+//
+// usage: test-gl
+//
+// Opens a hidden window for the context. Without a display, run it with a virtual one and Mesa's software
+// rasterizer: LIBGL_ALWAYS_SOFTWARE=1 xvfb-run test-gl
+
+#include "ofMain.h"
+#include "WarpRenderer.h"
+#include "WarpSoftwareRenderer.h"
+#include "../../WarpTest.h"
+
+//! content with gradients and a checkerboard, so a misplaced or flipped texel shows
+static ofPixels createContent( int width, int height )
+{
+	ofPixels pixels;
+	pixels.allocate( width, height, 4 );
+
+	unsigned char *data = pixels.getData();
+	for( int y = 0; y < height; ++y ) {
+		for( int x = 0; x < width; ++x, data += 4 ) {
+			data[0] = (unsigned char)( x * 255 / ( width - 1 ) );
+			data[1] = (unsigned char)( y * 255 / ( height - 1 ) );
+			data[2] = (unsigned char)( ( ( x / 16 + y / 16 ) & 1 ) ? 200 : 40 );
+			data[3] = 255;
+		}
+	}
+
+	return pixels;
+}
+
+//! renders the warp on the GPU and on the CPU, checks that the outputs match
+static void compare( const string &name, WarpPerspective &warp, bool useArb )
+{
+	const int width = warp.getWidth();
+	const int height = warp.getHeight();
+	ofPixels content = createContent( width, height );
+
+	ofTexture texture;
+	texture.allocate( content, useArb );
+
+	ofFbo fbo;
+	fbo.allocate( width, height, GL_RGBA );
+	fbo.begin();
+	ofClear( 0, 0, 0, 0 );
+	static_cast<Warp&>( warp ).draw( texture );
+	fbo.end();
+
+	ofPixels gpu;
+	fbo.readToPixels( gpu );
+
+	ofPixels cpu;
+	WarpSoftwareRenderer renderer;
+	renderer.render( warp, content, cpu );
+
+	check( gpu.getWidth() == cpu.getWidth() && gpu.getHeight() == cpu.getHeight() && gpu.getNumChannels() == 4, name + ": outputs have the same size" );
+	if( gpu.size() != cpu.size() ) return;
+
+	// pixels covered by both are compared, the edges of the quad may be rasterized differently
+	const unsigned char *a = gpu.getData();
+	const unsigned char *b = cpu.getData();
+	size_t numCovered = 0, numDifferent = 0;
+	int maxDifference = 0;
+	for( size_t i = 0; i < gpu.size(); i += 4 ) {
+		if( a[i + 3] != 255 || b[i + 3] != 255 ) {
+			if( a[i + 3] != b[i + 3] ) numDifferent++;
+			continue;
+		}
+
+		int difference = 0;
+		for( int c = 0; c < 3; ++c )
+			difference = std::max( difference, std::abs( int( a[i + c] ) - int( b[i + c] ) ) );
+
+		maxDifference = std::max( maxDifference, difference );
+		if( difference > 3 ) numDifferent++;
+		numCovered++;
+	}
+
+	check( numCovered > gpu.size() / 4 / 2, name + ": covers the warp, " + ofToString( numCovered ) + " pixels" );
+	check( numDifferent * 200 < numCovered, name + ": " + ofToString( numDifferent ) + " pixels differ from WarpSoftwareRenderer, by at most "
+		+ ofToString( maxDifference ) );
+}
+
+static void testPerspective( bool useArb )
+{
+	string name = useArb ? "rectangle" : "2D";
+
+	TestWarp<WarpPerspective> warp( 256, 192, 256, 192 );
+	warp.setControlPoint( 0, glm::vec2( 0.1f, 0.05f ) );
+	warp.setControlPoint( 1, glm::vec2( 0.95f, 0.1f ) );
+	warp.setControlPoint( 2, glm::vec2( 0.85f, 0.9f ) );
+	warp.setControlPoint( 3, glm::vec2( 0.05f, 0.97f ) );
+	warp.setBrightness( 0.8f );
+	compare( name, warp, useArb );
+
+	warp.setEdges( 0.2f, 0.0f, 0.1f, 0.15f );
+	warp.setGamma( 2.2f, 1.8f, 2.4f );
+	warp.setExponent( 2.5f );
+	compare( name + " blended", warp, useArb );
+}
+
+//! renders the warps into a frame buffer, with WarpRenderer or one by one
+static void renderWarps( const WarpList &warps, const ofTexture &texture, WarpRenderer *renderer, ofPixels &output )
+{
+	ofFbo fbo;
+	fbo.allocate( 640, 480, GL_RGBA );
+	fbo.begin();
+	ofClear( 0, 0, 0, 0 );
+	if( renderer )
+		renderer->draw( warps, texture );
+	else
+		for( auto &warp : warps ) warp->draw( texture );
+	fbo.end();
+
+	fbo.readToPixels( output );
+}
+
+static void testBatch( bool useArb )
+{
+	string name = useArb ? "batch rectangle" : "batch 2D";
+
+	// four warps side by side: blended with a color lut, a color matrix only, a blended perspective warp in a
+	// smaller window and a plain warp with smaller content
+	WarpList warps;
+	auto blended = std::make_shared<TestWarp<WarpBilinear>>( 320, 240, 640, 480 );
+	blended->setControlPoint( 0, glm::vec2( 0.02f, 0.52f ) );
+	blended->setControlPoint( 1, glm::vec2( 0.0f, 0.98f ) );
+	blended->setControlPoint( 2, glm::vec2( 0.47f, 0.55f ) );
+	blended->setControlPoint( 3, glm::vec2( 0.45f, 0.95f ) );
+	blended->setEdges( 0.2f, 0.1f, 0.3f, 0.0f );
+	blended->setGamma( 2.2f, 1.8f, 2.4f );
+	blended->setBrightness( 0.8f );
+	blended->setContrast( 1.2f );
+	blended->setSaturation( 0.7f );
+	warps.push_back( blended );
+
+	glm::mat3 matrix( 1.0f );
+	matrix[0] = glm::vec3( 0.9f, 0.05f, 0.0f );
+	matrix[1] = glm::vec3( 0.1f, 0.85f, 0.05f );
+	matrix[2] = glm::vec3( 0.0f, 0.1f, 0.95f );
+	auto colored = std::make_shared<TestWarp<WarpBilinear>>( 320, 240, 640, 480 );
+	colored->setControlPoint( 0, glm::vec2( 0.55f, 0.02f ) );
+	colored->setControlPoint( 1, glm::vec2( 0.52f, 0.45f ) );
+	colored->setControlPoint( 2, glm::vec2( 0.98f, 0.05f ) );
+	colored->setControlPoint( 3, glm::vec2( 0.95f, 0.47f ) );
+	colored->setColorMatrix( matrix );
+	warps.push_back( colored );
+
+	auto perspective = std::make_shared<TestWarp<WarpPerspective>>( 320, 240, 320, 240 );
+	perspective->setControlPoint( 0, glm::vec2( 0.05f, 0.05f ) );
+	perspective->setControlPoint( 1, glm::vec2( 0.9f, 0.1f ) );
+	perspective->setControlPoint( 2, glm::vec2( 0.95f, 0.9f ) );
+	perspective->setControlPoint( 3, glm::vec2( 0.1f, 0.95f ) );
+	perspective->setEdges( 0.0f, 0.0f, 0.25f, 0.25f );
+	perspective->setBrightness( 0.7f );
+	warps.push_back( perspective );
+
+	auto plain = std::make_shared<TestWarp<WarpBilinear>>( 160, 120, 640, 480 );
+	plain->setControlPoint( 0, glm::vec2( 0.55f, 0.55f ) );
+	plain->setControlPoint( 1, glm::vec2( 0.55f, 0.95f ) );
+	plain->setControlPoint( 2, glm::vec2( 0.95f, 0.55f ) );
+	plain->setControlPoint( 3, glm::vec2( 0.95f, 0.95f ) );
+	plain->setEdges( 0.1f, 0.1f, 0.1f, 0.1f );
+	warps.push_back( plain );
+
+	ofPixels content = createContent( 320, 240 );
+	ofTexture texture;
+	texture.allocate( content, useArb );
+
+	ofPixels single, batched;
+	renderWarps( warps, texture, nullptr, single );
+
+	WarpRenderer renderer;
+	renderWarps( warps, texture, &renderer, batched );
+	check( renderer.getNumDrawCalls() == 1, name + ": draws the warps in one call, " + ofToString( renderer.getNumDrawCalls() ) );
+	if( single.size() != batched.size() ) return;
+
+	// the warps do not overlap, the batch does the same fetches so only rounding differs
+	const unsigned char *a = single.getData();
+	const unsigned char *b = batched.getData();
+	size_t numCovered = 0, numDifferent = 0;
+	for( size_t i = 0; i < single.size(); i += 4 ) {
+		if( a[i + 3] != b[i + 3] ) {
+			numDifferent++;
+			continue;
+		}
+		if( a[i + 3] == 0 ) continue;
+
+		for( int c = 0; c < 3; ++c ) {
+			if( std::abs( int( a[i + c] ) - int( b[i + c] ) ) > 1 ) {
+				numDifferent++;
+				break;
+			}
+		}
+		numCovered++;
+	}
+
+	check( numCovered > 100000, name + ": covers the warps, " + ofToString( numCovered ) + " pixels" );
+	check( numDifferent * 1000 < numCovered, name + ": " + ofToString( numDifferent ) + " pixels differ from drawing the warps one by one" );
+}
+
+int main()
+{
+	ofGLFWWindowSettings settings;
+	settings.setGLVersion( 3, 2 );
+	settings.setSize( 256, 192 );
+	settings.visible = false;
+	ofCreateWindow( settings );
+
+	cout << "renderer: " << glGetString( GL_RENDERER ) << ", " << glGetString( GL_VERSION ) << endl;
+
+	testPerspective( false );
+	testPerspective( true );
+	testBatch( false );
+	testBatch( true );
+
+	return finish();
+}
@@ -0,0 +1,166 @@
+// Checks WarpPipeline and its queue: WarpRing keeps the order of its elements across two threads, the pipeline
+// outputs every frame of the stream in order and identical to resampling it with WarpRemap, colors and edge blending
+// match WarpSoftwareRenderer, and stop() ends a stream that never ends by itself.
+//
+// usage: test-pipeline
+
+#include "ofMain.h"
+#include "WarpPipeline.h"
+#include "WarpSoftwareRenderer.h"
+#include "../../WarpTest.h"
+
+//! RGBA content that differs for every frame index
+static void fillContent( ofPixels &pixels, int width, int height, uint64_t index )
+{
+	if( !pixels.isAllocated() || (int)pixels.getWidth() != width || (int)pixels.getHeight() != height )
+		pixels.allocate( width, height, 4 );
+
+	unsigned char *data = pixels.getData();
+	for( int y = 0; y < height; ++y ) {
+		for( int x = 0; x < width; ++x, data += 4 ) {
+			data[0] = (unsigned char)( x * 255 / ( width - 1 ) );
+			data[1] = (unsigned char)( ( ( x / 8 + y / 8 + index ) & 1 ) ? 255 : 0 );
+			data[2] = (unsigned char)( ( x * 7 + y * 13 + index * 31 ) & 255 );
+			data[3] = 255;
+		}
+	}
+}
+
+static void testRing()
+{
+	WarpRing<int> ring( 3 );
+	check( ring.capacity() == 3, "ring: has the requested capacity" );
+	check( ring.push( 1 ) && ring.push( 2 ) && ring.push( 3 ) && !ring.push( 4 ), "ring: accepts up to its capacity" );
+
+	int value = 0;
+	check( ring.pop( value ) && value == 1 && ring.size() == 2 && ring.getMaxSize() == 3, "ring: removes the oldest element" );
+
+	// a producer and a consumer thread, the consumer must see every element once and in order
+	const int count = 200000;
+	WarpRing<int> queue( 16 );
+	std::thread producer( [&]() {
+		for( int i = 0; i < count; ++i )
+			while( !queue.push( i ) ) std::this_thread::yield();
+	} );
+
+	bool inOrder = true;
+	for( int i = 0; i < count; ++i ) {
+		int element = -1;
+		while( !queue.pop( element ) ) std::this_thread::yield();
+		inOrder = inOrder && element == i;
+	}
+	producer.join();
+
+	check( inOrder && queue.size() == 0, "ring: two threads pass every element in order" );
+}
+
+static void testStream()
+{
+	const int width = 320, height = 240;
+	const uint64_t numFrames = 40;
+
+	TestWarp<WarpPerspective> warp( width, height, width, height );
+	warp.setControlPoint( 0, glm::vec2( 0.05f, 0.1f ) );
+	warp.setControlPoint( 2, glm::vec2( 0.9f, 0.95f ) );
+
+	WarpRemap remap;
+	remap.bake( warp );
+
+	uint64_t nextIndex = 0;
+	size_t numDifferent = 0;
+	ofPixels content, expected;
+
+	WarpPipeline pipeline;
+	WarpPipeline::Settings settings;
+	settings.numRemapThreads = 2;
+
+	bool started = pipeline.start( warp,
+		[&]( ofPixels &pixels, uint64_t index ) {
+			if( index >= numFrames ) return false;
+			fillContent( pixels, width, height, index );
+			return true;
+		},
+		[&]( const ofPixels &output, uint64_t index ) {
+			// neutral colors and no edges, so the output is exactly the resampled content
+			check( index == nextIndex, "stream: frame " + ofToString( index ) + " arrives in order" );
+			nextIndex = index + 1;
+
+			fillContent( content, width, height, index );
+			remap.apply( content, expected );
+			if( output.size() != expected.size() || !std::equal( output.getData(), output.getData() + output.size(), expected.getData() ) )
+				numDifferent++;
+		},
+		settings );
+
+	check( started, "stream: starts" );
+	check( !pipeline.start( warp, nullptr, nullptr ), "stream: does not start twice" );
+	pipeline.wait();
+
+	WarpPipeline::Stats stats = pipeline.getStats();
+	check( !pipeline.isRunning(), "stream: stops at the end of the stream" );
+	check( nextIndex == numFrames && stats.numFrames == numFrames, "stream: outputs all frames, " + ofToString( stats.numFrames ) );
+	check( numDifferent == 0, "stream: " + ofToString( numDifferent ) + " frames differ from WarpRemap::apply()" );
+
+	bool bounded = true;
+	for( int i = 0; i < WarpPipeline::NUM_STAGES; ++i )
+		bounded = bounded && stats.maxQueueDepth[i] <= settings.numFrames + 1;
+	check( bounded, "stream: queues never hold more than the frames in flight" );
+}
+
+static void testBlend()
+{
+	const int width = 320, height = 240;
+
+	TestWarp<WarpBilinear> warp( width, height, width, height );
+	warp.setEdges( 0.2f, 0.0f, 0.3f, 0.1f );
+	warp.setBrightness( 0.8f );
+	warp.setSaturation( 0.5f );
+
+	ofPixels content, rendered, output;
+	fillContent( content, width, height, 0 );
+
+	WarpSoftwareRenderer renderer;
+	renderer.render( warp, content, rendered );
+
+	WarpPipeline pipeline;
+	pipeline.start( warp,
+		[&]( ofPixels &pixels, uint64_t index ) { pixels = content; return index == 0; },
+		[&]( const ofPixels &pixels, uint64_t ) { output = pixels; } );
+	pipeline.wait();
+
+	// the pipeline rounds the weights to 8.8 fixed point and the sample to 8 bits before the lut
+	int maxDifference = 0;
+	check( output.size() == rendered.size(), "blend: output has the size of the rendered warp" );
+	for( size_t i = 0; i < output.size() && i < rendered.size(); ++i )
+		maxDifference = std::max( maxDifference, std::abs( int( output.getData()[i] ) - int( rendered.getData()[i] ) ) );
+	check( maxDifference <= 1, "blend: differs from WarpSoftwareRenderer by " + ofToString( maxDifference ) );
+}
+
+static void testStop()
+{
+	// a stream that never ends
+	std::atomic<uint64_t> numDecoded( 0 );
+	TestWarp<WarpBilinear> warp( 64, 48, 64, 48 );
+
+	WarpPipeline pipeline;
+	pipeline.start( warp,
+		[&]( ofPixels &pixels, uint64_t index ) { fillContent( pixels, 64, 48, index ); numDecoded++; return true; },
+		[&]( const ofPixels &, uint64_t ) {} );
+
+	while( numDecoded < 20 )
+		std::this_thread::yield();
+	pipeline.stop();
+
+	check( !pipeline.isRunning(), "stop: ends a running stream" );
+	check( pipeline.getStats().numFrames > 0, "stop: frames were output before the stream was stopped" );
+}
+
+int main()
+{
+	testRing();
+	testStream();
+	testBlend();
+	testStop();
+
+	return finish();
+}
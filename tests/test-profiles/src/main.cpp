@@ -0,0 +1,155 @@
+// Checks settings files with several profiles: WarpProfiles saves and loads every profile and the active one,
+// switches in update() once a profile is prepared and switches back instantly, and Warp::readSettings reads the
+// active profile. Warp::writeSettings and WarpSaver replace that profile and keep the others in the file.
+//
+// usage: test-profiles
+//
+// Writes its files to the data folder and removes them afterwards.
+
+#include "ofMain.h"
+#include "Warp.h"
+#include "WarpProfiles.h"
+#include "WarpSaver.h"
+#include "../../WarpTest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+static std::string readFile( const std::string &path )
+{
+	std::ifstream file( ofToDataPath( path ).c_str(), std::ios::binary );
+	return std::string( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+}
+
+//! returns the xml of a profile in a settings file
+static std::string getProfile( const std::string &xml, const std::string &name )
+{
+	size_t begin = xml.find( "<profile name=\"" + name + "\"" );
+	size_t end = ( begin == std::string::npos ) ? begin : xml.find( "</profile>", begin );
+	return ( end == std::string::npos ) ? "" : xml.substr( begin, end - begin );
+}
+
+static WarpList createDay()
+{
+	WarpList warps;
+	warps.push_back( WarpRef( new WarpBilinear() ) );
+	warps.push_back( WarpRef( new WarpPerspective() ) );
+	return warps;
+}
+
+static WarpList createNight()
+{
+	WarpList warps;
+	WarpBilinearRef bilinear( new WarpBilinear() );
+	bilinear->setNumControlX( 5 );
+	bilinear->setNumControlY( 4 );
+	bilinear->setBrightness( 0.4f );
+	warps.push_back( bilinear );
+	return warps;
+}
+
+static void testProfiles()
+{
+	{
+		WarpProfiles profiles;
+		profiles.add( "day", createDay() );
+		profiles.add( "night", createNight() );
+		check( profiles.getActiveName() == "day" && profiles.getWarps().size() == 2, "profiles: the first profile is active" );
+		check( profiles.save( "test-profiles.xml" ), "profiles: saves the file" );
+	}
+
+	WarpProfiles profiles;
+	profiles.setSize( 640, 480 );
+	check( profiles.load( "test-profiles.xml" ), "profiles: loads the file" );
+	check( profiles.getNumProfiles() == 2 && profiles.getName( 0 ) == "day" && profiles.getName( 1 ) == "night", "profiles: reads every profile" );
+	check( profiles.getActiveName() == "day" && profiles.getWarps().size() == 2, "profiles: the active profile is restored" );
+
+	// the switch happens at the start of a frame, once the profile is prepared
+	check( !profiles.select( "evening" ), "profiles: an unknown profile can not be selected" );
+	check( profiles.select( "night" ) && profiles.getActiveName() == "day", "profiles: selecting does not switch yet" );
+
+	auto end = std::chrono::steady_clock::now() + std::chrono::seconds( 5 );
+	bool switched = false;
+	while( !switched && std::chrono::steady_clock::now() < end ) {
+		switched = profiles.update();
+		if( !switched ) std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+	}
+	check( switched && profiles.getActiveName() == "night" && profiles.getWarps().size() == 1, "profiles: update() switches to the prepared profile" );
+	check( profiles.getWarps()[0]->getBrightness() == 0.4f, "profiles: the warps of the profile are active" );
+
+	check( profiles.select( "day" ) && profiles.isPrepared( "day" ) && profiles.update() && profiles.getActiveName() == "day",
+		"profiles: switching back is instant" );
+
+	check( !profiles.remove( "day" ), "profiles: the active profile can not be removed" );
+	check( profiles.remove( "night" ) && profiles.getNumProfiles() == 1 && profiles.getActiveName() == "day", "profiles: removes an inactive profile" );
+}
+
+static void testReadWrite()
+{
+	// the file names night as the active profile
+	std::vector<WarpProfiles::Profile> profiles( 2 );
+	profiles[0].name = "day";
+	profiles[0].warps = createDay();
+	profiles[1].name = "night";
+	profiles[1].warps = createNight();
+	WarpProfiles::write( "test-profiles.xml", profiles, "night" );
+
+	std::string before = readFile( "test-profiles.xml" );
+	WarpList warps = Warp::readSettings( "test-profiles.xml" );
+	check( warps.size() == 1 && warps[0]->getBrightness() == 0.4f, "read: readSettings reads the active profile" );
+
+	std::vector<WarpProfiles::Profile> read;
+	std::string active;
+	check( WarpProfiles::read( "test-profiles.xml", read, active, true ) && active == "night" && read.size() == 2,
+		"read: activeOnly reads the first and the active profile" );
+
+	// editing and saving the warps replaces the active profile only
+	warps[0]->setBrightness( 0.6f );
+	string path = "test-profiles.xml";
+	Warp::writeSettings( warps, path );
+
+	std::string after = readFile( path );
+	check( !getProfile( before, "day" ).empty() && getProfile( after, "day" ) == getProfile( before, "day" ), "write: writeSettings keeps the other profiles" );
+	check( after.find( "profile=\"night\"" ) != std::string::npos, "write: writeSettings keeps the active profile" );
+	warps = Warp::readSettings( path );
+	check( warps.size() == 1 && warps[0]->getBrightness() == 0.6f, "write: writeSettings replaces the active profile" );
+
+	WarpSaver saver;
+	warps[0]->setBrightness( 0.8f );
+	saver.save( warps, path );
+	saver.flush();
+
+	after = readFile( path );
+	check( getProfile( after, "day" ) == getProfile( before, "day" ), "write: WarpSaver keeps the other profiles" );
+	warps = Warp::readSettings( path );
+	check( warps.size() == 1 && warps[0]->getBrightness() == 0.8f, "write: WarpSaver replaces the active profile" );
+
+	// a named profile that is not in the file is added
+	WarpSettings::Snapshot snapshot;
+	WarpSettings::takeSnapshot( createDay(), snapshot );
+	WarpProfiles::write( path, "evening", snapshot );
+	check( WarpProfiles::read( path, read, active ) && read.size() == 3 && read[2].name == "evening" && active == "night",
+		"write: a new profile is added" );
+
+	// a new file holds a single default profile, a binary file reads as one
+	std::remove( ofToDataPath( path ).c_str() );
+	Warp::writeSettings( createDay(), path );
+	check( WarpProfiles::read( path, read, active ) && read.size() == 1 && read[0].name == "default" && active == "default",
+		"write: a new file holds the default profile" );
+
+	WarpSettings::write( createNight(), "test-profiles.bin" );
+	check( WarpProfiles::read( "test-profiles.bin", read, active ) && read.size() == 1 && active == "default" && read[0].warps.size() == 1,
+		"read: a binary file holds the default profile" );
+}
+
+int main()
+{
+	testProfiles();
+	testReadWrite();
+
+	std::remove( ofToDataPath( "test-profiles.xml" ).c_str() );
+	std::remove( ofToDataPath( "test-profiles.bin" ).c_str() );
+
+	return finish();
+}
@@ -0,0 +1,146 @@
+// Checks reloading settings: WarpSettings::apply() classifies every kind of change and leaves unchanged warps alone,
+// and WarpWatcher picks up a rewritten file, retries a file that is only half written and applies nothing until the
+// file changes.
+//
+// usage: test-reload
+//
+// Writes its files to the data folder and removes them afterwards.
+
+#include "ofMain.h"
+#include "Warp.h"
+#include "WarpSaver.h"
+#include "WarpWatcher.h"
+#include "../../WarpTest.h"
+
+#include <chrono>
+#include <cstdio>
+
+static WarpList createWarps()
+{
+	WarpList warps;
+	warps.push_back( WarpRef( new WarpBilinear() ) );
+	warps.push_back( WarpRef( new WarpPerspective() ) );
+	warps.push_back( WarpRef( new WarpPerspectiveBilinear() ) );
+	return warps;
+}
+
+//! applies the settings of the edited warps to the live warps
+static WarpSettings::Changes applyEdits( const WarpList &edited, WarpList &live )
+{
+	WarpSettings::Snapshot snapshot;
+	WarpSettings::takeSnapshot( edited, snapshot );
+	return WarpSettings::apply( snapshot, live );
+}
+
+static void testApply()
+{
+	WarpList live = createWarps(), edited = createWarps();
+	WarpList original = live;
+
+	WarpSettings::Changes changes = applyEdits( edited, live );
+	check( changes.empty() && changes.numUnchanged == 3, "apply: identical settings change nothing" );
+
+	edited[0]->setBrightness( 0.5f );
+	changes = applyEdits( edited, live );
+	check( changes.numParameters == 1 && changes.numUnchanged == 2 && live[0]->getBrightness() == 0.5f, "apply: colors only change parameters" );
+
+	glm::mat3 matrix( 1.0f );
+	matrix[0] = glm::vec3( 0.9f, 0.1f, 0.0f );
+	edited[0]->setColorMatrix( matrix );
+	changes = applyEdits( edited, live );
+	check( changes.numParameters == 1 && changes.numUnchanged == 2 && live[0]->getColorMatrix() == matrix, "apply: a color matrix only changes parameters" );
+
+	edited[1]->setContentArea( ofRectangle( 0, 0, 320, 240 ) );
+	changes = applyEdits( edited, live );
+	check( changes.numParameters == 1 && changes.numUnchanged == 2 && live[1]->getContentArea() == ofRectangle( 0, 0, 320, 240 ),
+		"apply: a content area only changes parameters" );
+
+	edited[1]->setControlPoint( 2, glm::vec2( 0.9f, 0.8f ) );
+	changes = applyEdits( edited, live );
+	check( changes.numGeometry == 1 && changes.numUnchanged == 2 && live[1]->getControlPoint( 2 ) == glm::vec2( 0.9f, 0.8f ),
+		"apply: a moved control point changes the geometry" );
+
+	std::dynamic_pointer_cast<WarpBilinear>( edited[0] )->setNumControlX( 3 );
+	changes = applyEdits( edited, live );
+	WarpSettings::Snapshot applied;
+	WarpSettings::takeSnapshot( live, applied );
+	check( changes.numTopology == 1 && changes.numUnchanged == 2 && applied.blocks[0].controlsX == 3, "apply: a new grid size changes the topology" );
+	check( live[0] == original[0] && live[1] == original[1] && live[2] == original[2], "apply: changed warps are updated in place" );
+
+	edited[2] = WarpRef( new WarpBilinear() );
+	changes = applyEdits( edited, live );
+	check( changes.numReplaced == 1 && live[2] != original[2] && live[2]->getType() == Warp::BILINEAR, "apply: a new type replaces the warp" );
+
+	edited.push_back( WarpRef( new WarpPerspective() ) );
+	changes = applyEdits( edited, live );
+	check( changes.numAdded == 1 && changes.numUnchanged == 3 && live.size() == 4, "apply: a new warp is added" );
+
+	edited.erase( edited.begin() + 1, edited.end() );
+	changes = applyEdits( edited, live );
+	check( changes.numRemoved == 3 && changes.numUnchanged == 1 && live.size() == 1 && live[0] == original[0], "apply: missing warps are removed" );
+
+	// a block whose points do not form its grid leaves the warp as it is
+	WarpSettings::Snapshot snapshot;
+	edited[0]->setBrightness( 0.25f );
+	WarpSettings::takeSnapshot( edited, snapshot );
+	snapshot.blocks[0].numPoints--;
+	WarpSettings::apply( snapshot, live );
+	check( live.size() == 1 && live[0]->getBrightness() == 0.5f, "apply: an invalid grid is not applied" );
+}
+
+//! calls update() until something changes or the time runs out
+static WarpSettings::Changes waitForUpdate( WarpWatcher &watcher, WarpList &warps, int milliseconds )
+{
+	auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds( milliseconds );
+	while( std::chrono::steady_clock::now() < end ) {
+		WarpSettings::Changes changes = watcher.update( warps );
+		if( !changes.empty() ) return changes;
+		std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+	}
+
+	return WarpSettings::Changes();
+}
+
+static void testWatcher()
+{
+	string path = "test-reload.xml";
+	WarpList saved = createWarps();
+	Warp::writeSettings( saved, path );
+
+	WarpList live = Warp::readSettings( path );
+	WarpWatcher watcher;
+	watcher.setup( path, 20 );
+	check( watcher.isWatching(), "watcher: watches the file" );
+
+	// the file as it was loaded is not a change
+	check( waitForUpdate( watcher, live, 200 ).empty() && watcher.getNumReloads() == 0, "watcher: an unchanged file is not reloaded" );
+
+	saved[0]->setBrightness( 0.5f );
+	Warp::writeSettings( saved, path );
+	WarpSettings::Changes changes = waitForUpdate( watcher, live, 2000 );
+	check( changes.numParameters == 1 && live[0]->getBrightness() == 0.5f, "watcher: a rewritten file is applied" );
+
+	// half a file does not parse and is retried until it is complete
+	WarpSaver::writeAtomic( ofToDataPath( path ), "<warpconfig version=\"1.0\"><profile name=\"default\"><map id=\"1\"><warp method=\"bilinear\"" );
+	uint64_t numReloads = watcher.getNumReloads();
+	check( waitForUpdate( watcher, live, 200 ).empty() && watcher.getNumReloads() == numReloads && live.size() == 3,
+		"watcher: a half written file is not applied" );
+
+	saved[1]->setControlPoint( 0, glm::vec2( 0.1f, 0.1f ) );
+	Warp::writeSettings( saved, path );
+	changes = waitForUpdate( watcher, live, 2000 );
+	check( changes.numGeometry == 1 && live[1]->getControlPoint( 0 ) == glm::vec2( 0.1f, 0.1f ), "watcher: the completed file is applied" );
+
+	watcher.stop();
+	check( !watcher.isWatching(), "watcher: stops watching" );
+}
+
+int main()
+{
+	testApply();
+	testWatcher();
+
+	std::remove( ofToDataPath( "test-reload.xml" ).c_str() );
+
+	return finish();
+}
@@ -0,0 +1,231 @@
+// Checks the remap tables of WarpRemap: an identity warp maps every output pixel to its own content texel, a warp
+// in a larger window covers the whole output, the content area limits the coordinates and the tables do not depend
+// on the number of threads. Then checks the fixed point kernels of apply() against the floating point reference and
+// times both: every output pixel may differ from the reference by at most 1, pixels outside the warp must be
+// transparent in both.
+//
+// usage: test-remap [iterations]
+//
+// The kernel is selected when the addon is compiled: build once without flags for the scalar kernel, and again
+// with -msse4.1 and -mavx2 (for example in PROJECT_CFLAGS of config.make) to check the SIMD kernels.
+
+#include "ofMain.h"
+#include "Warp.h"
+#include "WarpRemap.h"
+#include "../../WarpTest.h"
+
+#include <chrono>
+
+//! bakes the warp with a single thread and with several threads, checks that both tables are identical
+static void bakeTwice( const string &name, Warp &warp, WarpRemap &remap )
+{
+	WarpRemap threaded;
+	remap.bake( warp, 0, 0, true, 1 );
+	threaded.bake( warp, 0, 0, true, 7 );
+
+	const ofFloatPixels &a = remap.getCoordinates(), &b = threaded.getCoordinates();
+	check( a.getWidth() == b.getWidth() && a.getHeight() == b.getHeight(), name + ": tables have the same size" );
+	if( a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight() ) return;
+
+	size_t numPixels = a.getWidth() * a.getHeight();
+	check( std::memcmp( a.getData(), b.getData(), numPixels * 2 * sizeof( float ) ) == 0, name + ": coordinates do not depend on the number of threads" );
+	check( std::memcmp( remap.getWeights().getData(), threaded.getWeights().getData(), numPixels * 3 * sizeof( float ) ) == 0,
+		name + ": weights do not depend on the number of threads" );
+}
+
+//! returns the number of output pixels inside the warp, checks that their coordinates lie within the rectangle
+static size_t countInside( const string &name, const WarpRemap &remap, const ofRectangle &bounds )
+{
+	const float *coordinates = remap.getCoordinates().getData();
+	size_t numPixels = remap.getWidth() * remap.getHeight(), numInside = 0, numOutOfBounds = 0;
+	for( size_t i = 0; i < numPixels; ++i ) {
+		float u = coordinates[i * 2], v = coordinates[i * 2 + 1];
+		if( u < 0.0f ) continue;
+
+		numInside++;
+		if( u < bounds.getLeft() - 1e-4f || u > bounds.getRight() + 1e-4f || v < bounds.getTop() - 1e-4f || v > bounds.getBottom() + 1e-4f )
+			numOutOfBounds++;
+	}
+
+	check( numOutOfBounds == 0, name + ": " + ofToString( numOutOfBounds ) + " coordinates outside " + ofToString( bounds ) );
+	return numInside;
+}
+
+static void testIdentity()
+{
+	TestWarp<WarpBilinear> warp( 320, 240, 320, 240 );
+	WarpRemap remap;
+	bakeTwice( "identity", warp, remap );
+
+	check( remap.getWidth() == 320 && remap.getHeight() == 240, "identity: table has the size of the window" );
+	check( countInside( "identity", remap, ofRectangle( 0, 0, 1, 1 ) ) == 320 * 240, "identity: covers every output pixel" );
+
+	// every output pixel samples the center of its own texel
+	const float *coordinates = remap.getCoordinates().getData();
+	double maxError = 0.0;
+	for( int y = 0; y < remap.getHeight(); ++y ) {
+		for( int x = 0; x < remap.getWidth(); ++x, coordinates += 2 ) {
+			maxError = std::max( maxError, std::abs( coordinates[0] - ( x + 0.5 ) / 320.0 ) );
+			maxError = std::max( maxError, std::abs( coordinates[1] - ( y + 0.5 ) / 240.0 ) );
+		}
+	}
+	check( maxError < 1e-4, "identity: differs from the texel centers by " + ofToString( maxError ) );
+}
+
+static void testWindow()
+{
+	// the control points are scaled to the window, so the table covers the window and not the content
+	TestWarp<WarpBilinear> warp( 640, 480, 1280, 720 );
+	WarpRemap remap;
+	bakeTwice( "window", warp, remap );
+
+	check( remap.getWidth() == 1280 && remap.getHeight() == 720, "window: table has the size of the window" );
+	check( countInside( "window", remap, ofRectangle( 0, 0, 1, 1 ) ) == 1280 * 720, "window: covers every output pixel" );
+
+	// a table of a different size scales the warp with it
+	remap.bake( warp, 640, 360 );
+	check( countInside( "window", remap, ofRectangle( 0, 0, 1, 1 ) ) == 640 * 360, "window: a smaller table covers every output pixel" );
+}
+
+static void testArea()
+{
+	// only the content area is displayed, stretched across the output
+	TestWarp<WarpBilinear> warp( 640, 480, 640, 480 );
+	warp.setContentArea( ofRectangle( 160, 120, 320, 240 ) );
+
+	WarpRemap remap;
+	bakeTwice( "area", warp, remap );
+	check( countInside( "area", remap, ofRectangle( 0.25f, 0.25f, 0.5f, 0.5f ) ) == 640 * 480, "area: covers every output pixel" );
+}
+
+static void testKeystone()
+{
+	// partly outside the output, with perspective
+	TestWarp<WarpPerspective> warp( 640, 480, 640, 480 );
+	warp.setControlPoint( 0, glm::vec2( -0.1f, 0.05f ) );
+	warp.setControlPoint( 1, glm::vec2( 0.95f, -0.15f ) );
+	warp.setControlPoint( 2, glm::vec2( 1.2f, 1.05f ) );
+	warp.setControlPoint( 3, glm::vec2( 0.1f, 0.9f ) );
+
+	WarpRemap remap;
+	bakeTwice( "keystone", warp, remap );
+
+	size_t numInside = countInside( "keystone", remap, ofRectangle( 0, 0, 1, 1 ) );
+	check( numInside > 0 && numInside < 640 * 480, "keystone: covers part of the output, " + ofToString( numInside ) + " pixels" );
+}
+
+//! content with gradients, hard edges and noise, so every kernel weight matters
+static ofPixels createContent( int width, int height )
+{
+	ofPixels pixels;
+	pixels.allocate( width, height, 4 );
+
+	uint32_t seed = 12345;
+	unsigned char *data = pixels.getData();
+	for( int y = 0; y < height; ++y ) {
+		for( int x = 0; x < width; ++x, data += 4 ) {
+			seed = seed * 1664525u + 1013904223u;
+			data[0] = (unsigned char)( x * 255 / ( width - 1 ) );
+			data[1] = (unsigned char)( ( ( x / 8 + y / 8 ) & 1 ) ? 255 : 0 );
+			data[2] = (unsigned char)( seed >> 24 );
+			data[3] = (unsigned char)( 255 - y * 255 / ( height - 1 ) );
+		}
+	}
+
+	return pixels;
+}
+
+template<typename Fn>
+static double timeMilliseconds( int iterations, Fn fn )
+{
+	auto start = std::chrono::steady_clock::now();
+	for( int i = 0; i < iterations; ++i )
+		fn();
+
+	return std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count() / iterations;
+}
+
+static void testKernel( const string &name, Warp &warp, const ofPixels &content, int iterations )
+{
+	WarpRemap remap;
+	remap.bake( warp );
+
+	ofPixels reference, output, single;
+	double referenceTime = timeMilliseconds( std::max( 1, iterations / 10 ), [&]() { WarpRemap::applyReference( remap.getCoordinates(), content, reference ); } );
+	double singleTime = timeMilliseconds( iterations, [&]() { remap.apply( content, single, 1 ); } );
+	double threadedTime = timeMilliseconds( iterations, [&]() { remap.apply( content, output ); } );
+
+	check( output.getWidth() == reference.getWidth() && output.getHeight() == reference.getHeight(), name + ": output has the size of the table" );
+	if( output.getWidth() != reference.getWidth() || output.getHeight() != reference.getHeight() ) return;
+
+	size_t numValues = output.getWidth() * output.getHeight() * 4;
+	int maxDifference = 0;
+	size_t numDifferent = 0;
+	for( size_t i = 0; i < numValues; ++i ) {
+		int difference = std::abs( int( output.getData()[i] ) - int( reference.getData()[i] ) );
+		maxDifference = std::max( maxDifference, difference );
+		if( difference != 0 ) numDifferent++;
+	}
+
+	// pixels outside the warp must match exactly
+	const float *coordinates = remap.getCoordinates().getData();
+	size_t numOutside = 0;
+	bool transparent = true;
+	for( size_t i = 0; i < output.getWidth() * output.getHeight(); ++i ) {
+		if( coordinates[i * 2] >= 0.0f ) continue;
+
+		numOutside++;
+		for( int c = 0; c < 4; ++c )
+			transparent = transparent && output.getData()[i * 4 + c] == 0;
+	}
+
+	check( maxDifference <= 1, name + ": differs from the reference by " + ofToString( maxDifference ) );
+	check( transparent, name + ": pixels outside the warp are transparent" );
+	check( std::equal( output.getData(), output.getData() + numValues, single.getData() ), name + ": result does not depend on the number of threads" );
+
+	cout << name << ": " << output.getWidth() << " x " << output.getHeight() << ", " << numOutside << " pixels outside, "
+		<< numDifferent << " values off by 1" << endl;
+	cout << "  reference " << ofToString( referenceTime, 2 ) << " ms, " << WarpRemap::getKernelName() << " " << ofToString( singleTime, 2 )
+		<< " ms, threaded " << ofToString( threadedTime, 2 ) << " ms" << endl;
+}
+
+int main( int argc, char *argv[] )
+{
+	testIdentity();
+	testWindow();
+	testArea();
+	testKeystone();
+
+	int iterations = ( argc > 1 ) ? std::max( 1, ofToInt( argv[1] ) ) : 20;
+	cout << "kernel: " << WarpRemap::getKernelName() << endl;
+
+	ofPixels content = createContent( 1920, 1080 );
+
+	// an unbaked table resamples nothing
+	WarpRemap empty;
+	ofPixels none;
+	empty.apply( content, none );
+	check( none.getWidth() == 0 && none.getHeight() == 0, "empty: apply() before bake() produces no pixels" );
+
+	// identity, every output pixel samples a texel center
+	TestWarp<WarpBilinear> identity( 1920, 1080, 1920, 1080 );
+	testKernel( "identity", identity, content, iterations );
+
+	// keystone that magnifies the content, partly outside the output
+	TestWarp<WarpPerspective> keystone( 1920, 1080, 1920, 1080 );
+	keystone.setControlPoint( 0, glm::vec2( -0.1f, 0.05f ) );
+	keystone.setControlPoint( 1, glm::vec2( 0.95f, -0.15f ) );
+	keystone.setControlPoint( 2, glm::vec2( 1.2f, 1.05f ) );
+	keystone.setControlPoint( 3, glm::vec2( 0.1f, 0.9f ) );
+	testKernel( "keystone", keystone, content, iterations );
+
+	// a smaller output that minifies the content, with transparent borders
+	TestWarp<WarpBilinear> shrink( 1920, 1080, 1920, 1080 );
+	shrink.setControlPoint( 0, glm::vec2( 0.2f, 0.15f ) );
+	shrink.setControlPoint( 1, glm::vec2( 0.25f, 0.8f ) );
+	shrink.setControlPoint( 2, glm::vec2( 0.85f, 0.2f ) );
+	shrink.setControlPoint( 3, glm::vec2( 0.8f, 0.85f ) );
+	testKernel( "shrink", shrink, content, iterations );
+
+	return finish();
+}
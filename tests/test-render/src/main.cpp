@@ -0,0 +1,153 @@
+// Checks WarpSoftwareRenderer: an identity warp reproduces the content, a warp in a larger window renders at the
+// size of the window, pixels outside the warp are transparent, the output does not depend on the number of threads
+// and the remap table and color lut are only rebuilt when the warp changes.
+//
+// usage: test-render
+
+#include "ofMain.h"
+#include "WarpSoftwareRenderer.h"
+#include "../../WarpTest.h"
+
+//! content with gradients, hard edges and noise
+static ofPixels createContent( int width, int height, int channels )
+{
+	ofPixels pixels;
+	pixels.allocate( width, height, channels );
+
+	uint32_t seed = 12345;
+	unsigned char *data = pixels.getData();
+	for( int y = 0; y < height; ++y ) {
+		for( int x = 0; x < width; ++x, data += channels ) {
+			seed = seed * 1664525u + 1013904223u;
+			data[0] = (unsigned char)( x * 255 / ( width - 1 ) );
+			data[1] = (unsigned char)( ( ( x / 8 + y / 8 ) & 1 ) ? 255 : 0 );
+			data[2] = (unsigned char)( seed >> 24 );
+			if( channels == 4 ) data[3] = 255;
+		}
+	}
+
+	return pixels;
+}
+
+//! renders the warp with a single thread and with several threads, checks that both outputs are identical
+static void renderTwice( const string &name, Warp &warp, const ofPixels &content, ofPixels &output )
+{
+	WarpSoftwareRenderer single, threaded;
+	ofPixels other;
+	single.render( warp, content, output, 1 );
+	threaded.render( warp, content, other, 7 );
+
+	check( output.getWidth() == other.getWidth() && output.getHeight() == other.getHeight(), name + ": outputs have the same size" );
+	check( output.size() == other.size() && std::equal( output.getData(), output.getData() + output.size(), other.getData() ),
+		name + ": output does not depend on the number of threads" );
+}
+
+static void testIdentity( int channels )
+{
+	string name = "identity " + ofToString( channels ) + " channels";
+	ofPixels content = createContent( 320, 240, channels );
+
+	TestWarp<WarpBilinear> warp( 320, 240, 320, 240 );
+	ofPixels output;
+	renderTwice( name, warp, content, output );
+
+	check( output.getWidth() == 320 && output.getHeight() == 240 && output.getNumChannels() == 4, name + ": output is RGBA at the size of the warp" );
+	if( output.getWidth() != 320 || output.getHeight() != 240 ) return;
+
+	// every output pixel samples the center of its own texel, with neutral colors and no edges
+	int maxDifference = 0;
+	for( size_t i = 0; i < size_t( 320 ) * 240; ++i ) {
+		for( int c = 0; c < 3; ++c )
+			maxDifference = std::max( maxDifference, std::abs( int( output.getData()[i * 4 + c] ) - int( content.getData()[i * channels + c] ) ) );
+		maxDifference = std::max( maxDifference, 255 - int( output.getData()[i * 4 + 3] ) );
+	}
+	check( maxDifference <= 1, name + ": differs from the content by " + ofToString( maxDifference ) );
+}
+
+static void testWindow()
+{
+	// without an allocated output, the output has the size of the window the control points are scaled to
+	ofPixels content = createContent( 160, 120, 4 );
+	TestWarp<WarpBilinear> warp( 160, 120, 320, 240 );
+	ofPixels output;
+	renderTwice( "window", warp, content, output );
+
+	check( output.getWidth() == 320 && output.getHeight() == 240, "window: output has the size of the window" );
+
+	size_t numOpaque = 0;
+	for( size_t i = 0; i < output.getWidth() * output.getHeight(); ++i )
+		if( output.getData()[i * 4 + 3] == 255 ) numOpaque++;
+	check( numOpaque == output.getWidth() * output.getHeight(), "window: covers every output pixel" );
+}
+
+static void testKeystone()
+{
+	// partly outside the output, which must stay transparent
+	ofPixels content = createContent( 320, 240, 4 );
+	TestWarp<WarpPerspective> warp( 320, 240, 320, 240 );
+	warp.setControlPoint( 0, glm::vec2( -0.1f, 0.05f ) );
+	warp.setControlPoint( 1, glm::vec2( 0.95f, -0.15f ) );
+	warp.setControlPoint( 2, glm::vec2( 1.2f, 1.05f ) );
+	warp.setControlPoint( 3, glm::vec2( 0.1f, 0.9f ) );
+	warp.setEdges( 0.1f, 0.1f, 0.1f, 0.1f );
+
+	ofPixels output;
+	renderTwice( "keystone", warp, content, output );
+
+	WarpSoftwareRenderer renderer;
+	renderer.render( warp, content, output );
+	const float *coordinates = renderer.getRemap().getCoordinates().getData();
+	size_t numOutside = 0;
+	bool transparent = true;
+	for( size_t i = 0; i < output.getWidth() * output.getHeight(); ++i ) {
+		if( coordinates[i * 2] >= 0.0f ) continue;
+
+		numOutside++;
+		for( int c = 0; c < 4; ++c )
+			transparent = transparent && output.getData()[i * 4 + c] == 0;
+	}
+	check( numOutside > 0 && transparent, "keystone: pixels outside the warp are transparent" );
+}
+
+static void testCaching()
+{
+	ofPixels content = createContent( 160, 120, 4 );
+	TestWarp<WarpBilinear> warp( 160, 120, 160, 120 );
+	WarpSoftwareRenderer renderer;
+	ofPixels output;
+
+	// neutral colors need no lut, an unchanged warp needs no new table
+	renderer.render( warp, content, output );
+	renderer.render( warp, content, output );
+	check( renderer.getRemap().getNumBakes() == 1, "caching: the table is baked once" );
+	check( renderer.getNumLutBuilds() == 0, "caching: neutral colors build no lut" );
+
+	ofPixels neutral = output;
+	warp.setBrightness( 0.5f );
+	renderer.render( warp, content, output );
+	renderer.render( warp, content, output );
+	check( renderer.getRemap().getNumBakes() == 1, "caching: the colors do not change the table" );
+	check( renderer.getNumLutBuilds() == 1, "caching: the lut is built once" );
+
+	uint64_t sum = 0, neutralSum = 0;
+	for( size_t i = 0; i < output.size(); ++i ) {
+		sum += output.getData()[i];
+		neutralSum += neutral.getData()[i];
+	}
+	check( sum < neutralSum, "caching: the brightness darkens the output" );
+
+	warp.setControlPoint( 0, glm::vec2( 0.1f, 0.1f ) );
+	renderer.render( warp, content, output );
+	check( renderer.getRemap().getNumBakes() == 2, "caching: moving a control point bakes the table again" );
+}
+
+int main()
+{
+	testIdentity( 3 );
+	testIdentity( 4 );
+	testWindow();
+	testKeystone();
+	testCaching();
+
+	return finish();
+}
@@ -0,0 +1,137 @@
+// Checks WarpSaver: the files it writes in the background are identical to the ones Warp::writeSettings and
+// WarpSettings::write produce, a burst of saves is coalesced and the file holds the last one, the destructor
+// finishes the last save and a failed write leaves no file behind. Prints how long save() takes.
+//
+// usage: test-saver
+//
+// Writes its files to the data folder and removes them afterwards.
+
+#include "ofMain.h"
+#include "Warp.h"
+#include "WarpSaver.h"
+#include "../../WarpTest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+static std::string readFile( const std::string &path )
+{
+	std::ifstream file( ofToDataPath( path ).c_str(), std::ios::binary );
+	return std::string( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+}
+
+static bool exists( const std::string &path )
+{
+	return std::ifstream( ofToDataPath( path ).c_str() ).good();
+}
+
+//! a large bilinear warp, so writing it takes much longer than copying its parameters
+static WarpList createWarps()
+{
+	WarpList warps;
+
+	WarpBilinearRef bilinear( new WarpBilinear() );
+	bilinear->setNumControlX( 64 );
+	bilinear->setNumControlY( 64 );
+	bilinear->setGamma( 2.2f, 1.8f, 2.4f );
+	warps.push_back( bilinear );
+
+	WarpPerspectiveBilinearRef perspectiveBilinear( new WarpPerspectiveBilinear() );
+	perspectiveBilinear->setControlPoint( 1, glm::vec2( 0.02f, 0.97f ) );
+	warps.push_back( perspectiveBilinear );
+
+	return warps;
+}
+
+static void testFormats()
+{
+	WarpList warps = createWarps();
+	string xml = "test-saver-reference.xml";
+	Warp::writeSettings( warps, xml );
+	WarpSettings::write( warps, "test-saver-reference.bin" );
+
+	WarpSaver saver;
+	saver.save( warps, "test-saver.xml" );
+	saver.flush();
+	saver.save( warps, "test-saver.bin", WarpSaver::BINARY );
+	saver.flush();
+
+	check( saver.getLastResult() && !saver.isSaving(), "formats: the saves succeed" );
+	check( saver.getNumRequests() == 2 && saver.getNumWrites() == 2, "formats: each flushed save is written" );
+	check( !readFile( xml ).empty() && readFile( "test-saver.xml" ) == readFile( xml ), "formats: xml is identical to Warp::writeSettings" );
+	check( !readFile( "test-saver.bin" ).empty() && readFile( "test-saver.bin" ) == readFile( "test-saver-reference.bin" ),
+		"formats: binary is identical to WarpSettings::write" );
+	check( !exists( "test-saver.xml.tmp" ) && !exists( "test-saver.bin.tmp" ), "formats: no temporary files are left" );
+}
+
+static void testBurst()
+{
+	WarpList warps = createWarps();
+	WarpSaver saver;
+
+	// an autosave while dragging a control point
+	const int numSaves = 200;
+	double maxMilliseconds = 0.0;
+	for( int i = 0; i < numSaves; ++i ) {
+		warps[0]->setControlPoint( 1, glm::vec2( i / float( numSaves ), 0.5f ) );
+
+		auto start = std::chrono::steady_clock::now();
+		saver.save( warps, "test-saver.xml" );
+		maxMilliseconds = std::max( maxMilliseconds, std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count() );
+	}
+	saver.flush();
+
+	check( saver.getNumRequests() == numSaves, "burst: every save is requested" );
+	check( saver.getNumWrites() >= 1 && saver.getNumWrites() < numSaves, "burst: saves are coalesced, " + ofToString( saver.getNumWrites() ) + " writes" );
+
+	// the file holds the last save
+	string xml = "test-saver-reference.xml";
+	Warp::writeSettings( warps, xml );
+	check( readFile( "test-saver.xml" ) == readFile( xml ), "burst: the file holds the last save" );
+
+	cout << "burst: " << numSaves << " saves, " << saver.getNumWrites() << " writes, save() took at most "
+		<< ofToString( maxMilliseconds, 3 ) << " ms" << endl;
+}
+
+static void testDestructor()
+{
+	string xml = "test-saver-reference.xml";
+	Warp::writeSettings( createWarps(), xml );
+
+	std::remove( ofToDataPath( "test-saver.xml" ).c_str() );
+	{
+		WarpSaver saver;
+		saver.save( createWarps(), "test-saver.xml" );
+	}
+	check( !readFile( "test-saver.xml" ).empty() && readFile( "test-saver.xml" ) == readFile( xml ), "destructor: the last save is written" );
+}
+
+static void testFailure()
+{
+	WarpSaver saver;
+	saver.save( createWarps(), "test-saver-missing/test-saver.xml" );
+	saver.flush();
+
+	check( !saver.getLastResult() && saver.getNumWrites() == 1, "failure: a save into a missing folder fails" );
+	check( !exists( "test-saver-missing/test-saver.xml.tmp" ), "failure: no temporary file is left" );
+
+	// the file is replaced as a whole
+	check( WarpSaver::writeAtomic( ofToDataPath( "test-saver.xml" ), "new" ) && readFile( "test-saver.xml" ) == "new"
+		&& !exists( "test-saver.xml.tmp" ), "failure: writeAtomic replaces an existing file" );
+}
+
+int main()
+{
+	testFormats();
+	testBurst();
+	testDestructor();
+	testFailure();
+
+	std::remove( ofToDataPath( "test-saver.xml" ).c_str() );
+	std::remove( ofToDataPath( "test-saver.bin" ).c_str() );
+	std::remove( ofToDataPath( "test-saver-reference.xml" ).c_str() );
+	std::remove( ofToDataPath( "test-saver-reference.bin" ).c_str() );
+
+	return finish();
+}
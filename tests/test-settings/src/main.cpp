@@ -0,0 +1,192 @@
+// Checks the settings files: xml converted to binary and back to xml is byte identical, the binary file is mapped
+// with aligned point arrays, files of previous versions still read, and damaged binary files (truncated, wrong
+// magic, newer version, control points that don't form a grid) are rejected instead of creating warps.
+//
+// usage: test-settings
+//
+// Writes its files to the data folder and removes them afterwards.
+
+#include "ofMain.h"
+#include "Warp.h"
+#include "WarpSettings.h"
+#include "../../WarpTest.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+
+static std::string readFile( const std::string &path )
+{
+	std::ifstream file( ofToDataPath( path ).c_str(), std::ios::binary );
+	return std::string( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+}
+
+static void writeFile( const std::string &path, const std::string &data )
+{
+	std::ofstream file( ofToDataPath( path ).c_str(), std::ios::binary | std::ios::trunc );
+	file.write( data.data(), data.size() );
+}
+
+//! a color matrix for projector matching, with values that have no short decimal representation
+static glm::mat3 createColorMatrix()
+{
+	glm::mat3 matrix( 1.0f );
+	matrix[0] = glm::vec3( 0.9f, 0.05f, 0.0f );
+	matrix[1] = glm::vec3( 0.1f, 1.0f / 3.0f, 0.05f );
+	matrix[2] = glm::vec3( 0.0f, 0.1f, 0.95f );
+	return matrix;
+}
+
+//! a warp of every type, with values that have no short decimal representation
+static WarpList createWarps()
+{
+	WarpList warps;
+
+	WarpBilinearRef bilinear( new WarpBilinear() );
+	bilinear->setNumControlX( 3 );
+	bilinear->setNumControlY( 4 );
+	bilinear->setControlPoint( 4, glm::vec2( 1.0f / 3.0f, 0.1f ) );
+	bilinear->setLinear( true );
+	bilinear->setBrightness( 0.7f );
+	bilinear->setEdges( 0.1f, 0.2f, 1.0f / 7.0f, 0.0f );
+	bilinear->setGamma( 2.2f, 1.8f, 2.4f );
+	bilinear->setColorMatrix( createColorMatrix() );
+	warps.push_back( bilinear );
+
+	WarpPerspectiveRef perspective( new WarpPerspective() );
+	perspective->setControlPoint( 0, glm::vec2( -0.05f, 0.01f ) );
+	perspective->setControlPoint( 3, glm::vec2( 0.123456789f, 0.987654321f ) );
+	perspective->setLuminance( 0.45f );
+	perspective->setContentArea( ofRectangle( 160, 120, 320, 240 ) );
+	warps.push_back( perspective );
+
+	WarpPerspectiveBilinearRef perspectiveBilinear( new WarpPerspectiveBilinear() );
+	perspectiveBilinear->setControlPoint( 1, glm::vec2( 0.02f, 0.97f ) );
+	warps.push_back( perspectiveBilinear );
+
+	return warps;
+}
+
+static void testRoundTrip()
+{
+	std::string xml = "test-settings.xml";
+	Warp::writeSettings( createWarps(), xml );
+
+	check( !WarpSettings::isBinary( xml ), "round trip: xml is not detected as binary" );
+	check( WarpSettings::convertFromXml( xml, "test-settings.bin" ), "round trip: converts xml to binary" );
+	check( WarpSettings::isBinary( "test-settings.bin" ), "round trip: binary is detected as binary" );
+	check( WarpSettings::convertToXml( "test-settings.bin", "test-settings-2.xml" ), "round trip: converts binary to xml" );
+
+	std::string original = readFile( xml );
+	check( !original.empty() && original == readFile( "test-settings-2.xml" ), "round trip: xml -> binary -> xml is byte identical" );
+
+	// the binary file is read through the mapping
+	WarpSettings settings;
+	check( settings.open( "test-settings.bin" ), "round trip: opens the binary file" );
+	check( settings.getNumWarps() == 3, "round trip: holds every warp" );
+	for( size_t i = 0; i < settings.getNumWarps(); ++i )
+		check( ( (uintptr_t)settings.getPoints( i ) % WarpSettings::ALIGNMENT ) == 0, "round trip: points of warp " + ofToString( i ) + " are aligned" );
+	settings.close();
+
+	// readSettings accepts both formats
+	WarpList warps = Warp::readSettings( "test-settings.bin" );
+	check( warps.size() == 3 && warps[0]->getType() == Warp::BILINEAR && warps[1]->getType() == Warp::PERSPECTIVE
+		&& warps[2]->getType() == Warp::PERSPECTIVE_BILINEAR, "round trip: readSettings creates the warps of the binary file" );
+	check( warps.size() == 3 && warps[0]->getControlPoint( 4 ) == glm::vec2( 1.0f / 3.0f, 0.1f ), "round trip: control points are restored exactly" );
+	check( warps.size() == 3 && warps[0]->getColorMatrix() == createColorMatrix() && warps[1]->getColorMatrix() == glm::mat3( 1.0f ),
+		"round trip: the color matrix is restored exactly" );
+	check( warps.size() == 3 && warps[1]->getContentArea() == ofRectangle( 160, 120, 320, 240 ) && warps[0]->getContentArea() == warps[0]->getBounds(),
+		"round trip: the content area is restored" );
+
+	warps = Warp::readSettings( xml );
+	check( warps.size() == 3 && warps[0]->getColorMatrix() == createColorMatrix() && warps[2]->getColorMatrix() == glm::mat3( 1.0f ),
+		"round trip: the color matrix is read from xml" );
+	check( warps.size() == 3 && warps[1]->getContentArea() == ofRectangle( 160, 120, 320, 240 ) && warps[2]->getContentArea() == warps[2]->getBounds(),
+		"round trip: the content area is read from xml" );
+}
+
+//! rewrites the binary file with the shorter blocks of an earlier version, the point arrays stay where they are
+static WarpList readVersion( uint32_t version, size_t blockSize )
+{
+	std::string data = readFile( "test-settings.bin" );
+	WarpSettings::Header header;
+	memcpy( &header, &data[0], sizeof( header ) );
+
+	for( uint32_t i = 0; i < header.numWarps; ++i )
+		memmove( &data[sizeof( header ) + i * blockSize], &data[sizeof( header ) + i * sizeof( WarpSettings::Block )], blockSize );
+	header.version = version;
+	header.blockSize = (uint32_t)blockSize;
+	memcpy( &data[0], &header, sizeof( header ) );
+	writeFile( "test-settings-old.bin", data );
+
+	return WarpSettings::read( "test-settings-old.bin" );
+}
+
+static void testPreviousVersions()
+{
+	// version 1 blocks end before the color matrix
+	WarpList warps = readVersion( 1, offsetof( WarpSettings::Block, colorMatrix ) );
+	check( warps.size() == 3 && warps[0]->getBrightness() == 0.7f && warps[0]->getControlPoint( 4 ) == glm::vec2( 1.0f / 3.0f, 0.1f ),
+		"version 1: reads the warps" );
+	check( warps.size() == 3 && warps[0]->getColorMatrix() == glm::mat3( 1.0f ), "version 1: the color matrix is the identity" );
+	check( warps.size() == 3 && warps[1]->getContentArea() == warps[1]->getBounds(), "version 1: the warps display all content" );
+
+	// version 2 blocks end before the content area
+	warps = readVersion( 2, offsetof( WarpSettings::Block, contentArea ) );
+	check( warps.size() == 3 && warps[0]->getColorMatrix() == createColorMatrix(), "version 2: reads the color matrix" );
+	check( warps.size() == 3 && warps[1]->getContentArea() == warps[1]->getBounds(), "version 2: the warps display all content" );
+}
+
+//! writes a damaged copy of the binary file, checks that it is rejected
+static void checkRejected( const std::string &name, const std::string &data )
+{
+	writeFile( "test-settings-bad.bin", data );
+
+	WarpSettings settings;
+	check( !settings.open( "test-settings-bad.bin" ), name + ": open() rejects the file" );
+	check( WarpSettings::read( "test-settings-bad.bin" ).empty(), name + ": read() creates no warps" );
+}
+
+static void testDamaged()
+{
+	std::string data = readFile( "test-settings.bin" );
+	check( data.size() > sizeof( WarpSettings::Header ) + 3 * sizeof( WarpSettings::Block ), "damaged: the binary file is complete" );
+	if( data.size() <= sizeof( WarpSettings::Header ) + 3 * sizeof( WarpSettings::Block ) ) return;
+
+	checkRejected( "truncated", data.substr( 0, data.size() - 1 ) );
+	checkRejected( "header only", data.substr( 0, sizeof( WarpSettings::Header ) ) );
+
+	std::string magic = data;
+	magic[0] = 'X';
+	checkRejected( "magic", magic );
+
+	std::string version = data;
+	WarpSettings::Header header;
+	memcpy( &header, &version[0], sizeof( header ) );
+	header.version = WarpSettings::VERSION + 1;
+	memcpy( &version[0], &header, sizeof( header ) );
+	checkRejected( "version", version );
+
+	// a 3 x 4 grid with one point less
+	std::string grid = data;
+	WarpSettings::Block block;
+	memcpy( &block, &grid[sizeof( WarpSettings::Header )], sizeof( block ) );
+	block.numPoints--;
+	memcpy( &grid[sizeof( WarpSettings::Header )], &block, sizeof( block ) );
+	checkRejected( "grid", grid );
+}
+
+int main()
+{
+	testRoundTrip();
+	testPreviousVersions();
+	testDamaged();
+
+	std::remove( ofToDataPath( "test-settings.xml" ).c_str() );
+	std::remove( ofToDataPath( "test-settings-2.xml" ).c_str() );
+	std::remove( ofToDataPath( "test-settings.bin" ).c_str() );
+	std::remove( ofToDataPath( "test-settings-old.bin" ).c_str() );
+	std::remove( ofToDataPath( "test-settings-bad.bin" ).c_str() );
+
+	return finish();
+}
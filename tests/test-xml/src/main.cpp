@@ -0,0 +1,200 @@
+// Checks the streaming settings xml: floats written by WarpXmlWriter read back as the same value and use the shortest
+// text, number parsing accepts what ofToFloat accepts and rejects the rest, malformed documents are rejected, and
+// a settings file written by the ofXml based writer of earlier versions still reads with every value intact.
+//
+// usage: test-xml
+//
+// Writes its files to the data folder and removes them afterwards.
+
+#include "ofMain.h"
+#include "Warp.h"
+#include "WarpXml.h"
+#include "../../WarpTest.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+static std::string format( float value )
+{
+	char buffer[32];
+	size_t length = WarpXmlWriter::format( value, buffer, sizeof( buffer ) );
+	return std::string( buffer, length );
+}
+
+static void testFloats()
+{
+	// typical settings values keep their short decimal text
+	check( format( 0.1f ) == "0.1", "floats: 0.1 is written as " + format( 0.1f ) );
+	check( format( 2.2f ) == "2.2", "floats: 2.2 is written as " + format( 2.2f ) );
+	check( format( 1.0f ) == "1", "floats: 1 is written as " + format( 1.0f ) );
+	check( format( -0.05f ) == "-0.05", "floats: -0.05 is written as " + format( -0.05f ) );
+	check( format( 1.0f / 3.0f ) == "0.33333334", "floats: 1/3 is written as " + format( 1.0f / 3.0f ) );
+	check( Warp::toString( 0.45f ) == "0.45", "floats: Warp::toString uses the same format" );
+
+	// random normal floats, every one must read back with the same bits, also through strtof
+	uint32_t seed = 12345;
+	size_t numWrong = 0, numLong = 0;
+	for( int i = 0; i < 1000000; ++i ) {
+		seed = seed * 1664525u + 1013904223u;
+		uint32_t bits = seed & 0x807fffffu;
+		bits |= ( 1u + ( seed >> 8 ) % 253u ) << 23;
+
+		float value;
+		memcpy( &value, &bits, sizeof( value ) );
+
+		std::string text = format( value );
+		float parsed = 0.0f;
+		if( !WarpXmlReader::toFloat( text, parsed ) || memcmp( &parsed, &value, sizeof( value ) ) != 0 || strtof( text.c_str(), nullptr ) != value )
+			numWrong++;
+		if( text.size() > 15 )
+			numLong++;
+	}
+	check( numWrong == 0, "floats: " + ofToString( numWrong ) + " values do not read back as the same float" );
+	check( numLong == 0, "floats: " + ofToString( numLong ) + " values use more than 9 significant digits" );
+
+	// decimal values of up to 4 digits, as typed into settings files, are written as typed
+	size_t numChanged = 0;
+	for( int i = -10000; i <= 10000; ++i ) {
+		float value = i / 1000.0f;
+		if( WarpXmlReader::toFloat( format( value ), value ) && value != i / 1000.0f )
+			numChanged++;
+		if( format( value ).size() > ofToString( i / 1000.0 ).size() )
+			numChanged++;
+	}
+	check( numChanged == 0, "floats: " + ofToString( numChanged ) + " decimal values are not written in their shortest form" );
+}
+
+static void testNumbers()
+{
+	float f = 0.0f;
+	int i = 0;
+	check( WarpXmlReader::toFloat( " 0.5 ", f ) && f == 0.5f, "numbers: surrounding whitespace is ignored" );
+	check( WarpXmlReader::toFloat( "+1.5", f ) && f == 1.5f, "numbers: a leading plus sign is accepted" );
+	check( WarpXmlReader::toFloat( "1e-3", f ) && f == 1e-3f, "numbers: exponents are accepted" );
+	check( !WarpXmlReader::toFloat( "", f ), "numbers: empty text is rejected" );
+	check( !WarpXmlReader::toFloat( "abc", f ), "numbers: text is rejected" );
+	check( !WarpXmlReader::toFloat( "1e60", f ), "numbers: out of range values are rejected" );
+	check( WarpXmlReader::toInt( " 42", i ) && i == 42, "numbers: integers are parsed" );
+	check( !WarpXmlReader::toInt( "x1", i ), "numbers: text is not an integer" );
+}
+
+//! records every element as "depth:name", with the value of the attribute "a" if it exists
+class Recorder : public WarpXmlReader::Handler {
+	public:
+		void startElement( std::string_view name, const WarpXmlReader::Attributes &attributes, int depth ) override
+		{
+			elements += ofToString( depth ) + ":" + std::string( name );
+			if( attributes.has( "a" ) ) elements += "=" + std::string( attributes.get( "a" ) );
+			elements += " ";
+		}
+
+		std::string	elements;
+};
+
+static bool parse( const std::string &xml, std::string &elements )
+{
+	WarpXmlReader reader;
+	Recorder recorder;
+	bool result = reader.parse( xml.data(), xml.size(), recorder );
+	elements = recorder.elements;
+	return result;
+}
+
+static void testDocuments()
+{
+	std::string elements;
+	check( parse( "<?xml version=\"1.0\"?><!-- comment --><a><b a='1 &amp; 2'/><c a=\"&#65;&lt;\">text</c></a>", elements )
+		&& elements == "0:a 1:b=1 & 2 1:c=A< ", "documents: declarations, comments, entities and text, " + elements );
+	check( !parse( "<a><b></a>", elements ), "documents: mismatched tags are rejected" );
+	check( !parse( "<a>", elements ), "documents: unclosed elements are rejected" );
+	check( !parse( "<a b=\"1></a>", elements ), "documents: unterminated attributes are rejected" );
+	check( !parse( "", elements ), "documents: an empty file is rejected" );
+}
+
+//! a settings file as written by the ofXml based writer: declaration, ofToString values and the corners of the
+//! perspective-bilinear warp inside <blend>
+static const char *legacySettings =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<warpconfig version=\"1.0\" profile=\"default\">\n"
+	"\t<profile name=\"default\">\n"
+	"\t\t<map id=\"1\" display=\"1\">\n"
+	"\t\t\t<warp method=\"bilinear\" width=\"2\" height=\"2\" brightness=\"0.7\" contrast=\"1\" saturation=\"1\">\n"
+	"\t\t\t\t<controlpoint x=\"0\" y=\"0\" />\n"
+	"\t\t\t\t<controlpoint x=\"0\" y=\"1\" />\n"
+	"\t\t\t\t<controlpoint x=\"0.333333\" y=\"0.1\" />\n"
+	"\t\t\t\t<controlpoint x=\"1\" y=\"1\" />\n"
+	"\t\t\t\t<blend exponent=\"2\" resolution=\"16\" linear=\"1\" adaptive=\"0\">\n"
+	"\t\t\t\t\t<edges left=\"0.1\" top=\"0.2\" right=\"0.142857\" bottom=\"0\" />\n"
+	"\t\t\t\t\t<gamma red=\"2.2\" green=\"1.8\" blue=\"2.4\" />\n"
+	"\t\t\t\t\t<luminance red=\"0.5\" green=\"0.5\" blue=\"0.5\" />\n"
+	"\t\t\t\t</blend>\n"
+	"\t\t\t</warp>\n"
+	"\t\t</map>\n"
+	"\t\t<map id=\"2\" display=\"1\">\n"
+	"\t\t\t<warp method=\"perspectivebilinear\" width=\"2\" height=\"2\" brightness=\"1\" contrast=\"1\" saturation=\"1\">\n"
+	"\t\t\t\t<controlpoint x=\"0\" y=\"0\" />\n"
+	"\t\t\t\t<controlpoint x=\"0\" y=\"1\" />\n"
+	"\t\t\t\t<controlpoint x=\"1\" y=\"0\" />\n"
+	"\t\t\t\t<controlpoint x=\"1\" y=\"1\" />\n"
+	"\t\t\t\t<blend exponent=\"2\">\n"
+	"\t\t\t\t\t<edges left=\"0\" top=\"0\" right=\"0\" bottom=\"0\" />\n"
+	"\t\t\t\t\t<gamma red=\"1\" green=\"1\" blue=\"1\" />\n"
+	"\t\t\t\t\t<luminance red=\"0.45\" green=\"0.45\" blue=\"0.45\" />\n"
+	"\t\t\t\t\t<corner x=\"0\" y=\"0\" />\n"
+	"\t\t\t\t\t<corner x=\"0.02\" y=\"0.97\" />\n"
+	"\t\t\t\t\t<corner x=\"1\" y=\"1\" />\n"
+	"\t\t\t\t\t<corner x=\"0\" y=\"1\" />\n"
+	"\t\t\t\t</blend>\n"
+	"\t\t\t</warp>\n"
+	"\t\t</map>\n"
+	"\t</profile>\n"
+	"</warpconfig>\n";
+
+static void testLegacy()
+{
+	{
+		std::ofstream file( ofToDataPath( "test-xml.xml" ).c_str(), std::ios::binary | std::ios::trunc );
+		file << legacySettings;
+	}
+
+	WarpList warps = Warp::readSettings( "test-xml.xml" );
+	check( warps.size() == 2 && warps[0]->getType() == Warp::BILINEAR && warps[1]->getType() == Warp::PERSPECTIVE_BILINEAR,
+		"legacy: creates the warps of the file" );
+	if( warps.size() != 2 ) return;
+
+	check( warps[0]->getControlPoint( 2 ) == glm::vec2( 0.333333f, 0.1f ), "legacy: control points are read" );
+	check( warps[0]->getBrightness() == 0.7f && warps[0]->getGamma() == ofVec3f( 2.2f, 1.8f, 2.4f ), "legacy: colors are read" );
+	// getEdges() returns twice the stored values
+	check( warps[0]->getEdges() == ofVec3f( 0.2f, 0.4f, 0.285714f ), "legacy: edges are read" );
+	check( warps[1]->getLuminance() == ofVec3f( 0.45f ), "legacy: luminance is read" );
+
+	// written again, the values keep their text and the corners move next to <blend>
+	string target = "test-xml-2.xml";
+	Warp::writeSettings( warps, target );
+
+	std::ifstream file( ofToDataPath( target ).c_str(), std::ios::binary );
+	std::string written( ( std::istreambuf_iterator<char>( file ) ), std::istreambuf_iterator<char>() );
+	check( written.find( "<controlpoint x=\"0.333333\" y=\"0.1\"/>" ) != std::string::npos, "legacy: control points are written as read" );
+	check( written.find( "<edges left=\"0.1\" top=\"0.2\" right=\"0.142857\" bottom=\"0\"/>" ) != std::string::npos, "legacy: edges are written as read" );
+	check( written.find( "resolution=\"16\" linear=\"1\" adaptive=\"0\"" ) != std::string::npos, "legacy: the mesh settings are read" );
+	check( written.find( "</blend>\n\t\t\t\t<corner x=\"0\" y=\"0\"/>\n\t\t\t\t<corner x=\"0.02\" y=\"0.97\"/>" ) != std::string::npos,
+		"legacy: corners inside <blend> are read" );
+
+	WarpList again = Warp::readSettings( target );
+	check( again.size() == 2 && again[0]->getControlPoint( 2 ) == warps[0]->getControlPoint( 2 ) && again[0]->getEdges() == warps[0]->getEdges()
+		&& again[1]->getLuminance() == warps[1]->getLuminance(), "legacy: written again, the values read back unchanged" );
+}
+
+int main()
+{
+	testFloats();
+	testNumbers();
+	testDocuments();
+	testLegacy();
+
+	std::remove( ofToDataPath( "test-xml.xml" ).c_str() );
+	std::remove( ofToDataPath( "test-xml-2.xml" ).c_str() );
+
+	return finish();
+}
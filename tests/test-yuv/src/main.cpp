@@ -0,0 +1,135 @@
+// Checks the YUV support of the warps on the CPU: WarpYuv::toRgb() against the BT.709 video range conversion in
+// floating point, and WarpRemap::apply() of NV12 and I420 frames against applying the table to the same frame
+// converted to RGBA first. Also checks padded planes, independence of the thread count and apply() before bake().
+//
+// usage: test-yuv
+
+#include "ofMain.h"
+#include "WarpRemap.h"
+#include "WarpYuv.h"
+#include "../../WarpTest.h"
+
+//! a frame in both layouts, with smooth chroma so sampling chroma at full or half resolution agrees closely
+class Frame {
+	public:
+		Frame( int width, int height, int padding )
+			: width( width ), height( height )
+		{
+			int lumaStride = width + padding, chromaStride = width / 2 + padding;
+
+			luma.assign( size_t( lumaStride ) * height, 0 );
+			uv.assign( size_t( chromaStride ) * 2 * ( height / 2 ), 0 );
+			u.assign( size_t( chromaStride ) * ( height / 2 ), 0 );
+			v.assign( u.size(), 0 );
+
+			for( int y = 0; y < height; ++y )
+				for( int x = 0; x < width; ++x )
+					luma[size_t( y ) * lumaStride + x] = (unsigned char)( 16 + ( x * 7 + y * 3 ) % 220 );
+
+			for( int y = 0; y < height / 2; ++y ) {
+				for( int x = 0; x < width / 2; ++x ) {
+					unsigned char cu = (unsigned char)( 64 + x * 128 / width );
+					unsigned char cv = (unsigned char)( 192 - y * 128 / height );
+					uv[size_t( y ) * chromaStride * 2 + x * 2 + 0] = cu;
+					uv[size_t( y ) * chromaStride * 2 + x * 2 + 1] = cv;
+					u[size_t( y ) * chromaStride + x] = cu;
+					v[size_t( y ) * chromaStride + x] = cv;
+				}
+			}
+
+			nv12.format = WarpYuv::NV12;
+			nv12.width = width;
+			nv12.height = height;
+			nv12.data[0] = &luma[0];
+			nv12.data[1] = &uv[0];
+			nv12.stride[0] = lumaStride;
+			nv12.stride[1] = chromaStride * 2;
+
+			i420 = nv12;
+			i420.format = WarpYuv::I420;
+			i420.data[1] = &u[0];
+			i420.data[2] = &v[0];
+			i420.stride[1] = chromaStride;
+			i420.stride[2] = chromaStride;
+		}
+
+		int						width;
+		int						height;
+		vector<unsigned char>	luma, uv, u, v;
+		WarpYuv::Planes			nv12;
+		WarpYuv::Planes			i420;
+};
+
+static bool equals( const ofPixels &a, const ofPixels &b )
+{
+	return a.getWidth() == b.getWidth() && a.getHeight() == b.getHeight() && a.size() == b.size()
+		&& std::equal( a.getData(), a.getData() + a.size(), b.getData() );
+}
+
+static void testConversion()
+{
+	int maxDifference = 0;
+	for( int y = 0; y < 256; y += 3 ) {
+		for( int u = 0; u < 256; u += 5 ) {
+			for( int v = 0; v < 256; v += 7 ) {
+				unsigned char rgb[3];
+				WarpYuv::toRgb( y, u, v, rgb );
+
+				double c = 1.164 * ( y - 16 ), d = u - 128, e = v - 128;
+				double expected[3] = { c + 1.793 * e, c - 0.213 * d - 0.533 * e, c + 2.112 * d };
+				for( int i = 0; i < 3; ++i ) {
+					int value = (int)std::floor( std::min( std::max( expected[i], 0.0 ), 255.0 ) );
+					maxDifference = std::max( maxDifference, std::abs( value - int( rgb[i] ) ) );
+				}
+			}
+		}
+	}
+	check( maxDifference <= 1, "conversion: differs from BT.709 by " + ofToString( maxDifference ) );
+
+	unsigned char black[3], white[3];
+	WarpYuv::toRgb( 16, 128, 128, black );
+	WarpYuv::toRgb( 235, 128, 128, white );
+	check( black[0] == 0 && black[1] == 0 && black[2] == 0, "conversion: video black is black" );
+	check( white[0] == 255 && white[1] == 255 && white[2] == 255, "conversion: video white is white" );
+}
+
+static void testApply()
+{
+	Frame frame( 320, 240, 0 ), padded( 320, 240, 24 );
+	TestWarp<WarpBilinear> warp( 320, 240, 320, 240 );
+
+	WarpRemap remap;
+	ofPixels none;
+	remap.apply( frame.nv12, none );
+	check( none.getWidth() == 0 && none.getHeight() == 0, "apply: apply() before bake() produces no pixels" );
+
+	remap.bake( warp );
+
+	ofPixels nv12, i420, paddedNv12, single, rgba, reference;
+	remap.apply( frame.nv12, nv12 );
+	remap.apply( frame.i420, i420 );
+	remap.apply( padded.nv12, paddedNv12 );
+	remap.apply( frame.nv12, single, 1 );
+
+	check( nv12.getWidth() == 320 && nv12.getHeight() == 240 && nv12.getNumChannels() == 4, "apply: output is RGBA at the size of the table" );
+	check( equals( nv12, i420 ), "apply: NV12 and I420 give the same output" );
+	check( equals( nv12, paddedNv12 ), "apply: padded rows give the same output" );
+	check( equals( nv12, single ), "apply: output does not depend on the number of threads" );
+
+	// the identity samples luma at texel centers, chroma differs by its interpolation only
+	WarpYuv::toRgba( frame.nv12, rgba );
+	remap.apply( rgba, reference );
+
+	int maxDifference = 0;
+	for( size_t i = 0; i < nv12.size() && i < reference.size(); ++i )
+		maxDifference = std::max( maxDifference, std::abs( int( nv12.getData()[i] ) - int( reference.getData()[i] ) ) );
+	check( maxDifference <= 1, "apply: differs from the converted frame by " + ofToString( maxDifference ) );
+}
+
+int main()
+{
+	testConversion();
+	testApply();
+
+	return finish();
+}